@@ -24,7 +24,9 @@ void initialize_types();
 struct token_list* read_all_tokens(FILE* a, struct token_list* current, char* filename);
 struct token_list* reverse_list(struct token_list* head);
 struct token_list* program();
-void recursive_output(struct token_list* i, FILE* out);
+void write_emit_buffer(struct emit_buffer* b, FILE* out);
+void write_function(FILE* out);
+struct emit_buffer* new_emit_buffer(void);
 int match(char* a, char* b);
 char* parse_string(char* string);
 
@@ -49,16 +51,21 @@ int main()
 
 	initialize_types();
 	reset_hold_string();
-	output_list = NULL;
-	program();
+	output_list = new_emit_buffer();
+	globals_list = new_emit_buffer();
+	strings_list = new_emit_buffer();
 
-	/* Output the program we have compiled */
+	/* Functions are streamed out as they are compiled */
 	fputs("\n# Core program\n", destination_file);
-	recursive_output(output_list, destination_file);
+	function_stream = destination_file;
+	program();
+
+	/* Output whatever followed the last function */
+	write_function(destination_file);
 	fputs("\n\n# Program global variables\n", destination_file);
-	recursive_output(globals_list, destination_file);
+	write_emit_buffer(globals_list, destination_file);
 	fputs("\n# Program strings\n", destination_file);
-	recursive_output(strings_list, destination_file);
+	write_emit_buffer(strings_list, destination_file);
 	fputs("\n:STACK\n", destination_file);
 
 	fclose(destination_file);
@@ -33,16 +33,36 @@ void eat_newline_tokens(void);
 void init_macro_env(char* sym, char* value, char* source, int num);
 void preprocess(void);
 void program(void);
-void recursive_output(struct token_list* i, FILE* out);
+void write_emit_buffer(struct emit_buffer* b, FILE* out);
+void write_function(FILE* out);
+void prune_keep(char* name);
+void prune_program(FILE* out);
+void define_forward_calls(void);
+struct emit_buffer* new_emit_buffer(void);
 void output_tokens(struct token_list *i, FILE* out);
 int strtoint(char *a);
+char* int2str(int x, int base, int signed_p);
+
+void print_statistic(char* name, int value)
+{
+	fputs(name, stderr);
+	fputs(int2str(value, 10, TRUE), stderr);
+	fputs("\n", stderr);
+}
 
 int main(int argc, char** argv)
 {
 	MAX_STRING = 4096;
 	BOOTSTRAP_MODE = FALSE;
+	OPTIMIZE = 0;
+	INLINE_LIMIT = 8;
+	PRUNE = FALSE;
+	REGISTER_ARGUMENTS = FALSE;
 	PREPROCESSOR_MODE = FALSE;
 	int DEBUG = FALSE;
+	int STATISTICS = FALSE;
+	int arena_read;
+	int arena_preprocessed;
 	FILE* in = stdin;
 	FILE* destination_file = stdout;
 	Architecture = 0; /* catch unset */
@@ -89,11 +109,12 @@ int main(int argc, char** argv)
 		}
 		else if(match(argv[i], "-o") || match(argv[i], "--output"))
 		{
-			destination_file = fopen(argv[i + 1], "w");
+			destination_name = argv[i + 1];
+			destination_file = fopen(destination_name, "w");
 			if(NULL == destination_file)
 			{
 				fputs("Unable to open for writing file: ", stderr);
-				fputs(argv[i + 1], stderr);
+				fputs(destination_name, stderr);
 				fputs("\n Aborting to avoid problems\n", stderr);
 				exit(EXIT_FAILURE);
 			}
@@ -176,11 +197,59 @@ int main(int argc, char** argv)
 			BOOTSTRAP_MODE = TRUE;
 			i = i + 1;
 		}
+		else if(match(argv[i], "-O0"))
+		{
+			OPTIMIZE = 0;
+			i = i + 1;
+		}
+		else if(match(argv[i], "-O1"))
+		{
+			OPTIMIZE = 1;
+			i = i + 1;
+		}
+		else if(match(argv[i], "--inline-limit"))
+		{
+			hold = argv[i+1];
+			if(NULL == hold)
+			{
+				fputs("--inline-limit requires a numeric argument\n", stderr);
+				exit(EXIT_FAILURE);
+			}
+			INLINE_LIMIT = strtoint(hold);
+			require(0 <= INLINE_LIMIT, "Not a valid inline limit\nAbort and fix your --inline-limit\n");
+			i = i + 2;
+		}
+		else if(match(argv[i], "--prune"))
+		{
+			PRUNE = TRUE;
+			i = i + 1;
+		}
+		else if(match(argv[i], "--register-arguments"))
+		{
+			REGISTER_ARGUMENTS = TRUE;
+			i = i + 1;
+		}
+		else if(match(argv[i], "--keep"))
+		{
+			hold = argv[i+1];
+			if(NULL == hold)
+			{
+				fputs("--keep requires a function or global name\n", stderr);
+				exit(EXIT_FAILURE);
+			}
+			prune_keep(hold);
+			i = i + 2;
+		}
 		else if(match(argv[i], "-g") || match(argv[i], "--debug"))
 		{
 			DEBUG = TRUE;
 			i = i + 1;
 		}
+		else if(match(argv[i], "--statistics"))
+		{
+			STATISTICS = TRUE;
+			i = i + 1;
+		}
 		else if(match(argv[i], "-h") || match(argv[i], "--help"))
 		{
 			fputs(" -f input file\n -o output file\n --help for this message\n --version for file version\n", stdout);
@@ -246,6 +315,7 @@ int main(int argc, char** argv)
 		exit(EXIT_FAILURE);
 	}
 	global_token = reverse_list(global_token);
+	arena_read = arena_used;
 
 	if (BOOTSTRAP_MODE)
 	{
@@ -257,6 +327,7 @@ int main(int argc, char** argv)
 		global_token = remove_line_comments(global_token);
 		preprocess();
 	}
+	arena_preprocessed = arena_used;
 
 	if (PREPROCESSOR_MODE)
 	{
@@ -270,22 +341,44 @@ int main(int argc, char** argv)
 
 	initialize_types();
 	reset_hold_string();
-	output_list = NULL;
-	program();
+	output_list = new_emit_buffer();
+	globals_list = new_emit_buffer();
+	strings_list = new_emit_buffer();
+	defines_list = new_emit_buffer();
 
-	/* Output the program we have compiled */
+	/* Functions are streamed out as they are compiled */
 	fputs("\n# Core program\n", destination_file);
-	recursive_output(output_list, destination_file);
+	function_stream = destination_file;
+	program();
+
+	/* Output whatever followed the last function */
+	write_function(destination_file);
+	if(PRUNE) prune_program(destination_file);
+	define_forward_calls();
 	if(KNIGHT_NATIVE == Architecture) fputs("\n", destination_file);
 	else if(DEBUG) fputs("\n:ELF_data\n", destination_file);
 	fputs("\n# Program global variables\n", destination_file);
-	recursive_output(globals_list, destination_file);
+	write_emit_buffer(globals_list, destination_file);
 	fputs("\n# Program strings\n", destination_file);
-	recursive_output(strings_list, destination_file);
+	write_emit_buffer(strings_list, destination_file);
+	if(0 != defines_list->length)
+	{
+		fputs("\n# Instructions M2libc has no names for\n", destination_file);
+		write_emit_buffer(defines_list, destination_file);
+	}
 	if(KNIGHT_NATIVE == Architecture) fputs("\n:STACK\n", destination_file);
 	else if(!DEBUG) fputs("\n:ELF_end\n", destination_file);
 
 exit_success:
+	if(STATISTICS)
+	{
+		print_statistic("arena bytes reading: ", arena_read);
+		print_statistic("arena bytes preprocessing: ", arena_preprocessed - arena_read);
+		print_statistic("arena bytes compiling: ", arena_used - arena_preprocessed);
+		print_statistic("macro lookups: ", macro_lookups);
+		print_statistic("macro hits: ", macro_hits);
+	}
+
 	if (destination_file != stdout)
 	{
 		fclose(destination_file);
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 // CONSTANT FALSE 0
 #define FALSE 0
@@ -42,12 +43,77 @@
 // CONSTANT RISCV64 8
 #define RISCV64 8
 
+// CONSTANT INTERN_TABLE_SIZE 4096
+#define INTERN_TABLE_SIZE 4096
+// CONSTANT MACRO_TABLE_SIZE 1024
+#define MACRO_TABLE_SIZE 1024
+// CONSTANT SYMBOL_TABLE_SIZE 1024
+#define SYMBOL_TABLE_SIZE 1024
+// CONSTANT TYPE_TABLE_SIZE 256
+#define TYPE_TABLE_SIZE 256
+// CONSTANT MEMBER_INDEX_THRESHOLD 8
+#define MEMBER_INDEX_THRESHOLD 8
+
+/* Token kinds, worked out once by the lexer */
+// CONSTANT TOKEN_IDENTIFIER 1
+#define TOKEN_IDENTIFIER 1
+// CONSTANT TOKEN_KEYWORD 2
+#define TOKEN_KEYWORD 2
+// CONSTANT TOKEN_NUMBER 3
+#define TOKEN_NUMBER 3
+// CONSTANT TOKEN_STRING 4
+#define TOKEN_STRING 4
+// CONSTANT TOKEN_CHAR 5
+#define TOKEN_CHAR 5
+// CONSTANT TOKEN_PUNCTUATOR 6
+#define TOKEN_PUNCTUATOR 6
+// CONSTANT TOKEN_LABEL 7
+#define TOKEN_LABEL 7
+// CONSTANT TOKEN_NEWLINE 8
+#define TOKEN_NEWLINE 8
+// CONSTANT TOKEN_DIRECTIVE 9
+#define TOKEN_DIRECTIVE 9
+
+/* Intermediate representation node kinds */
+// CONSTANT IR_TEXT 1
+#define IR_TEXT 1
+// CONSTANT IR_LABEL 2
+#define IR_LABEL 2
+// CONSTANT IR_JUMP 3
+#define IR_JUMP 3
+// CONSTANT IR_PUSH 4
+#define IR_PUSH 4
+// CONSTANT IR_POP 5
+#define IR_POP 5
+// CONSTANT IR_CONSTANT 6
+#define IR_CONSTANT 6
+// CONSTANT IR_CALL 7
+#define IR_CALL 7
+// CONSTANT IR_COMPARE 8
+#define IR_COMPARE 8
+
+/* What is known about a function, kept in the depth of its symbol */
+// CONSTANT FUNCTION_REGISTERS 1
+#define FUNCTION_REGISTERS 1
+// CONSTANT FUNCTION_PLACED 2
+#define FUNCTION_PLACED 2
+// CONSTANT FUNCTION_HAS_LOCALS 4
+#define FUNCTION_HAS_LOCALS 4
+// CONSTANT FUNCTION_EMPTY_FRAME 8
+#define FUNCTION_EMPTY_FRAME 8
+// CONSTANT FUNCTION_INLINE 16
+#define FUNCTION_INLINE 16
+
 
 void copy_string(char* target, char* source, int max);
 int in_set(int c, char* s);
 int match(char* a, char* b);
 void require(int bool, char* error);
 void reset_hold_string(void);
+void* arena_alloc(int size);
+char* intern(char* s);
+int hash_string(char* s);
+int classify_token(char* s);
 
 
 struct type
@@ -73,6 +139,30 @@ struct token_list
 	struct token_list* arguments;
 	int depth;
 	int linenumber;
+	int kind;
+};
+
+/* Generated output, appended to in place and written out in one go */
+struct emit_buffer
+{
+	char* data;
+	int length;
+	int size;
+	int last; /* where the most recent emit started */
+};
+
+/* One node of a function's intermediate representation */
+struct ir_node
+{
+	struct ir_node* next;
+	struct ir_node* prev;
+	int op;
+	char* s; /* label or constant */
+	int start; /* IR_TEXT and IR_COMPARE are output_list->data[start] up to end */
+	int end;
+	int split; /* IR_JUMP label was written on a line of its own, IR_COMPARE is signed */
+	struct ir_node* partner; /* IR_PUSH and IR_POP of the same temporary */
+	int reg; /* scratch register holding the temporary, 0 for the stack */
 };
 
 struct case_list
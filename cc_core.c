@@ -27,6 +27,20 @@ struct token_list* global_symbol_list;
 struct token_list* global_function_list;
 struct token_list* global_constant_list;
 
+/* Hashed index over the symbol lists, each bucket is newest first */
+struct sym_index
+{
+	struct sym_index* next;
+	struct token_list* symbol;
+};
+
+struct sym_index** global_symbol_table;
+struct sym_index** global_function_table;
+struct sym_index** global_constant_table;
+
+/* Arguments and locals of the current function; locals shadow arguments */
+struct sym_index** scope_table;
+
 /* Core lists for this file */
 struct token_list* function;
 
@@ -40,6 +54,28 @@ struct token_list* break_frame;
 int current_count;
 int Address_of;
 
+/* inline in front of the function being declared, and whether a call is
+ * being expanded in place right now (expansions do not nest) */
+int inline_keyword;
+int inlining;
+struct sym_index** inline_scope;
+
+/* Interned spellings of the statement keywords, tokens are compared by pointer */
+char* keyword_struct;
+char* keyword_if;
+char* keyword_else;
+char* keyword_switch;
+char* keyword_case;
+char* keyword_default;
+char* keyword_do;
+char* keyword_while;
+char* keyword_for;
+char* keyword_asm;
+char* keyword_goto;
+char* keyword_return;
+char* keyword_break;
+char* keyword_continue;
+
 /* Imported functions */
 char* int2str(int x, int base, int signed_p);
 int strtoint(char *a);
@@ -50,47 +86,267 @@ struct token_list* reverse_list(struct token_list* head);
 struct type* mirror_type(struct type* source, char* name);
 struct type* add_primitive(struct type* a);
 
-struct token_list* emit(char *s, struct token_list* head)
+struct emit_buffer* new_emit_buffer(void)
+{
+	struct emit_buffer* b = calloc(1, sizeof(struct emit_buffer));
+	require(NULL != b, "Exhausted memory while creating an output buffer\n");
+	b->size = 65536;
+	b->data = calloc(b->size, sizeof(char));
+	require(NULL != b->data, "Exhausted memory while creating an output buffer\n");
+	return b;
+}
+
+void emit(char *s, struct emit_buffer* b)
+{
+	char* hold;
+	int i = 0;
+	b->last = b->length;
+	while(0 != s[i])
+	{
+		/* Always keep a trailing NUL so the buffer can be written with fputs */
+		if((b->length + 1) == b->size)
+		{
+			b->size = b->size << 1;
+			hold = calloc(b->size, sizeof(char));
+			require(NULL != hold, "Exhausted memory while growing an output buffer\n");
+			copy_string(hold, b->data, b->length);
+			free(b->data);
+			b->data = hold;
+		}
+		b->data[b->length] = s[i];
+		b->length = b->length + 1;
+		i = i + 1;
+	}
+	b->data[b->length] = 0;
+}
+
+/* Write out everything emitted so far and reuse the storage */
+void write_emit_buffer(struct emit_buffer* b, FILE* out)
+{
+	fputs(b->data, out);
+	b->length = 0;
+	b->last = 0;
+	b->data[0] = 0;
+}
+
+/* Was s the most recent thing emitted into b */
+int last_emitted(struct emit_buffer* b, char* s)
 {
-	struct token_list* t = calloc(1, sizeof(struct token_list));
-	require(NULL != t, "Exhausted memory while generating token to emit\n");
-	t->next = head;
-	t->s = s;
-	return t;
+	return match(s, b->data + b->last);
 }
 
 void emit_out(char* s)
 {
-	output_list = emit(s, output_list);
+	emit(s, output_list);
 }
 
-struct token_list* uniqueID(char* s, struct token_list* l, char* num)
+void uniqueID(char* s, struct emit_buffer* b, char* num)
 {
-	l = emit("\n", emit(num, emit("_", emit(s, l))));
-	return l;
+	emit(s, b);
+	emit("_", b);
+	emit(num, b);
+	emit("\n", b);
 }
 
 void uniqueID_out(char* s, char* num)
 {
-	output_list = uniqueID(s, output_list, num);
+	uniqueID(s, output_list, num);
+}
+
+/*
+ * A function is collected as a list of ir_nodes before it is written out.
+ * Jumps, labels, the expression stack pushes and pops and numeric constants
+ * are nodes of their own so later passes can reason about them; everything
+ * else stays text in output_list and is referred to by range.  lower_ir
+ * turns the list back into M1 for the target architecture.
+ */
+struct ir_node* ir_head;
+struct ir_node* ir_tail;
+struct ir_node* ir_free;
+int ir_mark;
+
+struct ir_node* ir_new(int op)
+{
+	struct ir_node* n = ir_free;
+	if(NULL == n) n = arena_alloc(sizeof(struct ir_node));
+	else ir_free = n->next;
+	n->next = NULL;
+	n->prev = ir_tail;
+	n->op = op;
+	n->s = NULL;
+	n->split = FALSE;
+	n->partner = NULL;
+	n->reg = 0;
+	if(NULL == ir_head) ir_head = n;
+	else ir_tail->next = n;
+	ir_tail = n;
+	return n;
+}
+
+/* Whatever was emitted since the last node, up to end, becomes a text node */
+void ir_text_to(int end)
+{
+	if(ir_mark == end) return;
+	struct ir_node* n = ir_new(IR_TEXT);
+	n->start = ir_mark;
+	n->end = end;
+	ir_mark = end;
+}
+
+void ir_text(void)
+{
+	ir_text_to(output_list->length);
+}
+
+struct ir_node* ir_append(int op, char* s)
+{
+	ir_text();
+	struct ir_node* n = ir_new(op);
+	n->s = s;
+	/* Nodes are not text, last_emitted must not see what came before them */
+	output_list->last = output_list->length;
+	return n;
+}
+
+void ir_label(char* s)
+{
+	ir_append(IR_LABEL, s);
+}
+
+void ir_jump(char* s, int split)
+{
+	struct ir_node* n = ir_append(IR_JUMP, s);
+	n->split = split;
+}
+
+/* The last node so far, with everything emitted before it turned into nodes */
+struct ir_node* ir_position(void)
+{
+	ir_text();
+	return ir_tail;
+}
+
+/* Take the nodes collected after mark off the end of the list */
+struct ir_node* ir_cut(struct ir_node* mark)
+{
+	ir_text();
+	struct ir_node* head = ir_head;
+	if(NULL != mark) head = mark->next;
+	ir_tail = mark;
+	if(NULL == mark) ir_head = NULL;
+	else mark->next = NULL;
+	output_list->last = output_list->length;
+	return head;
+}
+
+/* Put nodes taken off by ir_cut back at the end of the list */
+void ir_paste(struct ir_node* head)
+{
+	ir_text();
+	if(NULL == head) return;
+	head->prev = ir_tail;
+	if(NULL == ir_tail) ir_head = head;
+	else ir_tail->next = head;
+	while(NULL != head->next) head = head->next;
+	ir_tail = head;
+	output_list->last = output_list->length;
+}
+
+int append_string(char* target, int i, char* s)
+{
+	int j = 0;
+	while(0 != s[j])
+	{
+		target[i] = s[j];
+		i = i + 1;
+		j = j + 1;
+	}
+	return i;
+}
+
+int string_length(char* s)
+{
+	int i = 0;
+	while(0 != s[i]) i = i + 1;
+	return i;
+}
+
+/* The label uniqueID writes for head, func and num */
+char* label_name(char* head, char* func, char* num)
+{
+	char* s = arena_alloc(string_length(head) + string_length(func) + string_length(num) + 2);
+	int i = append_string(s, 0, head);
+	i = append_string(s, i, func);
+	i = append_string(s, i, "_");
+	append_string(s, i, num);
+	return s;
 }
 
 struct token_list* sym_declare(char *s, struct type* t, struct token_list* list)
 {
-	struct token_list* a = calloc(1, sizeof(struct token_list));
-	require(NULL != a, "Exhausted memory while attempting to declare a symbol\n");
+	struct token_list* a = arena_alloc(sizeof(struct token_list));
 	a->next = list;
 	a->s = s;
 	a->type = t;
 	return a;
 }
 
-struct token_list* sym_lookup(char *s, struct token_list* symbol_list)
+struct sym_index** new_sym_table(void)
 {
-	struct token_list* i;
-	for(i = symbol_list; NULL != i; i = i->next)
+	struct sym_index** r = calloc(SYMBOL_TABLE_SIZE, sizeof(struct sym_index*));
+	require(NULL != r, "Exhausted memory while creating a symbol table\n");
+	return r;
+}
+
+void sym_index(struct sym_index** table, struct token_list* a)
+{
+	int h = hash_string(a->s) & (SYMBOL_TABLE_SIZE - 1);
+	struct sym_index* i = arena_alloc(sizeof(struct sym_index));
+	i->symbol = a;
+	i->next = table[h];
+	table[h] = i;
+}
+
+void sym_unindex(struct sym_index** table, struct token_list* a)
+{
+	int h = hash_string(a->s) & (SYMBOL_TABLE_SIZE - 1);
+	struct sym_index* i = table[h];
+	if(NULL == i) return;
+
+	if(a == i->symbol)
+	{
+		table[h] = i->next;
+		return;
+	}
+
+	while(NULL != i->next)
+	{
+		if(a == i->next->symbol)
+		{
+			i->next = i->next->next;
+			return;
+		}
+		i = i->next;
+	}
+}
+
+/* Drop every symbol from head up to (but not including) stop */
+void sym_unindex_list(struct sym_index** table, struct token_list* head, struct token_list* stop)
+{
+	while(stop != head)
+	{
+		sym_unindex(table, head);
+		head = head->next;
+	}
+}
+
+struct token_list* sym_lookup(char *s, struct sym_index** table)
+{
+	struct sym_index* i;
+	for(i = table[hash_string(s) & (SYMBOL_TABLE_SIZE - 1)]; NULL != i; i = i->next)
 	{
-		if(match(i->s, s)) return i;
+		/* Symbol names always come from interned tokens */
+		if(i->symbol->s == s) return i->symbol;
 	}
 	return NULL;
 }
@@ -114,6 +370,17 @@ void line_error(void)
 	line_error_token(global_token);
 }
 
+/* Functions are streamed out as they compile, so don't leave half a program behind */
+void compile_failure(void)
+{
+	if((NULL != function_stream) && (NULL != destination_name))
+	{
+		fclose(function_stream);
+		unlink(destination_name);
+	}
+	exit(EXIT_FAILURE);
+}
+
 void require_match(char* message, char* required)
 {
 	if(NULL == global_token)
@@ -122,13 +389,13 @@ void require_match(char* message, char* required)
 		fputs("EOF reached inside of require match\n", stderr);
 		fputs("problem at end of file\n", stderr);
 		fputs(message, stderr);
-		exit(EXIT_FAILURE);
+		compile_failure();
 	}
 	if(!match(global_token->s, required))
 	{
 		line_error();
 		fputs(message, stderr);
-		exit(EXIT_FAILURE);
+		compile_failure();
 	}
 	global_token = global_token->next;
 }
@@ -140,2711 +407,5312 @@ void maybe_bootstrap_error(char* feature)
 		line_error();
 		fputs(feature, stderr);
 		fputs(" is not supported in --bootstrap-mode\n", stderr);
-		exit(EXIT_FAILURE);
+		compile_failure();
 	}
 }
 
-void expression(void);
-void function_call(char* s, int bool)
+/*
+ * Under -O1 a few instructions have no name in M2libc's definitions.  They
+ * are named here instead, with an O1_ prefix so they cannot clash with
+ * M2libc's own, and the DEFINE for each name used goes out with the program.
+ */
+struct token_list* o1_names;
+
+/* a followed by b */
+char* concat(char* a, char* b)
 {
-	require_match("ERROR in process_expression_list\nNo ( was found\n", "(");
-	require(NULL != global_token, "Improper function call\n");
-	int passed = 0;
+	char* s = arena_alloc(string_length(a) + string_length(b) + 1);
+	append_string(s, append_string(s, 0, a), b);
+	return s;
+}
 
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-	{
-		emit_out("PUSHR R13 R15\t# Prevent overwriting in recursion\n");
-		emit_out("PUSHR R14 R15\t# Protect the old base pointer\n");
-		emit_out("COPY R13 R15\t# Copy new base pointer\n");
-	}
-	else if(X86 == Architecture)
-	{
-		emit_out("push_edi\t# Prevent overwriting in recursion\n");
-		emit_out("push_ebp\t# Protect the old base pointer\n");
-		emit_out("mov_edi,esp\t# Copy new base pointer\n");
-	}
-	else if(AMD64 == Architecture)
-	{
-		emit_out("push_rdi\t# Prevent overwriting in recursion\n");
-		emit_out("push_rbp\t# Protect the old base pointer\n");
-		emit_out("mov_rdi,rsp\t# Copy new base pointer\n");
-	}
-	else if(ARMV7L == Architecture)
-	{
-		emit_out("{R11} PUSH_ALWAYS\t# Prevent overwriting in recursion\n");
-		emit_out("{BP} PUSH_ALWAYS\t# Protect the old base pointer\n");
-		emit_out("'0' SP R11 NO_SHIFT MOVE_ALWAYS\t# Copy new base pointer\n");
-	}
-	else if(AARCH64 == Architecture)
+/* The count low bytes of value in hex, least significant first */
+char* hex_bytes(int value, int count)
+{
+	char* digits = "0123456789ABCDEF";
+	char* s = arena_alloc((count << 1) + 1);
+	int i = 0;
+	while(0 < count)
 	{
-		emit_out("PUSH_X16\t# Protect a tmp register we're going to use\n");
-		emit_out("PUSH_LR\t# Protect the old return pointer (link)\n");
-		emit_out("PUSH_BP\t# Protect the old base pointer\n");
-		emit_out("SET_X16_FROM_SP\t# The base pointer to-be\n");
+		s[i] = digits[(value >> 4) & 0xF];
+		s[i + 1] = digits[value & 0xF];
+		value = value >> 8;
+		i = i + 2;
+		count = count - 1;
 	}
-	else if(RISCV32 == Architecture)
+	return s;
+}
+
+/* Give the instruction hex the name name, writing its DEFINE the first time */
+char* o1_define(char* name, char* hex)
+{
+	struct token_list* i;
+	for(i = o1_names; NULL != i; i = i->next)
 	{
-		emit_out("rd_sp rs1_sp !-12 addi\t# Allocate stack\n");
-		emit_out("rs1_sp rs2_ra @4 sw\t# Protect the old return pointer\n");
-		emit_out("rs1_sp rs2_fp sw\t# Protect the old frame pointer\n");
-		emit_out("rs1_sp rs2_tp @8 sw\t# Protect temp register we are going to use\n");
-		emit_out("rd_tp rs1_sp mv\t# The base pointer to-be\n");
+		if(match(i->s, name)) return name;
 	}
-	else if(RISCV64 == Architecture)
+	o1_names = sym_declare(name, NULL, o1_names);
+	emit("DEFINE ", defines_list);
+	emit(name, defines_list);
+	emit(" ", defines_list);
+	emit(hex, defines_list);
+	emit("\n", defines_list);
+	return name;
+}
+
+/* An aarch64 instruction with the immediate n, named head_n */
+char* o1_word(char* head, int n, int word)
+{
+	return o1_define(concat(concat(head, "_"), int2str(n, 10, TRUE)), hex_bytes(word, 4));
+}
+
+/* The end of an aarch64 BL backwards, ^~ having filled in imm26 below the sign bits */
+char* bl_backwards(void)
+{
+	o1_define("O1_BL_BACK", "97");
+	return " O1_BL_BACK\n";
+}
+
+/* Functions called with a BL before their body was compiled */
+struct token_list* forward_calls;
+
+/* The end of an aarch64 BL to the function s, not compiled yet: which way it
+ * goes is only known once the whole input is read, so the top byte is named
+ * after the function and define_forward_calls writes its DEFINE */
+char* bl_forward(char* s)
+{
+	struct token_list* i;
+	for(i = forward_calls; NULL != i; i = i->next)
 	{
-		emit_out("rd_sp rs1_sp !-24 addi\t# Allocate stack\n");
-		emit_out("rs1_sp rs2_ra @8 sd\t# Protect the old return pointer\n");
-		emit_out("rs1_sp rs2_fp sd\t# Protect the old frame pointer\n");
-		emit_out("rs1_sp rs2_tp @16 sd\t# Protect temp register we are going to use\n");
-		emit_out("rd_tp rs1_sp mv\t# The base pointer to-be\n");
+		if(match(i->s, s)) break;
 	}
+	if(NULL == i) forward_calls = sym_declare(s, NULL, forward_calls);
+	return concat(concat(" O1_BL_TO_", s), "\n");
+}
 
-	if(global_token->s[0] != ')')
+int function_emitted(char* s);
+/* A function compiled after the call lies ahead of it.  One never compiled
+ * is hand written M1, which goes to M1 ahead of the program (as M2libc's
+ * start up code does), so it lies behind. */
+void define_forward_calls(void)
+{
+	struct token_list* i;
+	for(i = forward_calls; NULL != i; i = i->next)
 	{
-		expression();
-		require(NULL != global_token, "incomplete function call, received EOF instead of )\n");
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("PUSHR R0 R15\t#_process_expression1\n");
-		else if(X86 == Architecture) emit_out("push_eax\t#_process_expression1\n");
-		else if(AMD64 == Architecture) emit_out("push_rax\t#_process_expression1\n");
-		else if(ARMV7L == Architecture) emit_out("{R0} PUSH_ALWAYS\t#_process_expression1\n");
-		else if(AARCH64 == Architecture) emit_out("PUSH_X0\t#_process_expression1\n");
-		else if(RISCV32 == Architecture) emit_out("rd_sp rs1_sp !-4 addi\nrs1_sp rs2_a0 sw\t#_process_expression1\n");
-		else if(RISCV64 == Architecture) emit_out("rd_sp rs1_sp !-8 addi\nrs1_sp rs2_a0 sd\t#_process_expression1\n");
-		passed = 1;
-
-		while(global_token->s[0] == ',')
-		{
-			global_token = global_token->next;
-			require(NULL != global_token, "incomplete function call, received EOF instead of argument\n");
-			expression();
-			if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("PUSHR R0 R15\t#_process_expression2\n");
-			else if(X86 == Architecture) emit_out("push_eax\t#_process_expression2\n");
-			else if(AMD64 == Architecture) emit_out("push_rax\t#_process_expression2\n");
-			else if(ARMV7L == Architecture) emit_out("{R0} PUSH_ALWAYS\t#_process_expression2\n");
-			else if(AARCH64 == Architecture) emit_out("PUSH_X0\t#_process_expression2\n");
-			else if(RISCV32 == Architecture) emit_out("rd_sp rs1_sp !-4 addi\nrs1_sp rs2_a0 sw\t#_process_expression2\n");
-			else if(RISCV64 == Architecture) emit_out("rd_sp rs1_sp !-8 addi\nrs1_sp rs2_a0 sd\t#_process_expression2\n");
-			passed = passed + 1;
-		}
+		if(function_emitted(i->s)) o1_define(concat("O1_BL_TO_", i->s), "94");
+		else o1_define(concat("O1_BL_TO_", i->s), "97");
 	}
+}
 
-	require_match("ERROR in process_expression_list\nNo ) was found\n", ")");
-
-	if(TRUE == bool)
+/*
+ * Move the stack pointer by n bytes in a single step (or a few for large n on
+ * targets with short immediates), dropping them when n is positive and
+ * reserving them when it is negative.  Knight stacks grow upwards.
+ */
+void stack_adjust(int n)
+{
+	int step;
+	while(0 != n)
 	{
+		step = n;
 		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 		{
-			emit_out("LOAD R0 R14 ");
-			emit_out(s);
-			emit_out("\nMOVE R14 R13\n");
-			emit_out("CALL R0 R15\n");
-		}
-		else if(X86 == Architecture)
-		{
-			emit_out("lea_eax,[ebp+DWORD] %");
-			emit_out(s);
-			emit_out("\nmov_eax,[eax]\n");
-			emit_out("mov_ebp,edi\n");
-			emit_out("call_eax\n");
+			if(32760 < step) step = 32760;
+			else if(-32760 > step) step = -32760;
+			emit_out("ADDI R15 R15 ");
+			emit_out(int2str(-step, 10, TRUE));
+			emit_out("\n");
 		}
-		else if(AMD64 == Architecture)
+		else if((X86 == Architecture) || (AMD64 == Architecture))
 		{
-			emit_out("lea_rax,[rbp+DWORD] %");
-			emit_out(s);
-			emit_out("\nmov_rax,[rax]\n");
-			emit_out("mov_rbp,rdi\n");
-			emit_out("call_rax\n");
+			if((X86 == Architecture) && (0 < step)) emit_out(o1_define("O1_add_esp,", "81C4"));
+			else if(X86 == Architecture) emit_out(o1_define("O1_sub_esp,", "81EC"));
+			else if(0 < step) emit_out(o1_define("O1_add_rsp,", "4881C4"));
+			else emit_out(o1_define("O1_sub_rsp,", "4881EC"));
+			emit_out(" %");
+			if(0 < step) emit_out(int2str(step, 10, TRUE));
+			else emit_out(int2str(-step, 10, TRUE));
+			emit_out("\n");
 		}
 		else if(ARMV7L == Architecture)
 		{
+			/* add/sub sp, sp, #imm8 */
+			if(252 < step) step = 252;
+			else if(-252 > step) step = -252;
 			emit_out("!");
-			emit_out(s);
-			emit_out(" R0 SUB BP ARITH_ALWAYS\n");
-			emit_out("!0 R0 LOAD32 R0 MEMORY\n");
-			emit_out("{LR} PUSH_ALWAYS\t# Protect the old link register\n");
-			emit_out("'0' R11 BP NO_SHIFT MOVE_ALWAYS\n");
-			emit_out("'3' R0 CALL_REG_ALWAYS\n");
-			emit_out("{LR} POP_ALWAYS\t# Prevent overwrite\n");
+			if(0 < step) emit_out(int2str(step, 10, TRUE));
+			else emit_out(int2str(-step, 10, TRUE));
+			if(0 < step) emit_out(" SP ADD SP ARITH_ALWAYS\n");
+			else emit_out(" SP SUB SP ARITH_ALWAYS\n");
 		}
 		else if(AARCH64 == Architecture)
 		{
-			emit_out("SET_X0_FROM_BP\n");
-			emit_out("LOAD_W1_AHEAD\nSKIP_32_DATA\n%");
-			emit_out(s);
-			emit_out("\nSUB_X0_X0_X1\n");
-			emit_out("DEREF_X0\n");
-			emit_out("SET_BP_FROM_X16\n");
-			emit_out("SET_X16_FROM_X0\n");
-			emit_out("BLR_X16\n");
-		}
-		else if(RISCV32 == Architecture)
-		{
-			emit_out("rd_a0 rs1_fp !");
-			emit_out(s);
-			emit_out(" addi\n");
-			emit_out("rd_a0 rs1_a0 lw\n");
-			emit_out("rd_fp rs1_tp mv\n");
-			emit_out("rd_ra rs1_a0 jalr\n");
+			if(4088 < step) step = 4088;
+			else if(-4088 > step) step = -4088;
+			/* x18 is our stack pointer */
+			if(0 < step) emit_out(o1_word("O1_ADD_X18_X18", step, 0x91000252 + (step << 10)));
+			else emit_out(o1_word("O1_SUB_X18_X18", -step, 0xD1000252 + ((-step) << 10)));
+			emit_out("\n");
 		}
-		else if(RISCV64 == Architecture)
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
 		{
-			emit_out("rd_a0 rs1_fp !");
-			emit_out(s);
+			if(2040 < step) step = 2040;
+			else if(-2040 > step) step = -2040;
+			emit_out("rd_sp rs1_sp !");
+			emit_out(int2str(step, 10, TRUE));
 			emit_out(" addi\n");
-			emit_out("rd_a0 rs1_a0 ld\n");
-			emit_out("rd_fp rs1_tp mv\n");
-			emit_out("rd_ra rs1_a0 jalr\n");
 		}
+		n = n - step;
 	}
-	else
+}
+
+/* Drop words register sized words off the stack, note says what they were.
+ * Under -O1 even a single word is not popped into the secondary register:
+ * the peephole pass would take the pop for the end of an expression
+ * temporary and turn the push of a new local and a load of it into a move */
+void release_stack(int words, char* note)
+{
+	if(OPTIMIZE && (0 < words))
 	{
-		if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture))
-		{
-			emit_out("MOVE R14 R13\n");
-			emit_out("LOADR R0 4\nJUMP 4\n&FUNCTION_");
-			emit_out(s);
-			emit_out("\nCALL R0 R15\n");
-		}
-		else if(X86 == Architecture)
-		{
-			emit_out("mov_ebp,edi\n");
-			emit_out("call %FUNCTION_");
-			emit_out(s);
-			emit_out("\n");
-		}
-		else if(AMD64 == Architecture)
-		{
-			emit_out("mov_rbp,rdi\n");
-			emit_out("call %FUNCTION_");
-			emit_out(s);
-			emit_out("\n");
-		}
-		else if(ARMV7L == Architecture)
+		stack_adjust(words * register_size);
+		return;
+	}
+
+	while(0 < words)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("POPR R1 R15\t# ");
+		else if(X86 == Architecture) emit_out("pop_ebx\t# ");
+		else if(AMD64 == Architecture) emit_out("pop_rbx\t# ");
+		else if(ARMV7L == Architecture) emit_out("{R1} POP_ALWAYS\t# ");
+		else if(AARCH64 == Architecture) emit_out("POP_X1\t# ");
+		else if(RISCV32 == Architecture) emit_out("rd_a1 rs1_sp lw\t# ");
+		else if(RISCV64 == Architecture) emit_out("rd_a1 rs1_sp ld\t# ");
+		emit_out(note);
+		emit_out("\n");
+		if(RISCV32 == Architecture) emit_out("rd_sp rs1_sp !4 addi\n");
+		else if(RISCV64 == Architecture) emit_out("rd_sp rs1_sp !8 addi\n");
+		words = words - 1;
+	}
+}
+
+/*
+ * Argument registers for --register-arguments: rdi, rsi, rdx, rcx, r8 and
+ * r9 on amd64, x0 to x7 on aarch64 and a0 to a7 on riscv.  A function that
+ * takes between one and that many arguments gets a second entry,
+ * REGISTERS_name, which pushes them to the slots a stack call would have
+ * put them in and falls into FUNCTION_name, so the body is the same for
+ * both ways of calling it.
+ */
+char** argument_push;
+char** argument_pop;
+char** argument_move;
+
+/* Calls whose frame waits in rdi while their arguments are evaluated, and
+ * whether the function being compiled made a register call, which leaves
+ * rdi changed (amd64 only) */
+int frames_pending;
+int register_calls;
+
+int argument_count(void)
+{
+	if(!REGISTER_ARGUMENTS) return 0;
+	if(AMD64 == Architecture) return 6;
+	else if(AARCH64 == Architecture) return 8;
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return 8;
+	return 0;
+}
+
+void init_argument_registers(void)
+{
+	int count = argument_count();
+	argument_push = calloc(count + 1, sizeof(char*));
+	argument_pop = calloc(count + 1, sizeof(char*));
+	argument_move = calloc(count + 1, sizeof(char*));
+	require((NULL != argument_push) && (NULL != argument_pop) && (NULL != argument_move), "Exhausted memory while setting up argument registers\n");
+
+	int k;
+	int r;
+	char* name;
+	for(k = 0; k < count; k = k + 1)
+	{
+		if(AMD64 == Architecture)
 		{
-			emit_out("{LR} PUSH_ALWAYS\t# Protect the old link register\n");
-			emit_out("'0' R11 BP NO_SHIFT MOVE_ALWAYS\n");
-			emit_out("^~FUNCTION_");
-			emit_out(s);
-			emit_out(" CALL_ALWAYS\n");
-			emit_out("{LR} POP_ALWAYS\t# Restore the old link register\n");
+			if(0 == k) r = 7;
+			else if(1 == k) r = 6;
+			else if(2 == k) r = 2;
+			else if(3 == k) r = 1;
+			else r = k + 4;
+
+			/* push r, pop r and mov r, rax */
+			if(8 > r)
+			{
+				if(7 == r) name = "rdi";
+				else if(6 == r) name = "rsi";
+				else if(2 == r) name = "rdx";
+				else name = "rcx";
+				argument_push[k] = o1_define(concat("O1_push_", name), hex_bytes(0x50 + r, 1));
+				argument_pop[k] = o1_define(concat("O1_pop_", name), hex_bytes(0x58 + r, 1));
+				argument_move[k] = o1_define(concat(concat("O1_mov_", name), ",rax"), hex_bytes(0xC08948 + (r << 16), 3));
+			}
+			else
+			{
+				name = concat("r", int2str(r, 10, TRUE));
+				argument_push[k] = o1_define(concat("O1_push_", name), hex_bytes(0x5041 + ((r - 8) << 8), 2));
+				argument_pop[k] = o1_define(concat("O1_pop_", name), hex_bytes(0x5841 + ((r - 8) << 8), 2));
+				argument_move[k] = o1_define(concat(concat("O1_mov_", name), ",rax"), hex_bytes(0xC08949 + ((r - 8) << 16), 3));
+			}
 		}
 		else if(AARCH64 == Architecture)
 		{
-			emit_out("SET_BP_FROM_X16\n");
-			emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&FUNCTION_");
-			emit_out(s);
-			emit_out("\n");
-			emit_out("BLR_X16\n");
+			/* str xk, [x18, #-8]!, ldr xk, [x18], #8 and orr xk, xzr, x0 */
+			name = int2str(k, 10, TRUE);
+			argument_push[k] = o1_define(concat("O1_PUSH_X", name), hex_bytes(0xF81F8E40 + k, 4));
+			argument_pop[k] = o1_define(concat("O1_POP_X", name), hex_bytes(0xF8408640 + k, 4));
+			argument_move[k] = o1_define(concat(concat("O1_SET_X", name), "_FROM_X0"), hex_bytes(0xAA0003E0 + k, 4));
 		}
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+		else
 		{
-			emit_out("rd_fp rs1_tp mv\n");
-			emit_out("rd_ra $FUNCTION_");
-			emit_out(s);
-			emit_out(" jal\n");
+			/* The pops are followed by the stack pointer adjustment */
+			name = concat("a", int2str(k, 10, TRUE));
+			if(RISCV32 == Architecture)
+			{
+				argument_push[k] = concat(concat("rd_sp rs1_sp !-4 addi\nrs1_sp rs2_", name), " sw");
+				argument_pop[k] = concat(concat("rd_", name), " rs1_sp lw");
+			}
+			else
+			{
+				argument_push[k] = concat(concat("rd_sp rs1_sp !-8 addi\nrs1_sp rs2_", name), " sd");
+				argument_pop[k] = concat(concat("rd_", name), " rs1_sp ld");
+			}
+			argument_move[k] = concat(concat("rd_", name), " rs1_a0 mv");
 		}
 	}
+}
 
-	for(; passed > 0; passed = passed - 1)
-	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("POPR R1 R15\t# _process_expression_locals\n");
-		else if(X86 == Architecture) emit_out("pop_ebx\t# _process_expression_locals\n");
-		else if(AMD64 == Architecture) emit_out("pop_rbx\t# _process_expression_locals\n");
-		else if(ARMV7L == Architecture) emit_out("{R1} POP_ALWAYS\t# _process_expression_locals\n");
-		else if(AARCH64 == Architecture) emit_out("POP_X1\t# _process_expression_locals\n");
-		else if(RISCV32 == Architecture) emit_out("rd_a1 rs1_sp lw\t# _process_expression_locals\nrd_sp rs1_sp !4 addi\n");
-		else if(RISCV64 == Architecture) emit_out("rd_a1 rs1_sp ld\t# _process_expression_locals\nrd_sp rs1_sp !8 addi\n");
-	}
+/* Emit the pop of the top of the stack into argument register k */
+void argument_pop_out(int k)
+{
+	emit_out(argument_pop[k]);
+	emit_out("\n");
+	if(RISCV32 == Architecture) emit_out("rd_sp rs1_sp !4 addi\n");
+	else if(RISCV64 == Architecture) emit_out("rd_sp rs1_sp !8 addi\n");
+}
 
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-	{
-		emit_out("POPR R14 R15\t# Restore old base pointer\n");
-		emit_out("POPR R13 R15\t# Prevent overwrite\n");
-	}
-	else if(X86 == Architecture)
-	{
-		emit_out("pop_ebp\t# Restore old base pointer\n");
-		emit_out("pop_edi\t# Prevent overwrite\n");
-	}
-	else if(AMD64 == Architecture)
-	{
-		emit_out("pop_rbp\t# Restore old base pointer\n");
-		emit_out("pop_rdi\t# Prevent overwrite\n");
-	}
-	else if(ARMV7L == Architecture)
+/* The entry taking the arguments of the function being defined in
+ * registers, dropping through into its FUNCTION_ label */
+void register_entry(int count)
+{
+	int k;
+	if(NULL == argument_pop) init_argument_registers();
+	emit_out(":REGISTERS_");
+	emit_out(function->s);
+	emit_out("\n");
+	if(AMD64 == Architecture)
 	{
-		emit_out("{BP} POP_ALWAYS\t# Restore old base pointer\n");
-		emit_out("{R11} POP_ALWAYS\t# Prevent overwrite\n");
+		/* The return address goes back on top of the arguments, as a stack call leaves it */
+		emit_out(o1_define("O1_pop_r11", "415B"));
+		emit_out("\n");
+		emit_out(o1_define("O1_mov_rbp,rsp", "4889E5"));
+		emit_out("\n");
 	}
 	else if(AARCH64 == Architecture)
 	{
-		emit_out("POP_BP\t# Restore the old base pointer\n");
-		emit_out("POP_LR\t# Restore the old return pointer (link)\n");
-		emit_out("POP_X16\t# Restore a register we used as tmp\n");
+		emit_out(o1_define("O1_SET_BP_FROM_SP", "F10312AA"));
+		emit_out("\n");
 	}
-	else if(RISCV32 == Architecture)
+	else emit_out("rd_fp rs1_sp mv\n");
+
+	for(k = 0; k < count; k = k + 1)
 	{
-		emit_out("rd_fp rs1_sp lw\t# Restore old frame pointer\n");
-		emit_out("rd_tp rs1_sp !8 lw\t# Restore temp register\n");
-		emit_out("rd_ra rs1_sp !4 lw\t# Restore return address\n");
-		emit_out("rd_sp rs1_sp !12 addi\t# Deallocate stack\n");
+		emit_out(argument_push[k]);
+		emit_out("\n");
 	}
-	else if(RISCV64 == Architecture)
+
+	if(AMD64 == Architecture)
 	{
-		emit_out("rd_fp rs1_sp ld\t# Restore old frame pointer\n");
-		emit_out("rd_tp rs1_sp !16 ld\t# Restore temp register\n");
-		emit_out("rd_ra rs1_sp !8 ld\t# Restore return address\n");
-		emit_out("rd_sp rs1_sp !24 addi\t# Deallocate stack\n");
+		emit_out(o1_define("O1_push_r11", "4153"));
+		emit_out("\n");
 	}
 }
 
-void constant_load(char* s)
+void expression(void);
+/* The FUNCTION_ flags of the named function, 0 if it is only declared */
+int function_flags(char* s)
 {
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("LOADI R0 ");
-	else if(X86 == Architecture) emit_out("mov_eax, %");
-	else if(AMD64 == Architecture) emit_out("mov_rax, %");
-	else if(ARMV7L == Architecture) emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n%");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	struct token_list* a = sym_lookup(s, global_function_table);
+	if(NULL == a) return 0;
+	return a->depth;
+}
+
+/* Has the label of the named function already been written out */
+int function_emitted(char* s)
+{
+	return function_flags(s) & FUNCTION_PLACED;
+}
+
+/* Is the named function compiled with neither arguments nor locals, so that
+ * its frame is empty and its body never reads the base pointer.  Leaf
+ * functions with arguments are not covered: they read them through it */
+int function_empty_frame(char* s)
+{
+	return function_flags(s) & FUNCTION_EMPTY_FRAME;
+}
+
+int list_length(struct token_list* a);
+/* How many arguments the named function takes in registers, 0 for none */
+int function_registers(char* s)
+{
+	if(0 == (function_flags(s) & FUNCTION_REGISTERS)) return 0;
+	struct token_list* a = sym_lookup(s, global_function_table);
+	return list_length(a->arguments);
+}
+
+/* The named function if calls to it can be expanded in place */
+struct token_list* inline_callee(char* s)
+{
+	if(0 == (function_flags(s) & FUNCTION_INLINE)) return NULL;
+	struct token_list* a = sym_lookup(s, global_function_table);
+	/* Recursion is left as a call */
+	if(function == a) return NULL;
+	return a;
+}
+
+int list_length(struct token_list* a)
+{
+	int i = 0;
+	while(NULL != a)
 	{
-		emit_out("rd_a0 ~");
-		emit_out(s);
-		emit_out(" lui\nrd_a0 rs1_a0 !");
+		i = i + 1;
+		a = a->next;
 	}
-	emit_out(s);
-	if(RISCV32 == Architecture) emit_out(" addi\n");
-	else if(RISCV64 == Architecture) emit_out(" addiw\n");
+	return i;
+}
+
+/* Compile the return expression of f where the call to it would go; its
+ * arguments, and nothing of the caller's scope, are visible to it */
+void expression(void);
+void inline_expansion(struct token_list* f)
+{
+	struct token_list* hold = global_token;
+	struct type* target = current_target;
+	struct sym_index** caller_scope = scope_table;
+	struct token_list* a;
+
+	if(NULL == inline_scope) inline_scope = new_sym_table();
+	scope_table = inline_scope;
+	for(a = f->arguments; NULL != a; a = a->next) sym_index(scope_table, a);
+
+	emit_out("# Inlined ");
+	emit_out(f->s);
 	emit_out("\n");
+	inlining = TRUE;
+	global_token = f->prev;
+	expression();
+	require(match(";", global_token->s), "Inlined return expression did not end at its ;\n");
+	inlining = FALSE;
+
+	sym_unindex_list(scope_table, f->arguments, NULL);
+	scope_table = caller_scope;
+	global_token = hold;
+	/* A call leaves the type of the expression as it was */
+	current_target = target;
 }
 
-char* load_value_signed(unsigned size)
+void function_call(char* s, int bool)
 {
-	if(size == 1)
-	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOAD8 R0 R0 0\n";
-		else if(X86 == Architecture) return "movsx_eax,BYTE_PTR_[eax]\n";
-		else if(AMD64 == Architecture) return "movsx_rax,BYTE_PTR_[rax]\n";
-		else if(ARMV7L == Architecture) return "LOADS8 R0 LOAD R0 HALF_MEMORY\n";
-		else if(AARCH64 == Architecture) return "LDRSB_X0_[X0]\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return "rd_a0 rs1_a0 lb\n";
+	require_match("ERROR in process_expression_list\nNo ( was found\n", "(");
+	require(NULL != global_token, "Improper function call\n");
+	int passed = 0;
+
+	/* A function with neither arguments nor locals never reads the base
+	 * pointer, so under -O1 it is called without one being set up */
+	int empty_frame = FALSE;
+	if(OPTIMIZE && !bool) empty_frame = function_empty_frame(s);
+
+	/* Under -O1 a call to a function that only returns a short expression
+	 * compiles that expression in place, inside the same frame a call
+	 * would get, or without any when it takes no arguments */
+	struct token_list* callee = NULL;
+	int expected = -1;
+	if(OPTIMIZE && !bool && !inlining) callee = inline_callee(s);
+	if(NULL != callee)
+	{
+		expected = list_length(callee->arguments);
+		if((0 == expected) && (')' == global_token->s[0]))
+		{
+			global_token = global_token->next;
+			inline_expansion(callee);
+			return;
+		}
 	}
-	else if(size == 2)
+
+	/* With --register-arguments a function that has a register entry gets
+	 * its arguments in registers and sets up its own base pointer */
+	int registers = 0;
+	if(!bool && (NULL == callee)) registers = function_registers(s);
+	int keep_frame = FALSE;
+	int k;
+
+	if(registers)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOAD16 R0 R0 0\n";
-		else if(X86 == Architecture) return "movsx_eax,WORD_PTR_[eax]\n";
-		else if(AMD64 == Architecture) return "movsx_rax,WORD_PTR_[rax]\n";
-		else if(ARMV7L == Architecture) return "LOADS16 R0 LOAD R0 HALF_MEMORY\n";
-		else if(AARCH64 == Architecture) return "LDRSH_X0_[X0]\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return "rd_a0 rs1_a0 lh\n";
+		if(AMD64 == Architecture)
+		{
+			register_calls = TRUE;
+			keep_frame = (0 != frames_pending);
+			if(keep_frame) emit_out("push_rdi\t# Protect the frame of the call being set up\n");
+			emit_out("push_rbp\t# Protect the old base pointer\n");
+		}
+		else if(AARCH64 == Architecture)
+		{
+			emit_out("PUSH_LR\t# Protect the old return pointer (link)\n");
+			emit_out("PUSH_BP\t# Protect the old base pointer\n");
+		}
+		else if(RISCV32 == Architecture)
+		{
+			emit_out("rd_sp rs1_sp !-8 addi\t# Allocate stack\n");
+			emit_out("rs1_sp rs2_ra @4 sw\t# Protect the old return pointer\n");
+			emit_out("rs1_sp rs2_fp sw\t# Protect the old frame pointer\n");
+		}
+		else if(RISCV64 == Architecture)
+		{
+			emit_out("rd_sp rs1_sp !-16 addi\t# Allocate stack\n");
+			emit_out("rs1_sp rs2_ra @8 sd\t# Protect the old return pointer\n");
+			emit_out("rs1_sp rs2_fp sd\t# Protect the old frame pointer\n");
+		}
 	}
-	else if(size == 4)
+	else if(empty_frame)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOAD R0 R0 0\n";
-		else if(X86 == Architecture) return "mov_eax,[eax]\n";
-		else if(AMD64 == Architecture) return "movsx_rax,DWORD_PTR_[rax]\n";
-		else if(ARMV7L == Architecture) return "!0 R0 LOAD32 R0 MEMORY\n";
-		else if(AARCH64 == Architecture) return "LDR_W0_[X0]\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return "rd_a0 rs1_a0 lw\n";
+		if(AARCH64 == Architecture) emit_out("PUSH_LR\t# Protect the old return pointer (link)\n");
+		else if(RISCV32 == Architecture) emit_out("rd_sp rs1_sp !-4 addi\nrs1_sp rs2_ra sw\t# Protect the old return pointer\n");
+		else if(RISCV64 == Architecture) emit_out("rd_sp rs1_sp !-8 addi\nrs1_sp rs2_ra sd\t# Protect the old return pointer\n");
 	}
-	else if(size == 8)
+	else if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 	{
-		if(AMD64 == Architecture) return "mov_rax,[rax]\n";
-		else if(AARCH64 == Architecture) return "DEREF_X0\n";
-		else if(RISCV64 == Architecture) return "rd_a0 rs1_a0 ld\n";
+		emit_out("PUSHR R13 R15\t# Prevent overwriting in recursion\n");
+		emit_out("PUSHR R14 R15\t# Protect the old base pointer\n");
+		emit_out("COPY R13 R15\t# Copy new base pointer\n");
 	}
-	line_error();
-	fputs(" Got unsupported size ", stderr);
-	fputs(int2str(size, 10, TRUE), stderr);
-	fputs(" when trying to load value.\n", stderr);
-	exit(EXIT_FAILURE);
-}
-
-char* load_value_unsigned(unsigned size)
-{
-	if(size == 1)
+	else if(X86 == Architecture)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOADU8 R0 R0 0\n";
-		else if(X86 == Architecture) return "movzx_eax,BYTE_PTR_[eax]\n";
-		else if(AMD64 == Architecture) return "movzx_rax,BYTE_PTR_[rax]\n";
-		else if(ARMV7L == Architecture) return "!0 R0 LOAD R0 MEMORY\n";
-		else if(AARCH64 == Architecture) return "DEREF_X0_BYTE\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return "rd_a0 rs1_a0 lbu\n";
+		emit_out("push_edi\t# Prevent overwriting in recursion\n");
+		emit_out("push_ebp\t# Protect the old base pointer\n");
+		emit_out("mov_edi,esp\t# Copy new base pointer\n");
 	}
-	else if(size == 2)
+	else if(AMD64 == Architecture)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOADU16 R0 R0 0\n";
-		else if(X86 == Architecture) return "movzx_eax,WORD_PTR_[eax]\n";
-		else if(AMD64 == Architecture) return "movzx_rax,WORD_PTR_[rax]\n";
-		else if(ARMV7L == Architecture) return "NO_OFFSET R0 LOAD R0 HALF_MEMORY\n";
-		else if(AARCH64 == Architecture) return "LDRH_W0_[X0]\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return "rd_a0 rs1_a0 lhu\n";
+		emit_out("push_rdi\t# Prevent overwriting in recursion\n");
+		emit_out("push_rbp\t# Protect the old base pointer\n");
+		emit_out("mov_rdi,rsp\t# Copy new base pointer\n");
 	}
-	else if(size == 4)
+	else if(ARMV7L == Architecture)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOAD R0 R0 0\n";
-		else if(X86 == Architecture) return "mov_eax,[eax]\n";
-		else if(AMD64 == Architecture) return "mov_eax,[rax]\n";
-		else if(ARMV7L == Architecture) return "!0 R0 LOAD32 R0 MEMORY\n";
-		else if(AARCH64 == Architecture) return "LDR_W0_[X0]\n";
-		else if(RISCV32 == Architecture) return "rd_a0 rs1_a0 lw\n";
-		else if(RISCV64 == Architecture) return "rd_a0 rs1_a0 lwu\n";
+		emit_out("{R11} PUSH_ALWAYS\t# Prevent overwriting in recursion\n");
+		emit_out("{BP} PUSH_ALWAYS\t# Protect the old base pointer\n");
+		emit_out("'0' SP R11 NO_SHIFT MOVE_ALWAYS\t# Copy new base pointer\n");
 	}
-	else if(size == 8)
+	else if(AARCH64 == Architecture)
 	{
-		if(AMD64 == Architecture) return "mov_rax,[rax]\n";
-		else if(AARCH64 == Architecture) return "DEREF_X0\n";
-		else if(RISCV64 == Architecture) return "rd_a0 rs1_a0 ld\n";
+		emit_out("PUSH_X16\t# Protect a tmp register we're going to use\n");
+		emit_out("PUSH_LR\t# Protect the old return pointer (link)\n");
+		emit_out("PUSH_BP\t# Protect the old base pointer\n");
+		emit_out("SET_X16_FROM_SP\t# The base pointer to-be\n");
 	}
-	line_error();
-	fputs(" Got unsupported size ", stderr);
-	fputs(int2str(size, 10, TRUE), stderr);
+	else if(RISCV32 == Architecture)
+	{
+		emit_out("rd_sp rs1_sp !-12 addi\t# Allocate stack\n");
+		emit_out("rs1_sp rs2_ra @4 sw\t# Protect the old return pointer\n");
+		emit_out("rs1_sp rs2_fp sw\t# Protect the old frame pointer\n");
+		emit_out("rs1_sp rs2_tp @8 sw\t# Protect temp register we are going to use\n");
+		emit_out("rd_tp rs1_sp mv\t# The base pointer to-be\n");
+	}
+	else if(RISCV64 == Architecture)
+	{
+		emit_out("rd_sp rs1_sp !-24 addi\t# Allocate stack\n");
+		emit_out("rs1_sp rs2_ra @8 sd\t# Protect the old return pointer\n");
+		emit_out("rs1_sp rs2_fp sd\t# Protect the old frame pointer\n");
+		emit_out("rs1_sp rs2_tp @16 sd\t# Protect temp register we are going to use\n");
+		emit_out("rd_tp rs1_sp mv\t# The base pointer to-be\n");
+	}
+	if(!registers && !empty_frame) frames_pending = frames_pending + 1;
+
+	if(global_token->s[0] != ')')
+	{
+		expression();
+		require(NULL != global_token, "incomplete function call, received EOF instead of )\n");
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("PUSHR R0 R15\t#_process_expression1\n");
+		else if(X86 == Architecture) emit_out("push_eax\t#_process_expression1\n");
+		else if(AMD64 == Architecture) emit_out("push_rax\t#_process_expression1\n");
+		else if(ARMV7L == Architecture) emit_out("{R0} PUSH_ALWAYS\t#_process_expression1\n");
+		else if(AARCH64 == Architecture) emit_out("PUSH_X0\t#_process_expression1\n");
+		else if(RISCV32 == Architecture) emit_out("rd_sp rs1_sp !-4 addi\nrs1_sp rs2_a0 sw\t#_process_expression1\n");
+		else if(RISCV64 == Architecture) emit_out("rd_sp rs1_sp !-8 addi\nrs1_sp rs2_a0 sd\t#_process_expression1\n");
+		passed = 1;
+
+		while(global_token->s[0] == ',')
+		{
+			global_token = global_token->next;
+			require(NULL != global_token, "incomplete function call, received EOF instead of argument\n");
+			expression();
+			if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("PUSHR R0 R15\t#_process_expression2\n");
+			else if(X86 == Architecture) emit_out("push_eax\t#_process_expression2\n");
+			else if(AMD64 == Architecture) emit_out("push_rax\t#_process_expression2\n");
+			else if(ARMV7L == Architecture) emit_out("{R0} PUSH_ALWAYS\t#_process_expression2\n");
+			else if(AARCH64 == Architecture) emit_out("PUSH_X0\t#_process_expression2\n");
+			else if(RISCV32 == Architecture) emit_out("rd_sp rs1_sp !-4 addi\nrs1_sp rs2_a0 sw\t#_process_expression2\n");
+			else if(RISCV64 == Architecture) emit_out("rd_sp rs1_sp !-8 addi\nrs1_sp rs2_a0 sd\t#_process_expression2\n");
+			passed = passed + 1;
+		}
+	}
+
+	require_match("ERROR in process_expression_list\nNo ) was found\n", ")");
+	ir_append(IR_CALL, NULL);
+	if(!registers && !empty_frame) frames_pending = frames_pending - 1;
+
+	if(TRUE == bool)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
+		{
+			emit_out("LOAD R0 R14 ");
+			emit_out(s);
+			emit_out("\nMOVE R14 R13\n");
+			emit_out("CALL R0 R15\n");
+		}
+		else if(X86 == Architecture)
+		{
+			emit_out("lea_eax,[ebp+DWORD] %");
+			emit_out(s);
+			emit_out("\nmov_eax,[eax]\n");
+			emit_out("mov_ebp,edi\n");
+			emit_out("call_eax\n");
+		}
+		else if(AMD64 == Architecture)
+		{
+			emit_out("lea_rax,[rbp+DWORD] %");
+			emit_out(s);
+			emit_out("\nmov_rax,[rax]\n");
+			emit_out("mov_rbp,rdi\n");
+			emit_out("call_rax\n");
+		}
+		else if(ARMV7L == Architecture)
+		{
+			emit_out("!");
+			emit_out(s);
+			emit_out(" R0 SUB BP ARITH_ALWAYS\n");
+			emit_out("!0 R0 LOAD32 R0 MEMORY\n");
+			emit_out("{LR} PUSH_ALWAYS\t# Protect the old link register\n");
+			emit_out("'0' R11 BP NO_SHIFT MOVE_ALWAYS\n");
+			emit_out("'3' R0 CALL_REG_ALWAYS\n");
+			emit_out("{LR} POP_ALWAYS\t# Prevent overwrite\n");
+		}
+		else if(AARCH64 == Architecture)
+		{
+			emit_out("SET_X0_FROM_BP\n");
+			emit_out("LOAD_W1_AHEAD\nSKIP_32_DATA\n%");
+			emit_out(s);
+			emit_out("\nSUB_X0_X0_X1\n");
+			emit_out("DEREF_X0\n");
+			emit_out("SET_BP_FROM_X16\n");
+			emit_out("SET_X16_FROM_X0\n");
+			emit_out("BLR_X16\n");
+		}
+		else if(RISCV32 == Architecture)
+		{
+			emit_out("rd_a0 rs1_fp !");
+			emit_out(s);
+			emit_out(" addi\n");
+			emit_out("rd_a0 rs1_a0 lw\n");
+			emit_out("rd_fp rs1_tp mv\n");
+			emit_out("rd_ra rs1_a0 jalr\n");
+		}
+		else if(RISCV64 == Architecture)
+		{
+			emit_out("rd_a0 rs1_fp !");
+			emit_out(s);
+			emit_out(" addi\n");
+			emit_out("rd_a0 rs1_a0 ld\n");
+			emit_out("rd_fp rs1_tp mv\n");
+			emit_out("rd_ra rs1_a0 jalr\n");
+		}
+	}
+	else if(registers)
+	{
+		if(passed != registers)
+		{
+			line_error();
+			fputs(s, stderr);
+			fputs(" is not given the number of arguments it takes, which --register-arguments needs\n", stderr);
+			compile_failure();
+		}
+
+		/* The last argument is on top of the stack */
+		for(k = passed - 1; 0 <= k; k = k - 1) argument_pop_out(k);
+		if(AMD64 == Architecture) emit_out("call %REGISTERS_");
+		else if(AARCH64 == Architecture) emit_out("^~REGISTERS_");
+		else emit_out("rd_ra $REGISTERS_");
+		emit_out(s);
+		if(AMD64 == Architecture) emit_out("\n");
+		else if(AARCH64 == Architecture) emit_out(bl_backwards());
+		else emit_out(" jal\n");
+	}
+	else if(expected == passed)
+	{
+		if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture)) emit_out("MOVE R14 R13\n");
+		else if(X86 == Architecture) emit_out("mov_ebp,edi\n");
+		else if(AMD64 == Architecture) emit_out("mov_rbp,rdi\n");
+		else if(ARMV7L == Architecture) emit_out("'0' R11 BP NO_SHIFT MOVE_ALWAYS\n");
+		else if(AARCH64 == Architecture) emit_out("SET_BP_FROM_X16\n");
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_fp rs1_tp mv\n");
+		inline_expansion(callee);
+	}
+	else if(empty_frame)
+	{
+		if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture)) emit_out("LOADR R0 4\nJUMP 4\n&FUNCTION_");
+		else if((X86 == Architecture) || (AMD64 == Architecture)) emit_out("call %FUNCTION_");
+		else if(ARMV7L == Architecture) emit_out("{LR} PUSH_ALWAYS\t# Protect the old link register\n^~FUNCTION_");
+		else if(AARCH64 == Architecture) emit_out("^~FUNCTION_");
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_ra $FUNCTION_");
+		emit_out(s);
+		if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture)) emit_out("\nCALL R0 R15\n");
+		else if((X86 == Architecture) || (AMD64 == Architecture)) emit_out("\n");
+		else if(ARMV7L == Architecture) emit_out(" CALL_ALWAYS\n{LR} POP_ALWAYS\t# Restore the old link register\n");
+		else if(AARCH64 == Architecture) emit_out(bl_backwards());
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" jal\n");
+	}
+	else
+	{
+		if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture))
+		{
+			emit_out("MOVE R14 R13\n");
+			emit_out("LOADR R0 4\nJUMP 4\n&FUNCTION_");
+			emit_out(s);
+			emit_out("\nCALL R0 R15\n");
+		}
+		else if(X86 == Architecture)
+		{
+			emit_out("mov_ebp,edi\n");
+			emit_out("call %FUNCTION_");
+			emit_out(s);
+			emit_out("\n");
+		}
+		else if(AMD64 == Architecture)
+		{
+			emit_out("mov_rbp,rdi\n");
+			emit_out("call %FUNCTION_");
+			emit_out(s);
+			emit_out("\n");
+		}
+		else if(ARMV7L == Architecture)
+		{
+			emit_out("{LR} PUSH_ALWAYS\t# Protect the old link register\n");
+			emit_out("'0' R11 BP NO_SHIFT MOVE_ALWAYS\n");
+			emit_out("^~FUNCTION_");
+			emit_out(s);
+			emit_out(" CALL_ALWAYS\n");
+			emit_out("{LR} POP_ALWAYS\t# Restore the old link register\n");
+		}
+		else if(AARCH64 == Architecture)
+		{
+			emit_out("SET_BP_FROM_X16\n");
+			if(OPTIMIZE)
+			{
+				emit_out("^~FUNCTION_");
+				emit_out(s);
+				if(function_emitted(s)) emit_out(bl_backwards());
+				else emit_out(bl_forward(s));
+			}
+			else
+			{
+				emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&FUNCTION_");
+				emit_out(s);
+				emit_out("\n");
+				emit_out("BLR_X16\n");
+			}
+		}
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+		{
+			emit_out("rd_fp rs1_tp mv\n");
+			emit_out("rd_ra $FUNCTION_");
+			emit_out(s);
+			emit_out(" jal\n");
+		}
+	}
+
+	release_stack(passed, "_process_expression_locals");
+
+	if(registers)
+	{
+		if(AMD64 == Architecture)
+		{
+			emit_out("pop_rbp\t# Restore old base pointer\n");
+			if(keep_frame) emit_out("pop_rdi\t# Restore the frame of the call being set up\n");
+		}
+		else if(AARCH64 == Architecture)
+		{
+			emit_out("POP_BP\t# Restore the old base pointer\n");
+			emit_out("POP_LR\t# Restore the old return pointer (link)\n");
+		}
+		else if(RISCV32 == Architecture)
+		{
+			emit_out("rd_fp rs1_sp lw\t# Restore old frame pointer\n");
+			emit_out("rd_ra rs1_sp !4 lw\t# Restore return address\n");
+			emit_out("rd_sp rs1_sp !8 addi\t# Deallocate stack\n");
+		}
+		else if(RISCV64 == Architecture)
+		{
+			emit_out("rd_fp rs1_sp ld\t# Restore old frame pointer\n");
+			emit_out("rd_ra rs1_sp !8 ld\t# Restore return address\n");
+			emit_out("rd_sp rs1_sp !16 addi\t# Deallocate stack\n");
+		}
+	}
+	else if(empty_frame)
+	{
+		if(AARCH64 == Architecture) emit_out("POP_LR\t# Restore the old return pointer (link)\n");
+		else if(RISCV32 == Architecture) emit_out("rd_ra rs1_sp lw\t# Restore return address\nrd_sp rs1_sp !4 addi\n");
+		else if(RISCV64 == Architecture) emit_out("rd_ra rs1_sp ld\t# Restore return address\nrd_sp rs1_sp !8 addi\n");
+	}
+	else if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
+	{
+		emit_out("POPR R14 R15\t# Restore old base pointer\n");
+		emit_out("POPR R13 R15\t# Prevent overwrite\n");
+	}
+	else if(X86 == Architecture)
+	{
+		emit_out("pop_ebp\t# Restore old base pointer\n");
+		emit_out("pop_edi\t# Prevent overwrite\n");
+	}
+	else if(AMD64 == Architecture)
+	{
+		emit_out("pop_rbp\t# Restore old base pointer\n");
+		emit_out("pop_rdi\t# Prevent overwrite\n");
+	}
+	else if(ARMV7L == Architecture)
+	{
+		emit_out("{BP} POP_ALWAYS\t# Restore old base pointer\n");
+		emit_out("{R11} POP_ALWAYS\t# Prevent overwrite\n");
+	}
+	else if(AARCH64 == Architecture)
+	{
+		emit_out("POP_BP\t# Restore the old base pointer\n");
+		emit_out("POP_LR\t# Restore the old return pointer (link)\n");
+		emit_out("POP_X16\t# Restore a register we used as tmp\n");
+	}
+	else if(RISCV32 == Architecture)
+	{
+		emit_out("rd_fp rs1_sp lw\t# Restore old frame pointer\n");
+		emit_out("rd_tp rs1_sp !8 lw\t# Restore temp register\n");
+		emit_out("rd_ra rs1_sp !4 lw\t# Restore return address\n");
+		emit_out("rd_sp rs1_sp !12 addi\t# Deallocate stack\n");
+	}
+	else if(RISCV64 == Architecture)
+	{
+		emit_out("rd_fp rs1_sp ld\t# Restore old frame pointer\n");
+		emit_out("rd_tp rs1_sp !16 ld\t# Restore temp register\n");
+		emit_out("rd_ra rs1_sp !8 ld\t# Restore return address\n");
+		emit_out("rd_sp rs1_sp !24 addi\t# Deallocate stack\n");
+	}
+}
+
+void primary_expr_number(char* s);
+void constant_load(char* s)
+{
+	if(OPTIMIZE)
+	{
+		primary_expr_number(s);
+		return;
+	}
+
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("LOADI R0 ");
+	else if(X86 == Architecture) emit_out("mov_eax, %");
+	else if(AMD64 == Architecture) emit_out("mov_rax, %");
+	else if(ARMV7L == Architecture) emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
+	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n%");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	{
+		emit_out("rd_a0 ~");
+		emit_out(s);
+		emit_out(" lui\nrd_a0 rs1_a0 !");
+	}
+	emit_out(s);
+	if(RISCV32 == Architecture) emit_out(" addi\n");
+	else if(RISCV64 == Architecture) emit_out(" addiw\n");
+	emit_out("\n");
+}
+
+char* load_value_signed(unsigned size)
+{
+	if(size == 1)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOAD8 R0 R0 0\n";
+		else if(X86 == Architecture) return "movsx_eax,BYTE_PTR_[eax]\n";
+		else if(AMD64 == Architecture) return "movsx_rax,BYTE_PTR_[rax]\n";
+		else if(ARMV7L == Architecture) return "LOADS8 R0 LOAD R0 HALF_MEMORY\n";
+		else if(AARCH64 == Architecture) return "LDRSB_X0_[X0]\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return "rd_a0 rs1_a0 lb\n";
+	}
+	else if(size == 2)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOAD16 R0 R0 0\n";
+		else if(X86 == Architecture) return "movsx_eax,WORD_PTR_[eax]\n";
+		else if(AMD64 == Architecture) return "movsx_rax,WORD_PTR_[rax]\n";
+		else if(ARMV7L == Architecture) return "LOADS16 R0 LOAD R0 HALF_MEMORY\n";
+		else if(AARCH64 == Architecture) return "LDRSH_X0_[X0]\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return "rd_a0 rs1_a0 lh\n";
+	}
+	else if(size == 4)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOAD R0 R0 0\n";
+		else if(X86 == Architecture) return "mov_eax,[eax]\n";
+		else if(AMD64 == Architecture) return "movsx_rax,DWORD_PTR_[rax]\n";
+		else if(ARMV7L == Architecture) return "!0 R0 LOAD32 R0 MEMORY\n";
+		else if(AARCH64 == Architecture) return "LDR_W0_[X0]\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return "rd_a0 rs1_a0 lw\n";
+	}
+	else if(size == 8)
+	{
+		if(AMD64 == Architecture) return "mov_rax,[rax]\n";
+		else if(AARCH64 == Architecture) return "DEREF_X0\n";
+		else if(RISCV64 == Architecture) return "rd_a0 rs1_a0 ld\n";
+	}
+	line_error();
+	fputs(" Got unsupported size ", stderr);
+	fputs(int2str(size, 10, TRUE), stderr);
 	fputs(" when trying to load value.\n", stderr);
-	exit(EXIT_FAILURE);
+	compile_failure();
+}
+
+char* load_value_unsigned(unsigned size)
+{
+	if(size == 1)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOADU8 R0 R0 0\n";
+		else if(X86 == Architecture) return "movzx_eax,BYTE_PTR_[eax]\n";
+		else if(AMD64 == Architecture) return "movzx_rax,BYTE_PTR_[rax]\n";
+		else if(ARMV7L == Architecture) return "!0 R0 LOAD R0 MEMORY\n";
+		else if(AARCH64 == Architecture) return "DEREF_X0_BYTE\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return "rd_a0 rs1_a0 lbu\n";
+	}
+	else if(size == 2)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOADU16 R0 R0 0\n";
+		else if(X86 == Architecture) return "movzx_eax,WORD_PTR_[eax]\n";
+		else if(AMD64 == Architecture) return "movzx_rax,WORD_PTR_[rax]\n";
+		else if(ARMV7L == Architecture) return "NO_OFFSET R0 LOAD R0 HALF_MEMORY\n";
+		else if(AARCH64 == Architecture) return "LDRH_W0_[X0]\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return "rd_a0 rs1_a0 lhu\n";
+	}
+	else if(size == 4)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "LOAD R0 R0 0\n";
+		else if(X86 == Architecture) return "mov_eax,[eax]\n";
+		else if(AMD64 == Architecture) return "mov_eax,[rax]\n";
+		else if(ARMV7L == Architecture) return "!0 R0 LOAD32 R0 MEMORY\n";
+		else if(AARCH64 == Architecture) return "LDR_W0_[X0]\n";
+		else if(RISCV32 == Architecture) return "rd_a0 rs1_a0 lw\n";
+		else if(RISCV64 == Architecture) return "rd_a0 rs1_a0 lwu\n";
+	}
+	else if(size == 8)
+	{
+		if(AMD64 == Architecture) return "mov_rax,[rax]\n";
+		else if(AARCH64 == Architecture) return "DEREF_X0\n";
+		else if(RISCV64 == Architecture) return "rd_a0 rs1_a0 ld\n";
+	}
+	line_error();
+	fputs(" Got unsupported size ", stderr);
+	fputs(int2str(size, 10, TRUE), stderr);
+	fputs(" when trying to load value.\n", stderr);
+	compile_failure();
+}
+
+char* load_value(unsigned size, int is_signed)
+{
+	if(is_signed) return load_value_signed(size);
+	return load_value_unsigned(size);
+}
+
+char* store_value(unsigned size)
+{
+	if(size == 1)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "STORE8 R0 R1 0\n";
+		else if(X86 == Architecture) return "mov_[ebx],al\n";
+		else if(AMD64 == Architecture) return "mov_[rbx],al\n";
+		else if(ARMV7L == Architecture) return "!0 R0 STORE8 R1 MEMORY\n";
+		else if(AARCH64 == Architecture) return "STR_BYTE_W0_[X1]\n";
+		else if(RISCV32 == Architecture) return "rs1_a1 rs2_a0 sb\n";
+		else if(RISCV64 == Architecture) return "rs1_a1 rs2_a0 sb\n";
+	}
+	else if(size == 2)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "STORE16 R0 R1 0\n";
+		else if(X86 == Architecture) return "mov_[ebx],ax\n";
+		else if(AMD64 == Architecture) return "mov_[rbx],ax\n";
+		else if(ARMV7L == Architecture) return "NO_OFFSET R0 STORE16 R1 HALF_MEMORY\n";
+		else if(AARCH64 == Architecture) return "STRH_W0_[X1]\n";
+		else if(RISCV32 == Architecture || RISCV64 == Architecture) return "rs1_a1 rs2_a0 sh\n";
+	}
+	else if(size == 4)
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "STORE R0 R1 0\n";
+		else if(X86 == Architecture) return "mov_[ebx],eax\n";
+		else if(AMD64 == Architecture) return "mov_[rbx],eax\n";
+		else if(ARMV7L == Architecture) return "!0 R0 STORE32 R1 MEMORY\n";
+		else if(AARCH64 == Architecture) return "STR_W0_[X1]\n";
+		else if(RISCV32 == Architecture || RISCV64 == Architecture) return "rs1_a1 rs2_a0 sw\n";
+	}
+	else if(size == 8)
+	{
+		if(AMD64 == Architecture) return "mov_[rbx],rax\n";
+		else if(AARCH64 == Architecture) return "STR_X0_[X1]\n";
+		else if(RISCV64 == Architecture) return "rs1_a1 rs2_a0 sd\n";
+	}
+	/* Should not happen but print error message. */
+	fputs("Got unsupported size ", stderr);
+	fputs(int2str(size, 10, TRUE), stderr);
+	fputs(" when storing number in register.\n", stderr);
+	line_error();
+	compile_failure();
+}
+
+int is_compound_assignment(char* token)
+{
+	if(match("+=", token)) return TRUE;
+	else if(match("-=", token)) return TRUE;
+	else if(match("*=", token)) return TRUE;
+	else if(match("/=", token)) return TRUE;
+	else if(match("%=", token)) return TRUE;
+	else if(match("<<=", token)) return TRUE;
+	else if(match(">>=", token)) return TRUE;
+	else if(match("&=", token)) return TRUE;
+	else if(match("^=", token)) return TRUE;
+	else if(match("|=", token)) return TRUE;
+	return FALSE;
+}
+
+void postfix_expr_stub(void);
+void variable_load(struct token_list* a, int num_dereference)
+{
+	require(NULL != global_token, "incomplete variable load received\n");
+	if((match("FUNCTION", a->type->name) || match("FUNCTION*", a->type->name)) && match("(", global_token->s))
+	{
+		function_call(int2str(a->depth, 10, TRUE), TRUE);
+		return;
+	}
+	current_target = a->type;
+
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("ADDI R0 R14 ");
+	else if(X86 == Architecture) emit_out("lea_eax,[ebp+DWORD] %");
+	else if(AMD64 == Architecture) emit_out("lea_rax,[rbp+DWORD] %");
+	else if(ARMV7L == Architecture) emit_out("!");
+	else if(AARCH64 == Architecture) emit_out("SET_X0_FROM_BP\nLOAD_W1_AHEAD\nSKIP_32_DATA\n%");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_fp !");
+
+	emit_out(int2str(a->depth, 10, TRUE));
+	if(ARMV7L == Architecture) emit_out(" R0 SUB BP ARITH_ALWAYS");
+	else if(AARCH64 == Architecture) emit_out("\nSUB_X0_X0_X1\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" addi");
+	emit_out("\n");
+
+	if(TRUE == Address_of) return;
+	if(match(".", global_token->s))
+	{
+		postfix_expr_stub();
+		return;
+	}
+	if(!match("=", global_token->s) && !is_compound_assignment(global_token->s))
+	{
+		emit_out(load_value(current_target->size, current_target->is_signed));
+	}
+
+	while (num_dereference > 0)
+	{
+		current_target = current_target->type;
+		emit_out(load_value(current_target->size, current_target->is_signed));
+		num_dereference = num_dereference - 1;
+	}
+}
+
+void function_load(struct token_list* a)
+{
+	require(NULL != global_token, "incomplete function load\n");
+	if(match("(", global_token->s))
+	{
+		function_call(a->s, FALSE);
+		return;
+	}
+
+	if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture)) emit_out("LOADR R0 4\nJUMP 4\n&FUNCTION_");
+	else if(X86 == Architecture) emit_out("mov_eax, &FUNCTION_");
+	else if(AMD64 == Architecture) emit_out("lea_rax,[rip+DWORD] %FUNCTION_");
+	else if(ARMV7L == Architecture) emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n&FUNCTION_");
+	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n&FUNCTION_");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 ~FUNCTION_");
+	emit_out(a->s);
+	if(RISCV32 == Architecture)
+	{
+		emit_out(" auipc\n");
+		emit_out("rd_a0 rs1_a0 !FUNCTION_");
+		emit_out(a->s);
+		emit_out(" addi");
+	}
+	else if(RISCV64 == Architecture)
+	{
+		emit_out(" auipc\n");
+		emit_out("rd_a0 rs1_a0 !FUNCTION_");
+		emit_out(a->s);
+		emit_out(" addiw");
+	}
+	emit_out("\n");
+}
+
+void global_load(struct token_list* a)
+{
+	current_target = a->type;
+	if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture)) emit_out("LOADR R0 4\nJUMP 4\n&GLOBAL_");
+	else if(X86 == Architecture) emit_out("mov_eax, &GLOBAL_");
+	else if(AMD64 == Architecture) emit_out("lea_rax,[rip+DWORD] %GLOBAL_");
+	else if(ARMV7L == Architecture) emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n&GLOBAL_");
+	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n&GLOBAL_");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 ~GLOBAL_");
+	emit_out(a->s);
+	if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	{
+		emit_out(" auipc\n");
+		emit_out("rd_a0 rs1_a0 !GLOBAL_");
+		emit_out(a->s);
+		emit_out(" addi");
+	}
+	emit_out("\n");
+
+	require(NULL != global_token, "unterminated global load\n");
+	if(TRUE == Address_of) return;
+	if(match(".", global_token->s))
+	{
+		postfix_expr_stub();
+		return;
+	}
+	if(match("=", global_token->s) || is_compound_assignment(global_token->s)) return;
+
+	emit_out(load_value(register_size, current_target->is_signed));
+}
+
+/*
+ * primary-expr:
+ * FAILURE
+ * "String"
+ * 'Char'
+ * [0-9]*
+ * [a-z,A-Z]*
+ * ( expression )
+ */
+
+void primary_expr_failure(void)
+{
+	require(NULL != global_token, "hit EOF when expecting primary expression\n");
+	line_error();
+	fputs("Received ", stderr);
+	fputs(global_token->s, stderr);
+	fputs(" in primary_expr\n", stderr);
+	compile_failure();
+}
+
+void primary_expr_string(void)
+{
+	char* number_string = int2str(current_count, 10, TRUE);
+	current_count = current_count + 1;
+	if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture)) emit_out("LOADR R0 4\nJUMP 4\n&STRING_");
+	else if(X86 == Architecture) emit_out("mov_eax, &STRING_");
+	else if(AMD64 == Architecture) emit_out("lea_rax,[rip+DWORD] %STRING_");
+	else if(ARMV7L == Architecture) emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n&STRING_");
+	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n&STRING_");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 ~STRING_");
+	uniqueID_out(function->s, number_string);
+	if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	{
+		emit_out("auipc\n");
+		emit_out("rd_a0 rs1_a0 !STRING_");
+		uniqueID_out(function->s, number_string);
+		emit_out("addi\n");
+	}
+
+	/* The target */
+	emit(":STRING_", strings_list);
+	uniqueID(function->s, strings_list, number_string);
+
+	/* catch case of just "foo" from segfaulting */
+	require(NULL != global_token->next, "a string by itself is not valid C\n");
+
+	/* Parse the string */
+	if(TOKEN_STRING != global_token->next->kind)
+	{
+		emit(parse_string(global_token->s), strings_list);
+		global_token = global_token->next;
+	}
+	else
+	{
+		char* s = calloc(MAX_STRING, sizeof(char));
+
+		/* prefix leading string */
+		s[0] = '"';
+		int i = 1;
+
+		int j;
+		while(TOKEN_STRING == global_token->kind)
+		{
+			/* Step past the leading '"' */
+			j = 1;
+
+			/* Copy the rest of the string as is */
+			while(0 != global_token->s[j])
+			{
+				require(i < MAX_STRING, "concat string exceeded max string length\n");
+				s[i] = global_token->s[j];
+				i = i + 1;
+				j = j + 1;
+			}
+
+			/* Move on to the next token */
+			global_token = global_token->next;
+			require(NULL != global_token, "multi-string null is not valid C\n");
+		}
+
+		/* Now use it */
+		emit(parse_string(s), strings_list);
+	}
+}
+
+void primary_expr_char(void)
+{
+	if(OPTIMIZE)
+	{
+		primary_expr_number(int2str(escape_lookup(global_token->s + 1), 10, TRUE));
+		global_token = global_token->next;
+		return;
+	}
+
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("LOADI R0 ");
+	else if(X86 == Architecture) emit_out("mov_eax, %");
+	else if(AMD64 == Architecture) emit_out("mov_rax, %");
+	else if(ARMV7L == Architecture) emit_out("!");
+	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n%");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 !");
+	emit_out(int2str(escape_lookup(global_token->s + 1), 10, TRUE));
+	if(ARMV7L == Architecture) emit_out(" R0 LOADI8_ALWAYS");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" addi");
+	emit_out("\n");
+	global_token = global_token->next;
+}
+
+int hex2char(int c)
+{
+	if((c >= 0) && (c <= 9)) return (c + 48);
+	else if((c >= 10) && (c <= 15)) return (c + 55);
+	else return -1;
+}
+
+char* number_to_hex(int a, int bytes)
+{
+	require(bytes > 0, "number to hex must have a positive number of bytes greater than zero\n");
+	char* result = calloc(1 + (bytes << 1), sizeof(char));
+	if(NULL == result)
+	{
+		fputs("calloc failed in number_to_hex\n", stderr);
+		compile_failure();
+	}
+	int i = 0;
+
+	int divisor = (bytes << 3);
+	require(divisor > 0, "unexpected wrap around in number_to_hex\n");
+
+	/* Simply collect numbers until divisor is gone */
+	while(0 != divisor)
+	{
+		divisor = divisor - 4;
+		result[i] = hex2char((a >> divisor) & 0xF);
+		i = i + 1;
+	}
+
+	return result;
+}
+
+/* Load the number s into the accumulator */
+void lower_constant(char* s, struct emit_buffer* b)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
+	{
+		int size = strtoint(s);
+		if((32767 > size) && (size > -32768))
+		{
+			emit("LOADI R0 ", b);
+			emit(s, b);
+		}
+		else
+		{
+			emit("LOADR R0 4\nJUMP 4\n'", b);
+			emit(number_to_hex(size, register_size), b);
+			emit("'", b);
+		}
+	}
+	else if(X86 == Architecture)
+	{
+		emit("mov_eax, %", b);
+		emit(s, b);
+	}
+	else if(AMD64 == Architecture)
+	{
+		emit("mov_rax, %", b);
+		emit(s, b);
+	}
+	else if(ARMV7L == Architecture)
+	{
+		int size = strtoint(s);
+		if(OPTIMIZE && (0 <= size) && (size < 256) && ('0' <= s[0]) && ('9' >= s[0]))
+		{
+			emit("!", b);
+			emit(int2str(size, 10, TRUE), b);
+			emit(" R0 LOADI8_ALWAYS", b);
+		}
+		else
+		{
+			emit("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%", b);
+			emit(s, b);
+		}
+	}
+	else if(AARCH64 == Architecture)
+	{
+		if(OPTIMIZE && match("0", s)) emit("SET_X0_TO_0", b);
+		else if(OPTIMIZE && match("1", s)) emit("SET_X0_TO_1", b);
+		else
+		{
+			emit("LOAD_W0_AHEAD\nSKIP_32_DATA\n%", b);
+			emit(s, b);
+		}
+	}
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	{
+		int size = strtoint(s);
+		if((2047 > size) && (size > -2048))
+		{
+			emit("rd_a0 !", b);
+			emit(s, b);
+			emit(" addi", b);
+		}
+		else if (0 == (size >> 30))
+		{
+			emit("rd_a0 ~", b);
+			emit(s, b);
+			emit(" lui\n", b);
+			emit("rd_a0 rs1_a0 !", b);
+			emit(s, b);
+			emit(" addi", b);
+		}
+		else
+		{
+			int high = size >> 30;
+			int low = ((size >> 30) << 30) ^ size;
+			emit("rd_a0 ~", b);
+			emit(int2str(high, 10, TRUE), b);
+			emit(" lui\n", b);
+			emit("rd_a0 rs1_a0 !", b);
+			emit(int2str(high, 10, TRUE), b);
+			emit(" addi\n", b);
+			emit("rd_a0 rs1_a0 rs2_x30 slli\n", b);
+			emit("rd_t1 ~", b);
+			emit(int2str(low, 10, TRUE), b);
+			emit(" lui\n", b);
+			emit("rd_t1 rs1_t1 !", b);
+			emit(int2str(low, 10, TRUE), b);
+			emit(" addi\n", b);
+			emit("rd_a0 rs1_a0 rs2_t1 or\n", b);
+		}
+	}
+	emit("\n", b);
+}
+
+void primary_expr_number(char* s)
+{
+	ir_append(IR_CONSTANT, s);
+}
+
+void primary_expr_variable(void)
+{
+	int num_dereference = 0;
+	while(global_token->s[0] == '*') {
+		global_token = global_token->next;
+		require(NULL != global_token, "Walked off the end of a variable dereference\n");
+		num_dereference = num_dereference + 1;
+	}
+	char* s = global_token->s;
+	global_token = global_token->next;
+	struct token_list* a = sym_lookup(s, global_constant_table);
+	if(NULL != a)
+	{
+		constant_load(a->arguments->s);
+		return;
+	}
+
+	a = sym_lookup(s, scope_table);
+	if(NULL != a)
+	{
+		variable_load(a, num_dereference);
+		return;
+	}
+
+	a = sym_lookup(s, global_function_table);
+	if(NULL != a)
+	{
+		function_load(a);
+		return;
+	}
+
+	a = sym_lookup(s, global_symbol_table);
+	if(NULL != a)
+	{
+		global_load(a);
+		return;
+	}
+
+	line_error();
+	fputs(s ,stderr);
+	fputs(" is not a defined symbol\n", stderr);
+	compile_failure();
+}
+
+void primary_expr(void);
+struct type* promote_type(struct type* a, struct type* b)
+{
+	require(NULL != b, "impossible case 1 in promote_type\n");
+	require(NULL != a, "impossible case 2 in promote_type\n");
+
+	if(a == b) return a;
+
+	struct type* i;
+	for(i = global_types; NULL != i; i = i->next)
+	{
+		if(a->name == i->name) break;
+		if(b->name == i->name) break;
+		if(a->name == i->indirect->name) break;
+		if(b->name == i->indirect->name) break;
+		if(a->name == i->indirect->indirect->name) break;
+		if(b->name == i->indirect->indirect->name) break;
+	}
+	require(NULL != i, "impossible case 3 in promote_type\n");
+	return i;
+}
+
+void common_recursion(FUNCTION f)
+{
+	ir_append(IR_PUSH, NULL);
+
+	struct type* last_type = current_target;
+	global_token = global_token->next;
+	require(NULL != global_token, "Received EOF in common_recursion\n");
+	f();
+	current_target = promote_type(current_target, last_type);
+
+	ir_append(IR_POP, NULL);
+}
+
+/*
+ * -O1 constant folding and immediate operands.  ir_operator is called with
+ * the operator about to be emitted; when the expression stack nodes around
+ * it hold constants the work is done here instead.  Constants are only
+ * folded while they fit in 30 bits, so the result means the same thing no
+ * matter how wide int is on the host or the target.
+ */
+int fold_value;
+
+/* s is a number that fits in 30 bits */
+int small_number(char* s)
+{
+	if('-' == s[0]) s = s + 1;
+	if(('0' > s[0]) || ('9' < s[0])) return FALSE;
+	return 10 > string_length(s);
+}
+
+int ir_is_constant(struct ir_node* n)
+{
+	if(NULL == n) return FALSE;
+	if(IR_CONSTANT != n->op) return FALSE;
+	return small_number(n->s);
+}
+
+int fold_operator(char* name, int a, int b, int is_signed)
+{
+	int positive = (0 <= a) && (0 <= b);
+	if(match("+", name)) fold_value = a + b;
+	else if(match("-", name)) fold_value = a - b;
+	else if(match("*", name))
+	{
+		if((46340 < a) || (-46340 > a) || (46340 < b) || (-46340 > b)) return FALSE;
+		fold_value = a * b;
+	}
+	else if(match("/", name))
+	{
+		if(!positive || (0 == b)) return FALSE;
+		fold_value = a / b;
+	}
+	else if(match("%", name))
+	{
+		if(!positive || (0 == b)) return FALSE;
+		fold_value = a % b;
+	}
+	else if(match("<<", name))
+	{
+		if(!positive || (30 < b)) return FALSE;
+		if(a >= (1 << (30 - b))) return FALSE;
+		fold_value = a << b;
+	}
+	else if(match(">>", name))
+	{
+		if((0 > b) || (31 < b) || ((0 > a) && !is_signed)) return FALSE;
+		fold_value = a >> b;
+	}
+	else if(match("&", name)) fold_value = a & b;
+	else if(match("|", name)) fold_value = a | b;
+	else if(match("^", name)) fold_value = a ^ b;
+	else if(match("==", name)) fold_value = (a == b);
+	else if(match("!=", name)) fold_value = (a != b);
+	else if(!is_signed && !positive) return FALSE;
+	else if(match("<", name)) fold_value = (a < b);
+	else if(match("<=", name)) fold_value = (a <= b);
+	else if(match(">=", name)) fold_value = (a >= b);
+	else if(match(">", name)) fold_value = (a > b);
+	else return FALSE;
+	return TRUE;
+}
+
+/* Drop n and every node after it */
+void ir_truncate(struct ir_node* n)
+{
+	ir_tail = n->prev;
+	if(NULL == ir_tail) ir_head = NULL;
+	else ir_tail->next = NULL;
+
+	struct ir_node* i;
+	while(NULL != n)
+	{
+		i = n->next;
+		n->next = ir_free;
+		ir_free = n;
+		n = i;
+	}
+}
+
+/* Unlink the nodes first up to last from the list */
+void ir_unlink(struct ir_node* first, struct ir_node* last)
+{
+	if(NULL == first->prev) ir_head = last->next;
+	else first->prev->next = last->next;
+	if(NULL == last->next) ir_tail = first->prev;
+	else last->next->prev = first->prev;
+	last->next = ir_free;
+	ir_free = first;
+}
+
+/* Everything after the first line of s, the condition part of a compare */
+char* operator_tail(char* s)
+{
+	while('\n' != s[0]) s = s + 1;
+	return s + 1;
+}
+
+int compare_operator(char* name)
+{
+	if(match("<", name)) return TRUE;
+	if(match("<=", name)) return TRUE;
+	if(match(">=", name)) return TRUE;
+	if(match(">", name)) return TRUE;
+	if(match("==", name)) return TRUE;
+	if(match("!=", name)) return TRUE;
+	return match("!", name);
+}
+
+/*
+ * The last length characters emitted turn the comparison name into 0 or 1
+ * (on riscv they are the whole comparison).  They become an IR_COMPARE node,
+ * which condition_jump drops when it can branch on the comparison instead.
+ */
+void compare_record(char* name, int is_signed, int length)
+{
+	ir_text_to(output_list->length - length);
+	struct ir_node* n = ir_new(IR_COMPARE);
+	n->s = name;
+	n->split = is_signed;
+	n->start = ir_mark;
+	n->end = output_list->length;
+	ir_mark = output_list->length;
+}
+
+/* emit_out(s) for the operator name, remembering comparisons under -O1 */
+void operator_out(char* name, char* s, int is_signed)
+{
+	emit_out(s);
+	if(!OPTIMIZE) return;
+	if(!compare_operator(name)) return;
+	if((RISCV32 == Architecture) || (RISCV64 == Architecture)) compare_record(name, is_signed, string_length(s));
+	else compare_record(name, is_signed, string_length(operator_tail(s)));
+}
+
+/* Apply name to the accumulator and the constant b, if the target has a form for it */
+int immediate_operation(char* name, int b, int is_signed, char* s)
+{
+	int sub = match("-", name);
+	if(sub)
+	{
+		name = "+";
+		b = -b;
+	}
+	int add = match("+", name);
+	int shift = match("<<", name) || match(">>", name);
+	int compare = match("<", name) || match("<=", name) || match(">=", name) || match(">", name) || match("==", name) || match("!=", name);
+
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
+	{
+		if(!add || (-32768 >= b) || (32767 <= b)) return FALSE;
+		emit_out("ADDI R0 R0 ");
+		emit_out(int2str(b, 10, TRUE));
+		emit_out("\n");
+	}
+	else if((X86 == Architecture) || (AMD64 == Architecture))
+	{
+		char* op;
+		char* hex;
+		if(add)
+		{
+			op = "add";
+			hex = "05";
+		}
+		else if(match("&", name))
+		{
+			op = "and";
+			hex = "25";
+		}
+		else if(match("|", name))
+		{
+			op = "or";
+			hex = "0D";
+		}
+		else if(match("^", name))
+		{
+			op = "xor";
+			hex = "35";
+		}
+		else if(match("*", name))
+		{
+			op = "imul";
+			hex = "69C0";
+		}
+		else if(compare)
+		{
+			op = "cmp";
+			hex = "3D";
+		}
+		else if(!shift || (0 > b) || (31 < b)) return FALSE;
+		else if(match("<<", name))
+		{
+			op = "shl";
+			hex = "C1E0";
+		}
+		else if(is_signed)
+		{
+			op = "sar";
+			hex = "C1F8";
+		}
+		else
+		{
+			op = "shr";
+			hex = "C1E8";
+		}
+
+		op = concat("O1_", op);
+		if(X86 == Architecture) emit_out(o1_define(concat(op, "_eax,"), hex));
+		else emit_out(o1_define(concat(op, "_rax,"), concat("48", hex)));
+		if(shift) emit_out(" !");
+		else emit_out(" %");
+		emit_out(int2str(b, 10, TRUE));
+		emit_out("\n");
+		if(compare)
+		{
+			emit_out(operator_tail(s));
+			compare_record(name, is_signed, string_length(operator_tail(s)));
+		}
+	}
+	else if(ARMV7L == Architecture)
+	{
+		if(shift)
+		{
+			/* mov r0, r0, lsl/lsr/asr #b, the amount split over two nibbles */
+			if((1 > b) || (31 < b)) return FALSE;
+			int type = 0;
+			if(match(">>", name) && is_signed) type = 2;
+			else if(match(">>", name)) type = 1;
+			emit_out("'");
+			emit_out(int2str(((b & 1) << 3) + (type << 1), 16, FALSE));
+			emit_out("' R0 R0 '");
+			emit_out(int2str(b >> 1, 16, FALSE));
+			emit_out("' SHIFT AUX_ALWAYS\n");
+			return TRUE;
+		}
+
+		char* op;
+		if(add && (0 > b))
+		{
+			op = " R0 SUB R0 ARITH_ALWAYS\n";
+			b = -b;
+		}
+		else if(add) op = " R0 ADD R0 ARITH_ALWAYS\n";
+		else if(match("&", name)) op = " R0 AND R0 ARITH_ALWAYS\n";
+		else if(match("|", name)) op = " R0 OR R0 IMM_ALWAYS\n";
+		else if(match("^", name)) op = " R0 XOR R0 ARITH_ALWAYS\n";
+		else if(compare) op = " CMPI8 R0 IMM_ALWAYS\n";
+		else return FALSE;
+
+		if((0 > b) || (255 < b)) return FALSE;
+		emit_out("!");
+		emit_out(int2str(b, 10, TRUE));
+		emit_out(op);
+		if(compare)
+		{
+			emit_out(operator_tail(s));
+			compare_record(name, is_signed, string_length(operator_tail(s)));
+		}
+	}
+	else if(AARCH64 == Architecture)
+	{
+		if(shift)
+		{
+			if((0 > b) || (63 < b)) return FALSE;
+			if(match("<<", name)) emit_out(o1_word("O1_LSL_X0_X0", b, 0xD3400000 + (((64 - b) & 63) << 16) + ((63 - b) << 10)));
+			else if(is_signed) emit_out(o1_word("O1_ASR_X0_X0", b, 0x9340FC00 + (b << 16)));
+			else emit_out(o1_word("O1_LSR_X0_X0", b, 0xD340FC00 + (b << 16)));
+			emit_out("\n");
+			return TRUE;
+		}
+
+		if(!add && !compare) return FALSE;
+		if((-4095 > b) || (4095 < b)) return FALSE;
+		if(compare)
+		{
+			if(0 > b) return FALSE;
+			emit_out(o1_word("O1_CMP_X0", b, 0xF100001F + (b << 10)));
+		}
+		else if(0 > b) emit_out(o1_word("O1_SUB_X0_X0", -b, 0xD1000000 - (b << 10)));
+		else emit_out(o1_word("O1_ADD_X0_X0", b, 0x91000000 + (b << 10)));
+		emit_out("\n");
+		if(compare)
+		{
+			emit_out(operator_tail(s));
+			compare_record(name, is_signed, string_length(operator_tail(s)));
+		}
+	}
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	{
+		if(shift)
+		{
+			if((0 > b) || (31 < b)) return FALSE;
+			emit_out("rd_a0 rs1_a0 rs2_x");
+			emit_out(int2str(b, 10, TRUE));
+			if(match("<<", name)) emit_out(" slli\n");
+			else if(is_signed) emit_out(" srai\n");
+			else emit_out(" srli\n");
+			return TRUE;
+		}
+
+		char* op;
+		if(add) op = " addi\n";
+		else if(match("&", name)) op = " andi\n";
+		else if(match("|", name)) op = " ori\n";
+		else if(match("^", name)) op = " xori\n";
+		else if(match("<", name) && is_signed) op = " slti\n";
+		else if(match("<", name)) op = " sltiu\n";
+		else return FALSE;
+
+		if((-2048 >= b) || (2047 <= b)) return FALSE;
+		emit_out("rd_a0 rs1_a0 !");
+		emit_out(int2str(b, 10, TRUE));
+		emit_out(op);
+	}
+	else return FALSE;
+	return TRUE;
+}
+
+/* k when value is 1 << k, -1 otherwise */
+int power_of_two(int value)
+{
+	int k = 0;
+	if(0 >= value) return -1;
+	while(0 == (value & 1))
+	{
+		value = value >> 1;
+		k = k + 1;
+	}
+	if(1 == value) return k;
+	return -1;
+}
+
+/*
+ * Like immediate_operation, but multiplies by a power of two become shifts
+ * and unsigned divides and modulos become shifts and masks.  Signed divides
+ * round towards zero, which a shift does not, so they keep the divide.
+ */
+int reduced_operation(char* name, int b, int is_signed, char* s)
+{
+	int k = power_of_two(b);
+	if(0 <= k)
+	{
+		if(match("*", name) || (match("/", name) && !is_signed))
+		{
+			if(0 == k) return TRUE;
+			if(match("*", name))
+			{
+				if(immediate_operation("<<", k, is_signed, s)) return TRUE;
+			}
+			else if(immediate_operation(">>", k, FALSE, s)) return TRUE;
+		}
+		else if(match("%", name) && !is_signed)
+		{
+			if(immediate_operation("&", b - 1, FALSE, s)) return TRUE;
+		}
+	}
+	return immediate_operation(name, b, is_signed, s);
+}
+
+int commutative_operator(char* name)
+{
+	if(match("+", name)) return TRUE;
+	if(match("*", name)) return TRUE;
+	if(match("&", name)) return TRUE;
+	if(match("|", name)) return TRUE;
+	if(match("^", name)) return TRUE;
+	if(match("==", name)) return TRUE;
+	return match("!=", name);
+}
+
+/* The push that goes with the pop at the end of the list */
+struct ir_node* ir_matching_push(struct ir_node* pop)
+{
+	int depth = 0;
+	struct ir_node* i;
+	for(i = pop->prev; NULL != i; i = i->prev)
+	{
+		if(IR_POP == i->op) depth = depth + 1;
+		else if(IR_PUSH == i->op)
+		{
+			if(0 == depth) return i;
+			depth = depth - 1;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * ~, and ! on riscv, have no left operand: the push before the operand
+ * only saves whatever the accumulator held.  ! elsewhere compares the
+ * operand against the 1 loaded right before that push.
+ */
+int ir_unary(char* name)
+{
+	if(match("~", name)) return TRUE;
+	if(!match("!", name)) return FALSE;
+	if(RISCV32 == Architecture) return TRUE;
+	return RISCV64 == Architecture;
+}
+
+/* constant op constant, or a unary operator on a constant */
+int ir_fold(char* name, struct ir_node* push, struct ir_node* b, int is_signed)
+{
+	struct ir_node* a = push->prev;
+	int x = 0;
+	if(ir_unary(name)) a = push;
+	else if(ir_is_constant(a)) x = strtoint(a->s);
+	else return FALSE;
+
+	if(match("!", name)) fold_value = (0 == strtoint(b->s));
+	else if(match("~", name)) fold_value = ~strtoint(b->s);
+	else if(!fold_operator(name, x, strtoint(b->s), is_signed)) return FALSE;
+
+	ir_truncate(a);
+	primary_expr_number(int2str(fold_value, 10, TRUE));
+	return TRUE;
+}
+
+/* Emit s for the operator name, or fold it away under -O1 */
+void ir_operator(char* name, char* s, int is_signed)
+{
+	struct ir_node* pop = ir_tail;
+	struct ir_node* push;
+	struct ir_node* a;
+	if(!OPTIMIZE || (ir_mark != output_list->length) || (NULL == pop))
+	{
+		operator_out(name, s, is_signed);
+		return;
+	}
+	if(IR_POP != pop->op)
+	{
+		operator_out(name, s, is_signed);
+		return;
+	}
+
+	push = ir_matching_push(pop);
+	if(NULL == push)
+	{
+		operator_out(name, s, is_signed);
+		return;
+	}
+
+	if(push->next == pop->prev)
+	{
+		a = pop->prev;
+		if(ir_is_constant(a))
+		{
+			if(ir_fold(name, push, a, is_signed)) return;
+
+			/* anything op constant */
+			if(match("!", name) || match("~", name))
+			{
+				operator_out(name, s, is_signed);
+				return;
+			}
+			if(reduced_operation(name, strtoint(a->s), is_signed, s))
+			{
+				ir_unlink(push, pop);
+				return;
+			}
+		}
+	}
+
+	/* constant op anything */
+	a = push->prev;
+	if(commutative_operator(name) && (pop != push->next) && ir_is_constant(a))
+	{
+		if(reduced_operation(name, strtoint(a->s), is_signed, s))
+		{
+			ir_unlink(a, push);
+			ir_unlink(pop, pop);
+			return;
+		}
+	}
+	operator_out(name, s, is_signed);
+}
+
+void general_recursion(FUNCTION f, char* s, char* name, FUNCTION iterate)
+{
+	require(NULL != global_token, "Received EOF in general_recursion\n");
+	if(match(name, global_token->s))
+	{
+		common_recursion(f);
+		ir_operator(name, s, TRUE);
+		iterate();
+	}
+}
+
+void arithmetic_recursion(FUNCTION f, char* s1, char* s2, char* name, FUNCTION iterate)
+{
+	require(NULL != global_token, "Received EOF in arithmetic_recursion\n");
+	if(match(name, global_token->s))
+	{
+		common_recursion(f);
+		if(NULL == current_target)
+		{
+			ir_operator(name, s1, TRUE);
+		}
+		else if(current_target->is_signed)
+		{
+			ir_operator(name, s1, TRUE);
+		}
+		else
+		{
+			ir_operator(name, s2, FALSE);
+		}
+		iterate();
+	}
+}
+
+
+/*
+ * postfix-expr:
+ *         primary-expr
+ *         postfix-expr [ expression ]
+ *         postfix-expr ( expression-list-opt )
+ *         postfix-expr -> member
+ *         postfix-expr . member
+ */
+struct type* lookup_member(struct type* parent, char* name);
+void postfix_expr_arrow(void)
+{
+	emit_out("# looking up offset\n");
+	global_token = global_token->next;
+	require(NULL != global_token, "naked -> not allowed\n");
+
+	struct type* i = lookup_member(current_target, global_token->s);
+	current_target = i->type;
+	global_token = global_token->next;
+	require(NULL != global_token, "Unterminated -> expression not allowed\n");
+
+	if(0 != i->offset)
+	{
+		emit_out("# -> offset calculation\n");
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
+		{
+			emit_out("ADDUI R0 R0 ");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out("\n");
+		}
+		else if(X86 == Architecture)
+		{
+			emit_out("mov_ebx, %");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out("\nadd_eax,ebx\n");
+		}
+		else if(AMD64 == Architecture)
+		{
+			emit_out("mov_rbx, %");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out("\nadd_rax,rbx\n");
+		}
+		else if(ARMV7L == Architecture)
+		{
+			emit_out("!0 R1 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out("\n'0' R0 R0 ADD R1 ARITH2_ALWAYS\n");
+		}
+		else if(AARCH64 == Architecture)
+		{
+			emit_out("LOAD_W1_AHEAD\nSKIP_32_DATA\n%");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out("\nADD_X0_X1_X0\n");
+		}
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+		{
+			emit_out("rd_a1 !");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out(" addi\n");
+			emit_out("rd_a0 rs1_a1 rs2_a0 add\n");
+		}
+	}
+
+	/* We don't yet support assigning structs to structs */
+	if((!match("=", global_token->s) && !is_compound_assignment(global_token->s) && (register_size >= i->size)))
+	{
+		emit_out(load_value(i->size, i->is_signed));
+	}
+}
+
+void postfix_expr_dot(void)
+{
+	maybe_bootstrap_error("Member access using .");
+	emit_out("# looking up offset\n");
+	global_token = global_token->next;
+	require(NULL != global_token, "naked . not allowed\n");
+
+	struct type* i = lookup_member(current_target, global_token->s);
+	current_target = i->type;
+	global_token = global_token->next;
+	require(NULL != global_token, "Unterminated . expression not allowed\n");
+
+	if(0 != i->offset)
+	{
+		emit_out("# . offset calculation\n");
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
+		{
+			emit_out("ADDUI R0 R0 ");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out("\n");
+		}
+		else if(X86 == Architecture)
+		{
+			emit_out("mov_ebx, %");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out("\nadd_eax,ebx\n");
+		}
+		else if(AMD64 == Architecture)
+		{
+			emit_out("mov_rbx, %");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out("\nadd_rax,rbx\n");
+		}
+		else if(ARMV7L == Architecture)
+		{
+			emit_out("!0 R1 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out("\n'0' R0 R0 ADD R1 ARITH2_ALWAYS\n");
+		}
+		else if(AARCH64 == Architecture)
+		{
+			emit_out("LOAD_W1_AHEAD\nSKIP_32_DATA\n%");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out("\nADD_X0_X1_X0\n");
+		}
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+		{
+			emit_out("rd_a1 !");
+			emit_out(int2str(i->offset, 10, TRUE));
+			emit_out(" addi\n");
+			emit_out("rd_a0 rs1_a1 rs2_a0 add\n");
+		}
+	}
+	if(match("=", global_token->s) || is_compound_assignment(global_token->s)) return;
+	if(match("[", global_token->s)) return;
+
+	emit_out(load_value(current_target->size, current_target->is_signed));
+}
+
+/* Multiply the index in the accumulator by size, keeping the array in the secondary register */
+void array_scale(int size)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("PUSHR R1 R15\nLOADI R1 ");
+	else if(X86 == Architecture) emit_out("push_ebx\nmov_ebx, %");
+	else if(AMD64 == Architecture) emit_out("push_rbx\nmov_rbx, %");
+	else if(ARMV7L == Architecture) emit_out("{R1} PUSH_ALWAYS\n!0 R1 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
+	else if(AARCH64 == Architecture) emit_out("PUSH_X1\nLOAD_W1_AHEAD\nSKIP_32_DATA\n%");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a2 rs1_a1 addi\nrd_a1 !");
+	emit_out(int2str(size, 10, TRUE));
+	if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" addi");
+
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("\nMULU R0 R1 R0\nPOPR R1 R15\n");
+	else if(X86 == Architecture) emit_out("\nmul_ebx\npop_ebx\n");
+	else if(AMD64 == Architecture) emit_out("\nmul_rbx\npop_rbx\n");
+	else if(ARMV7L == Architecture) emit_out("\n'9' R0 '0' R1 MUL R0 ARITH2_ALWAYS\n{R1} POP_ALWAYS\n");
+	else if(AARCH64 == Architecture) emit_out("\nMUL_X0_X1_X0\nPOP_X1\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("\nrd_a0 rs1_a1 rs2_a0 mul\nrd_a1 rs1_a2 addi\n");
+}
+
+/* Add the array in the secondary register to the scaled index */
+char* array_add(void)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "ADD R0 R0 R1\n";
+	else if(X86 == Architecture) return "add_eax,ebx\n";
+	else if(AMD64 == Architecture) return "add_rax,rbx\n";
+	else if(ARMV7L == Architecture) return "'0' R0 R0 ADD R1 ARITH2_ALWAYS\n";
+	else if(AARCH64 == Architecture) return "ADD_X0_X1_X0\n";
+	return "rd_a0 rs1_a1 rs2_a0 add\n";
+}
+
+/*
+ * -O1: scale the index and add it to the array without a multiply when
+ * size is a power of two.  A constant index is scaled here and becomes an
+ * immediate add, x86 and amd64 use a scaled index lea for 2, 4 and 8.
+ */
+void array_index(int size)
+{
+	struct ir_node* pop = ir_tail;
+	struct ir_node* index = pop->prev;
+	int k = power_of_two(size);
+	if((ir_mark == output_list->length) && ir_is_constant(index))
+	{
+		if((IR_PUSH == index->prev->op) && fold_operator("*", strtoint(index->s), size, TRUE))
+		{
+			index->s = int2str(fold_value, 10, TRUE);
+			ir_operator("+", array_add(), TRUE);
+			return;
+		}
+	}
+
+	if((0 < k) && (4 > k) && ((X86 == Architecture) || (AMD64 == Architecture)))
+	{
+		char* scale = concat(concat("*", int2str(size, 10, TRUE)), "]");
+		char* hex = concat("8D04", hex_bytes((k << 6) + 3, 1));
+		if(X86 == Architecture) emit_out(o1_define(concat("O1_lea_eax,[ebx+eax", scale), hex));
+		else emit_out(o1_define(concat("O1_lea_rax,[rbx+rax", scale), concat("48", hex)));
+		emit_out("\n");
+		return;
+	}
+
+	if(0 > k) array_scale(size);
+	else if(0 != k)
+	{
+		if(!immediate_operation("<<", k, FALSE, "")) array_scale(size);
+	}
+	emit_out(array_add());
+}
+
+void postfix_expr_array(void)
+{
+	struct type* array = current_target;
+	common_recursion(expression);
+	current_target = array;
+	require(NULL != current_target, "Arrays only apply to variables\n");
+
+	char* assign = load_value(register_size, current_target->is_signed);
+
+	/* Add support for Ints */
+	if(match("char*", current_target->name))
+	{
+		assign = load_value(1, TRUE);
+		if(OPTIMIZE) array_index(1);
+	}
+	else if(OPTIMIZE) array_index(current_target->type->size);
+	else array_scale(current_target->type->size);
+
+	if(!OPTIMIZE) emit_out(array_add());
+
+	require_match("ERROR in postfix_expr\nMissing ]\n", "]");
+	require(NULL != global_token, "truncated array expression\n");
+
+	if(match("=", global_token->s) || is_compound_assignment(global_token->s) || match(".", global_token->s))
+	{
+		assign = "";
+	}
+	if(match("[", global_token->s))
+	{
+		current_target = current_target->type;
+	}
+
+	emit_out(assign);
+}
+
+/*
+ * unary-expr:
+ *         &postfix-expr
+ *         - postfix-expr
+ *         !postfix-expr
+ *         sizeof ( type )
+ */
+struct type* type_name(void);
+void unary_expr_sizeof(void)
+{
+	global_token = global_token->next;
+	require(NULL != global_token, "Received EOF when starting sizeof\n");
+	require_match("ERROR in unary_expr\nMissing (\n", "(");
+	struct type* a = type_name();
+	require_match("ERROR in unary_expr\nMissing )\n", ")");
+
+	if(OPTIMIZE)
+	{
+		primary_expr_number(int2str(a->size, 10, TRUE));
+		return;
+	}
+
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("LOADUI R0 ");
+	else if(X86 == Architecture) emit_out("mov_eax, %");
+	else if(AMD64 == Architecture) emit_out("mov_rax, %");
+	else if(ARMV7L == Architecture) emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
+	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n%");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 !");
+	emit_out(int2str(a->size, 10, TRUE));
+	if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" addi");
+	emit_out("\n");
 }
 
-char* load_value(unsigned size, int is_signed)
+void postfix_expr_stub(void)
 {
-	if(is_signed) return load_value_signed(size);
-	return load_value_unsigned(size);
+	require(NULL != global_token, "Unexpected EOF, improperly terminated primary expression\n");
+	if(match("[", global_token->s))
+	{
+		postfix_expr_array();
+		postfix_expr_stub();
+	}
+
+	if(match("->", global_token->s))
+	{
+		postfix_expr_arrow();
+		postfix_expr_stub();
+	}
+
+	if(match(".", global_token->s))
+	{
+		postfix_expr_dot();
+		postfix_expr_stub();
+	}
 }
 
-char* store_value(unsigned size)
+void postfix_expr(void)
 {
-	if(size == 1)
+	primary_expr();
+	postfix_expr_stub();
+}
+
+/*
+ * additive-expr:
+ *         postfix-expr
+ *         additive-expr * postfix-expr
+ *         additive-expr / postfix-expr
+ *         additive-expr % postfix-expr
+ *         additive-expr + postfix-expr
+ *         additive-expr - postfix-expr
+ *         additive-expr << postfix-expr
+ *         additive-expr >> postfix-expr
+ */
+void additive_expr_stub_a(void)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "STORE8 R0 R1 0\n";
-		else if(X86 == Architecture) return "mov_[ebx],al\n";
-		else if(AMD64 == Architecture) return "mov_[rbx],al\n";
-		else if(ARMV7L == Architecture) return "!0 R0 STORE8 R1 MEMORY\n";
-		else if(AARCH64 == Architecture) return "STR_BYTE_W0_[X1]\n";
-		else if(RISCV32 == Architecture) return "rs1_a1 rs2_a0 sb\n";
-		else if(RISCV64 == Architecture) return "rs1_a1 rs2_a0 sb\n";
+		arithmetic_recursion(postfix_expr, "MUL R0 R1 R0\n", "MULU R0 R1 R0\n", "*", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "DIV R0 R1 R0\n", "DIVU R0 R1 R0\n", "/", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "MOD R0 R1 R0\n", "MODU R0 R1 R0\n", "%", additive_expr_stub_a);
 	}
-	else if(size == 2)
+	else if(X86 == Architecture)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "STORE16 R0 R1 0\n";
-		else if(X86 == Architecture) return "mov_[ebx],ax\n";
-		else if(AMD64 == Architecture) return "mov_[rbx],ax\n";
-		else if(ARMV7L == Architecture) return "NO_OFFSET R0 STORE16 R1 HALF_MEMORY\n";
-		else if(AARCH64 == Architecture) return "STRH_W0_[X1]\n";
-		else if(RISCV32 == Architecture || RISCV64 == Architecture) return "rs1_a1 rs2_a0 sh\n";
+		arithmetic_recursion(postfix_expr, "imul_ebx\n", "mul_ebx\n", "*", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "xchg_ebx,eax\ncdq\nidiv_ebx\n", "xchg_ebx,eax\nmov_edx, %0\ndiv_ebx\n", "/", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "xchg_ebx,eax\ncdq\nidiv_ebx\nmov_eax,edx\n", "xchg_ebx,eax\nmov_edx, %0\ndiv_ebx\nmov_eax,edx\n", "%", additive_expr_stub_a);
 	}
-	else if(size == 4)
+	else if(AMD64 == Architecture)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "STORE R0 R1 0\n";
-		else if(X86 == Architecture) return "mov_[ebx],eax\n";
-		else if(AMD64 == Architecture) return "mov_[rbx],eax\n";
-		else if(ARMV7L == Architecture) return "!0 R0 STORE32 R1 MEMORY\n";
-		else if(AARCH64 == Architecture) return "STR_W0_[X1]\n";
-		else if(RISCV32 == Architecture || RISCV64 == Architecture) return "rs1_a1 rs2_a0 sw\n";
+		arithmetic_recursion(postfix_expr, "imul_rbx\n", "mul_rbx\n", "*", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "xchg_rbx,rax\ncqo\nidiv_rbx\n", "xchg_rbx,rax\nmov_rdx, %0\ndiv_rbx\n", "/", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "xchg_rbx,rax\ncqo\nidiv_rbx\nmov_rax,rdx\n", "xchg_rbx,rax\nmov_rdx, %0\ndiv_rbx\nmov_rax,rdx\n", "%", additive_expr_stub_a);
 	}
-	else if(size == 8)
+	else if(ARMV7L == Architecture)
 	{
-		if(AMD64 == Architecture) return "mov_[rbx],rax\n";
-		else if(AARCH64 == Architecture) return "STR_X0_[X1]\n";
-		else if(RISCV64 == Architecture) return "rs1_a1 rs2_a0 sd\n";
+		arithmetic_recursion(postfix_expr, "'9' R0 '0' R1 MULS R0 ARITH2_ALWAYS\n", "'9' R0 '0' R1 MUL R0 ARITH2_ALWAYS\n", "*", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "{LR} PUSH_ALWAYS\n^~divides CALL_ALWAYS\n{LR} POP_ALWAYS\n", "{LR} PUSH_ALWAYS\n^~divide CALL_ALWAYS\n{LR} POP_ALWAYS\n", "/", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "{LR} PUSH_ALWAYS\n^~moduluss CALL_ALWAYS\n{LR} POP_ALWAYS\n", "{LR} PUSH_ALWAYS\n^~modulus CALL_ALWAYS\n{LR} POP_ALWAYS\n", "%", additive_expr_stub_a);
+	}
+	else if(AARCH64 == Architecture)
+	{
+		general_recursion(postfix_expr, "MUL_X0_X1_X0\n", "*", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "SDIV_X0_X1_X0\n", "UDIV_X0_X1_X0\n", "/", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "SDIV_X2_X1_X0\nMSUB_X0_X0_X2_X1\n", "UDIV_X2_X1_X0\nMSUB_X0_X0_X2_X1\n", "%", additive_expr_stub_a);
+	}
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	{
+		general_recursion(postfix_expr, "rd_a0 rs1_a1 rs2_a0 mul\n", "*", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "rd_a0 rs1_a1 rs2_a0 div\n", "rd_a0 rs1_a1 rs2_a0 divu\n", "/", additive_expr_stub_a);
+		arithmetic_recursion(postfix_expr, "rd_a0 rs1_a1 rs2_a0 rem\n", "rd_a0 rs1_a1 rs2_a0 remu\n", "%", additive_expr_stub_a);
 	}
-	/* Should not happen but print error message. */
-	fputs("Got unsupported size ", stderr);
-	fputs(int2str(size, 10, TRUE), stderr);
-	fputs(" when storing number in register.\n", stderr);
-	line_error();
-	exit(EXIT_FAILURE);
 }
 
-int is_compound_assignment(char* token)
+
+void additive_expr_a(void)
 {
-	if(match("+=", token)) return TRUE;
-	else if(match("-=", token)) return TRUE;
-	else if(match("*=", token)) return TRUE;
-	else if(match("/=", token)) return TRUE;
-	else if(match("%=", token)) return TRUE;
-	else if(match("<<=", token)) return TRUE;
-	else if(match(">>=", token)) return TRUE;
-	else if(match("&=", token)) return TRUE;
-	else if(match("^=", token)) return TRUE;
-	else if(match("|=", token)) return TRUE;
-	return FALSE;
+	postfix_expr();
+	additive_expr_stub_a();
 }
 
-void postfix_expr_stub(void);
-void variable_load(struct token_list* a, int num_dereference)
+void additive_expr_stub_b(void)
 {
-	require(NULL != global_token, "incomplete variable load received\n");
-	if((match("FUNCTION", a->type->name) || match("FUNCTION*", a->type->name)) && match("(", global_token->s))
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 	{
-		function_call(int2str(a->depth, 10, TRUE), TRUE);
-		return;
+		arithmetic_recursion(additive_expr_a, "ADD R0 R1 R0\n", "ADDU R0 R1 R0\n", "+", additive_expr_stub_b);
+		arithmetic_recursion(additive_expr_a, "SUB R0 R1 R0\n", "SUBU R0 R1 R0\n", "-", additive_expr_stub_b);
 	}
-	current_target = a->type;
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("ADDI R0 R14 ");
-	else if(X86 == Architecture) emit_out("lea_eax,[ebp+DWORD] %");
-	else if(AMD64 == Architecture) emit_out("lea_rax,[rbp+DWORD] %");
-	else if(ARMV7L == Architecture) emit_out("!");
-	else if(AARCH64 == Architecture) emit_out("SET_X0_FROM_BP\nLOAD_W1_AHEAD\nSKIP_32_DATA\n%");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_fp !");
-
-	emit_out(int2str(a->depth, 10, TRUE));
-	if(ARMV7L == Architecture) emit_out(" R0 SUB BP ARITH_ALWAYS");
-	else if(AARCH64 == Architecture) emit_out("\nSUB_X0_X0_X1\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" addi");
-	emit_out("\n");
-
-	if(TRUE == Address_of) return;
-	if(match(".", global_token->s))
+	else if(X86 == Architecture)
 	{
-		postfix_expr_stub();
-		return;
+		arithmetic_recursion(additive_expr_a, "add_eax,ebx\n", "add_eax,ebx\n", "+", additive_expr_stub_b);
+		arithmetic_recursion(additive_expr_a, "sub_ebx,eax\nmov_eax,ebx\n", "sub_ebx,eax\nmov_eax,ebx\n", "-", additive_expr_stub_b);
 	}
-	if(!match("=", global_token->s) && !is_compound_assignment(global_token->s))
+	else if(AMD64 == Architecture)
 	{
-		emit_out(load_value(current_target->size, current_target->is_signed));
+		arithmetic_recursion(additive_expr_a, "add_rax,rbx\n", "add_rax,rbx\n", "+", additive_expr_stub_b);
+		arithmetic_recursion(additive_expr_a, "sub_rbx,rax\nmov_rax,rbx\n", "sub_rbx,rax\nmov_rax,rbx\n", "-", additive_expr_stub_b);
 	}
-
-	while (num_dereference > 0)
+	else if(ARMV7L == Architecture)
 	{
-		current_target = current_target->type;
-		emit_out(load_value(current_target->size, current_target->is_signed));
-		num_dereference = num_dereference - 1;
+		arithmetic_recursion(additive_expr_a, "'0' R0 R0 ADD R1 ARITH2_ALWAYS\n", "'0' R0 R0 ADD R1 ARITH2_ALWAYS\n", "+", additive_expr_stub_b);
+		arithmetic_recursion(additive_expr_a, "'0' R0 R0 SUB R1 ARITH2_ALWAYS\n", "'0' R0 R0 SUB R1 ARITH2_ALWAYS\n", "-", additive_expr_stub_b);
+	}
+	else if(AARCH64 == Architecture)
+	{
+		general_recursion(additive_expr_a, "ADD_X0_X1_X0\n", "+", additive_expr_stub_b);
+		general_recursion(additive_expr_a, "SUB_X0_X1_X0\n", "-", additive_expr_stub_b);
+	}
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	{
+		general_recursion(additive_expr_a, "rd_a0 rs1_a1 rs2_a0 add\n", "+", additive_expr_stub_b);
+		general_recursion(additive_expr_a, "rd_a0 rs1_a1 rs2_a0 sub\n", "-", additive_expr_stub_b);
 	}
 }
 
-void function_load(struct token_list* a)
+
+void additive_expr_b(void)
 {
-	require(NULL != global_token, "incomplete function load\n");
-	if(match("(", global_token->s))
+	additive_expr_a();
+	additive_expr_stub_b();
+}
+
+void additive_expr_stub_c(void)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 	{
-		function_call(a->s, FALSE);
-		return;
+		arithmetic_recursion(additive_expr_b, "SAL R0 R1 R0\n", "SL0 R0 R1 R0\n", "<<", additive_expr_stub_c);
+		arithmetic_recursion(additive_expr_b, "SAR R0 R1 R0\n", "SR0 R0 R1 R0\n", ">>", additive_expr_stub_c);
 	}
-
-	if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture)) emit_out("LOADR R0 4\nJUMP 4\n&FUNCTION_");
-	else if(X86 == Architecture) emit_out("mov_eax, &FUNCTION_");
-	else if(AMD64 == Architecture) emit_out("lea_rax,[rip+DWORD] %FUNCTION_");
-	else if(ARMV7L == Architecture) emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n&FUNCTION_");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n&FUNCTION_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 ~FUNCTION_");
-	emit_out(a->s);
-	if(RISCV32 == Architecture)
+	else if(X86 == Architecture)
 	{
-		emit_out(" auipc\n");
-		emit_out("rd_a0 rs1_a0 !FUNCTION_");
-		emit_out(a->s);
-		emit_out(" addi");
+		arithmetic_recursion(additive_expr_b, "mov_ecx,eax\nmov_eax,ebx\nsal_eax,cl\n", "mov_ecx,eax\nmov_eax,ebx\nshl_eax,cl\n", "<<", additive_expr_stub_c);
+		arithmetic_recursion(additive_expr_b, "mov_ecx,eax\nmov_eax,ebx\nsar_eax,cl\n", "mov_ecx,eax\nmov_eax,ebx\nshr_eax,cl\n", ">>", additive_expr_stub_c);
 	}
-	else if(RISCV64 == Architecture)
+	else if(AMD64 == Architecture)
 	{
-		emit_out(" auipc\n");
-		emit_out("rd_a0 rs1_a0 !FUNCTION_");
-		emit_out(a->s);
-		emit_out(" addiw");
+		arithmetic_recursion(additive_expr_b, "mov_rcx,rax\nmov_rax,rbx\nsal_rax,cl\n", "mov_rcx,rax\nmov_rax,rbx\nshl_rax,cl\n", "<<", additive_expr_stub_c);
+		arithmetic_recursion(additive_expr_b, "mov_rcx,rax\nmov_rax,rbx\nsar_rax,cl\n", "mov_rcx,rax\nmov_rax,rbx\nshr_rax,cl\n", ">>", additive_expr_stub_c);
 	}
-	emit_out("\n");
-}
-
-void global_load(struct token_list* a)
-{
-	current_target = a->type;
-	if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture)) emit_out("LOADR R0 4\nJUMP 4\n&GLOBAL_");
-	else if(X86 == Architecture) emit_out("mov_eax, &GLOBAL_");
-	else if(AMD64 == Architecture) emit_out("lea_rax,[rip+DWORD] %GLOBAL_");
-	else if(ARMV7L == Architecture) emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n&GLOBAL_");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n&GLOBAL_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 ~GLOBAL_");
-	emit_out(a->s);
-	if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	else if(ARMV7L == Architecture)
 	{
-		emit_out(" auipc\n");
-		emit_out("rd_a0 rs1_a0 !GLOBAL_");
-		emit_out(a->s);
-		emit_out(" addi");
+		arithmetic_recursion(additive_expr_b, "LEFT R1 R0 R0 SHIFT AUX_ALWAYS\n", "LEFT R1 R0 R0 SHIFT AUX_ALWAYS\n", "<<", additive_expr_stub_c);
+		arithmetic_recursion(additive_expr_b, "ARITH_RIGHT R1 R0 R0 SHIFT AUX_ALWAYS\n", "RIGHT R1 R0 R0 SHIFT AUX_ALWAYS\n", ">>", additive_expr_stub_c);
 	}
-	emit_out("\n");
-
-	require(NULL != global_token, "unterminated global load\n");
-	if(TRUE == Address_of) return;
-	if(match(".", global_token->s))
+	else if(AARCH64 == Architecture)
 	{
-		postfix_expr_stub();
-		return;
+		general_recursion(additive_expr_b, "LSHIFT_X0_X1_X0\n", "<<", additive_expr_stub_c);
+		arithmetic_recursion(additive_expr_b, "ARITH_RSHIFT_X0_X1_X0\n", "LOGICAL_RSHIFT_X0_X1_X0\n", ">>", additive_expr_stub_c);
+	}
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	{
+		general_recursion(additive_expr_b, "rd_a0 rs1_a1 rs2_a0 sll\n", "<<", additive_expr_stub_c);
+		arithmetic_recursion(additive_expr_b, "rd_a0 rs1_a1 rs2_a0 sra\n", "rd_a0 rs1_a1 rs2_a0 srl\n", ">>", additive_expr_stub_c);
 	}
-	if(match("=", global_token->s) || is_compound_assignment(global_token->s)) return;
-
-	emit_out(load_value(register_size, current_target->is_signed));
 }
 
-/*
- * primary-expr:
- * FAILURE
- * "String"
- * 'Char'
- * [0-9]*
- * [a-z,A-Z]*
- * ( expression )
- */
 
-void primary_expr_failure(void)
+void additive_expr_c(void)
 {
-	require(NULL != global_token, "hit EOF when expecting primary expression\n");
-	line_error();
-	fputs("Received ", stderr);
-	fputs(global_token->s, stderr);
-	fputs(" in primary_expr\n", stderr);
-	exit(EXIT_FAILURE);
+	additive_expr_b();
+	additive_expr_stub_c();
 }
 
-void primary_expr_string(void)
+
+/*
+ * relational-expr:
+ *         additive_expr
+ *         relational-expr < additive_expr
+ *         relational-expr <= additive_expr
+ *         relational-expr >= additive_expr
+ *         relational-expr > additive_expr
+ */
+
+void relational_expr_stub(void)
 {
-	char* number_string = int2str(current_count, 10, TRUE);
-	current_count = current_count + 1;
-	if((KNIGHT_NATIVE == Architecture) || (KNIGHT_POSIX == Architecture)) emit_out("LOADR R0 4\nJUMP 4\n&STRING_");
-	else if(X86 == Architecture) emit_out("mov_eax, &STRING_");
-	else if(AMD64 == Architecture) emit_out("lea_rax,[rip+DWORD] %STRING_");
-	else if(ARMV7L == Architecture) emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n&STRING_");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n&STRING_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 ~STRING_");
-	uniqueID_out(function->s, number_string);
-	if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 	{
-		emit_out("auipc\n");
-		emit_out("rd_a0 rs1_a0 !STRING_");
-		uniqueID_out(function->s, number_string);
-		emit_out("addi\n");
+		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.L R0 R0 1\n", "CMPU R0 R1 R0\nSET.L R0 R0 1\n", "<", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.LE R0 R0 1\n", "CMPU R0 R1 R0\nSET.LE R0 R0 1\n", "<=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.GE R0 R0 1\n", "CMPU R0 R1 R0\nSET.GE R0 R0 1\n", ">=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.G R0 R0 1\n", "CMPU R0 R1 R0\nSET.G R0 R0 1\n", ">", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.E R0 R0 1\n", "CMPU R0 R1 R0\nSET.E R0 R0 1\n", "==", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.NE R0 R0 1\n", "CMPU R0 R1 R0\nSET.NE R0 R0 1\n", "!=", relational_expr_stub);
 	}
-
-	/* The target */
-	strings_list = emit(":STRING_", strings_list);
-	strings_list = uniqueID(function->s, strings_list, number_string);
-
-	/* catch case of just "foo" from segfaulting */
-	require(NULL != global_token->next, "a string by itself is not valid C\n");
-
-	/* Parse the string */
-	if('"' != global_token->next->s[0])
+	else if(X86 == Architecture)
 	{
-		strings_list = emit(parse_string(global_token->s), strings_list);
-		global_token = global_token->next;
+		arithmetic_recursion(additive_expr_c, "cmp\nsetl_al\nmovzx_eax,al\n", "cmp\nsetb_al\nmovzx_eax,al\n", "<", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "cmp\nsetle_al\nmovzx_eax,al\n", "cmp\nsetbe_al\nmovzx_eax,al\n", "<=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "cmp\nsetge_al\nmovzx_eax,al\n", "cmp\nsetae_al\nmovzx_eax,al\n", ">=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "cmp\nsetg_al\nmovzx_eax,al\n", "cmp\nseta_al\nmovzx_eax,al\n", ">", relational_expr_stub);
+		general_recursion(additive_expr_c, "cmp\nsete_al\nmovzx_eax,al\n", "==", relational_expr_stub);
+		general_recursion(additive_expr_c, "cmp\nsetne_al\nmovzx_eax,al\n", "!=", relational_expr_stub);
 	}
-	else
+	else if(AMD64 == Architecture)
 	{
-		char* s = calloc(MAX_STRING, sizeof(char));
-
-		/* prefix leading string */
-		s[0] = '"';
-		int i = 1;
-
-		int j;
-		while('"' == global_token->s[0])
-		{
-			/* Step past the leading '"' */
-			j = 1;
-
-			/* Copy the rest of the string as is */
-			while(0 != global_token->s[j])
-			{
-				require(i < MAX_STRING, "concat string exceeded max string length\n");
-				s[i] = global_token->s[j];
-				i = i + 1;
-				j = j + 1;
-			}
-
-			/* Move on to the next token */
-			global_token = global_token->next;
-			require(NULL != global_token, "multi-string null is not valid C\n");
-		}
-
-		/* Now use it */
-		strings_list = emit(parse_string(s), strings_list);
+		arithmetic_recursion(additive_expr_c, "cmp_rbx,rax\nsetl_al\nmovzx_rax,al\n", "cmp_rbx,rax\nsetb_al\nmovzx_rax,al\n", "<", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "cmp_rbx,rax\nsetle_al\nmovzx_rax,al\n", "cmp_rbx,rax\nsetbe_al\nmovzx_rax,al\n", "<=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "cmp_rbx,rax\nsetge_al\nmovzx_rax,al\n", "cmp_rbx,rax\nsetae_al\nmovzx_rax,al\n", ">=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "cmp_rbx,rax\nsetg_al\nmovzx_rax,al\n", "cmp_rbx,rax\nseta_al\nmovzx_rax,al\n", ">", relational_expr_stub);
+		general_recursion(additive_expr_c, "cmp_rbx,rax\nsete_al\nmovzx_rax,al\n", "==", relational_expr_stub);
+		general_recursion(additive_expr_c, "cmp_rbx,rax\nsetne_al\nmovzx_rax,al\n", "!=", relational_expr_stub);
+	}
+	else if(ARMV7L == Architecture)
+	{
+		arithmetic_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_L\n", "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_LO\n", "<", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_LE\n", "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_LS\n", "<=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_GE\n", "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_HS\n", ">=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_G\n", "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_HI\n", ">", relational_expr_stub);
+		general_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_EQUAL\n", "==", relational_expr_stub);
+		general_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_NE\n", "!=", relational_expr_stub);
+	}
+	else if(AARCH64 == Architecture)
+	{
+		arithmetic_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_LT\nSET_X0_TO_0\n", "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_LO\nSET_X0_TO_0\n", "<", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_LE\nSET_X0_TO_0\n", "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_LS\nSET_X0_TO_0\n", "<=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_GE\nSET_X0_TO_0\n", "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_HS\nSET_X0_TO_0\n", ">=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_GT\nSET_X0_TO_0\n", "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_HI\nSET_X0_TO_0\n", ">", relational_expr_stub);
+		general_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_EQ\nSET_X0_TO_0\n", "==", relational_expr_stub);
+		general_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_NE\nSET_X0_TO_0\n", "!=", relational_expr_stub);
+	}
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	{
+		arithmetic_recursion(additive_expr_c, "rd_a0 rs1_a1 rs2_a0 slt\n", "rd_a0 rs1_a1 rs2_a0 sltu\n", "<", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "rd_a0 rs1_a0 rs2_a1 slt\nrd_a0 rs1_a0 !1 xori\n", "rd_a0 rs1_a0 rs2_a1 sltu\nrd_a0 rs1_a0 !1 xori\n", "<=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "rd_a0 rs1_a1 rs2_a0 slt\nrd_a0 rs1_a0 !1 xori\n", "rd_a0 rs1_a1 rs2_a0 sltu\nrd_a0 rs1_a0 !1 xori\n", ">=", relational_expr_stub);
+		arithmetic_recursion(additive_expr_c, "rd_a0 rs1_a0 rs2_a1 slt\n", "rd_a0 rs1_a0 rs2_a1 sltu\n", ">", relational_expr_stub);
+		general_recursion(additive_expr_c, "rd_a0 rs1_a0 rs2_a1 sub\nrd_a0 rs1_a0 !1 sltiu\n", "==", relational_expr_stub);
+		general_recursion(additive_expr_c, "rd_a0 rs1_a0 rs2_a1 sub\nrd_a0 rs2_a0 sltu\n", "!=", relational_expr_stub);
 	}
 }
 
-void primary_expr_char(void)
-{
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("LOADI R0 ");
-	else if(X86 == Architecture) emit_out("mov_eax, %");
-	else if(AMD64 == Architecture) emit_out("mov_rax, %");
-	else if(ARMV7L == Architecture) emit_out("!");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n%");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 !");
-	emit_out(int2str(escape_lookup(global_token->s + 1), 10, TRUE));
-	if(ARMV7L == Architecture) emit_out(" R0 LOADI8_ALWAYS");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" addi");
-	emit_out("\n");
-	global_token = global_token->next;
-}
-
-int hex2char(int c)
+void relational_expr(void)
 {
-	if((c >= 0) && (c <= 9)) return (c + 48);
-	else if((c >= 10) && (c <= 15)) return (c + 55);
-	else return -1;
+	additive_expr_c();
+	relational_expr_stub();
 }
 
-char* number_to_hex(int a, int bytes)
+/*
+ * bitwise-expr:
+ *         relational-expr
+ *         bitwise-expr & bitwise-expr
+ *         bitwise-expr | bitwise-expr
+ *         bitwise-expr ^ bitwise-expr
+ */
+void bitwise_expr_stub(void)
 {
-	require(bytes > 0, "number to hex must have a positive number of bytes greater than zero\n");
-	char* result = calloc(1 + (bytes << 1), sizeof(char));
-	if(NULL == result)
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 	{
-		fputs("calloc failed in number_to_hex\n", stderr);
-		exit(EXIT_FAILURE);
+		general_recursion(relational_expr, "AND R0 R0 R1\n", "&", bitwise_expr_stub);
+		general_recursion(relational_expr, "OR R0 R0 R1\n", "|", bitwise_expr_stub);
+		general_recursion(relational_expr, "XOR R0 R0 R1\n", "^", bitwise_expr_stub);
 	}
-	int i = 0;
-
-	int divisor = (bytes << 3);
-	require(divisor > 0, "unexpected wrap around in number_to_hex\n");
-
-	/* Simply collect numbers until divisor is gone */
-	while(0 != divisor)
+	else if(X86 == Architecture)
 	{
-		divisor = divisor - 4;
-		result[i] = hex2char((a >> divisor) & 0xF);
-		i = i + 1;
+		general_recursion(relational_expr, "and_eax,ebx\n", "&", bitwise_expr_stub);
+		general_recursion(relational_expr, "or_eax,ebx\n", "|", bitwise_expr_stub);
+		general_recursion(relational_expr, "xor_eax,ebx\n", "^", bitwise_expr_stub);
+	}
+	else if(AMD64 == Architecture)
+	{
+		general_recursion(relational_expr, "and_rax,rbx\n", "&", bitwise_expr_stub);
+		general_recursion(relational_expr, "or_rax,rbx\n", "|", bitwise_expr_stub);
+		general_recursion(relational_expr, "xor_rax,rbx\n", "^", bitwise_expr_stub);
+	}
+	else if(ARMV7L == Architecture)
+	{
+		general_recursion(relational_expr, "NO_SHIFT R0 R0 AND R1 ARITH2_ALWAYS\n", "&", bitwise_expr_stub);
+		general_recursion(relational_expr, "NO_SHIFT R0 R0 OR R1 AUX_ALWAYS\n", "|", bitwise_expr_stub);
+		general_recursion(relational_expr, "'0' R0 R0 XOR R1 ARITH2_ALWAYS\n", "^", bitwise_expr_stub);
+	}
+	else if(AARCH64 == Architecture)
+	{
+		general_recursion(relational_expr, "AND_X0_X1_X0\n", "&", bitwise_expr_stub);
+		general_recursion(relational_expr, "OR_X0_X1_X0\n", "|", bitwise_expr_stub);
+		general_recursion(relational_expr, "XOR_X0_X1_X0\n", "^", bitwise_expr_stub);
+	}
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	{
+		general_recursion(relational_expr, "rd_a0 rs1_a1 rs2_a0 and\n", "&", bitwise_expr_stub);
+		general_recursion(relational_expr, "rd_a0 rs1_a1 rs2_a0 or\n", "|", bitwise_expr_stub);
+		general_recursion(relational_expr, "rd_a0 rs1_a1 rs2_a0 xor\n", "^", bitwise_expr_stub);
 	}
+}
 
-	return result;
+
+void bitwise_expr(void)
+{
+	relational_expr();
+	bitwise_expr_stub();
 }
 
-void primary_expr_number(char* s)
+/* Jump to label when R0 is zero (or nonzero) */
+void jump_on_zero(char* label, int zero)
 {
 	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 	{
-		int size = strtoint(s);
-		if((32767 > size) && (size > -32768))
-		{
-			emit_out("LOADI R0 ");
-			emit_out(s);
-		}
-		else
-		{
-			emit_out("LOADR R0 4\nJUMP 4\n'");
-			emit_out(number_to_hex(size, register_size));
-			emit_out("'");
-		}
+		if(zero) emit_out("JUMP.Z R0 @");
+		else emit_out("JUMP.NZ R0 @");
 	}
 	else if(X86 == Architecture)
 	{
-		emit_out("mov_eax, %");
-		emit_out(s);
+		if(zero) emit_out("test_eax,eax\nje %");
+		else emit_out("test_eax,eax\njne %");
 	}
 	else if(AMD64 == Architecture)
 	{
-		emit_out("mov_rax, %");
-		emit_out(s);
-	}
-	else if(ARMV7L == Architecture)
-	{
-		emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
-		emit_out(s);
+		if(zero) emit_out("test_rax,rax\nje %");
+		else emit_out("test_rax,rax\njne %");
 	}
+	else if(ARMV7L == Architecture) emit_out("!0 CMPI8 R0 IMM_ALWAYS\n^~");
 	else if(AARCH64 == Architecture)
 	{
-		emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n%");
-		emit_out(s);
+		if(zero) emit_out("CBNZ_X0_PAST_BR\nLOAD_W16_AHEAD\nSKIP_32_DATA\n&");
+		else emit_out("CBZ_X0_PAST_BR\nLOAD_W16_AHEAD\nSKIP_32_DATA\n&");
 	}
 	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
 	{
-		int size = strtoint(s);
-		if((2047 > size) && (size > -2048))
-		{
-			emit_out("rd_a0 !");
-			emit_out(s);
-			emit_out(" addi");
-		}
-		else if (0 == (size >> 30))
-		{
-			emit_out("rd_a0 ~");
-			emit_out(s);
-			emit_out(" lui\n");
-			emit_out("rd_a0 rs1_a0 !");
-			emit_out(s);
-			emit_out(" addi");
-		}
-		else
-		{
-			int high = size >> 30;
-			int low = ((size >> 30) << 30) ^ size;
-			emit_out("rd_a0 ~");
-			emit_out(int2str(high, 10, TRUE));
-			emit_out(" lui\n");
-			emit_out("rd_a0 rs1_a0 !");
-			emit_out(int2str(high, 10, TRUE));
-			emit_out(" addi\n");
-			emit_out("rd_a0 rs1_a0 rs2_x30 slli\n");
-			emit_out("rd_t1 ~");
-			emit_out(int2str(low, 10, TRUE));
-			emit_out(" lui\n");
-			emit_out("rd_t1 rs1_t1 !");
-			emit_out(int2str(low, 10, TRUE));
-			emit_out(" addi\n");
-			emit_out("rd_a0 rs1_a0 rs2_t1 or\n");
-		}
+		if(zero) emit_out("rs1_a0 @8 bnez\n$");
+		else emit_out("rs1_a0 @8 beqz\n$");
+	}
+
+	emit_out(label);
+	if(ARMV7L == Architecture)
+	{
+		if(zero) emit_out(" JUMP_EQUAL");
+		else emit_out(" JUMP_NE");
 	}
+	else if(AARCH64 == Architecture) emit_out("\nBR_X16");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" jal");
 	emit_out("\n");
 }
 
-void primary_expr_variable(void)
+/*
+ * Condition codes in the AArch64 numbering, which armv7l shares and where
+ * flipping the low bit negates the condition.
+ */
+int compare_condition(char* name, int is_signed)
+{
+	if(match("==", name)) return 0;
+	if(match("!=", name)) return 1;
+	/* !x is computed as 1 > x unsigned */
+	if(match("!", name)) return 8;
+	if(is_signed)
+	{
+		if(match(">=", name)) return 10;
+		if(match("<", name)) return 11;
+		if(match(">", name)) return 12;
+		return 13;
+	}
+	if(match(">=", name)) return 2;
+	if(match("<", name)) return 3;
+	if(match(">", name)) return 8;
+	return 9;
+}
+
+/* The ARM name of condition cond */
+char* condition_name(int cond)
 {
-	int num_dereference = 0;
-	while(global_token->s[0] == '*') {
-		global_token = global_token->next;
-		require(NULL != global_token, "Walked off the end of a variable dereference\n");
-		num_dereference = num_dereference + 1;
-	}
-	char* s = global_token->s;
-	global_token = global_token->next;
-	struct token_list* a = sym_lookup(s, global_constant_list);
-	if(NULL != a)
+	if(0 == cond) return "EQ";
+	else if(1 == cond) return "NE";
+	else if(2 == cond) return "HS";
+	else if(3 == cond) return "LO";
+	else if(8 == cond) return "HI";
+	else if(9 == cond) return "LS";
+	else if(10 == cond) return "GE";
+	else if(11 == cond) return "LT";
+	else if(12 == cond) return "GT";
+	return "LE";
+}
+
+/* Branch to label when condition cond holds for the flags, or on riscv for a1 and a0 */
+void compare_branch(char* label, int cond)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 	{
-		constant_load(a->arguments->s);
-		return;
+		if(0 == cond) emit_out("JUMP.E R0 @");
+		else if(1 == cond) emit_out("JUMP.NE R0 @");
+		else if((2 == cond) || (10 == cond)) emit_out("JUMP.GE R0 @");
+		else if((3 == cond) || (11 == cond)) emit_out("JUMP.L R0 @");
+		else if((8 == cond) || (12 == cond)) emit_out("JUMP.G R0 @");
+		else emit_out("JUMP.LE R0 @");
+	}
+	else if((X86 == Architecture) || (AMD64 == Architecture))
+	{
+		if(0 == cond) emit_out("je %");
+		else if(1 == cond) emit_out("jne %");
+		else if(2 == cond) emit_out(o1_define("O1_jae", "0F83"));
+		else if(3 == cond) emit_out(o1_define("O1_jb", "0F82"));
+		else if(8 == cond) emit_out(o1_define("O1_ja", "0F87"));
+		else if(9 == cond) emit_out(o1_define("O1_jbe", "0F86"));
+		else if(10 == cond) emit_out(o1_define("O1_jge", "0F8D"));
+		else if(11 == cond) emit_out(o1_define("O1_jl", "0F8C"));
+		else if(12 == cond) emit_out(o1_define("O1_jg", "0F8F"));
+		else emit_out(o1_define("O1_jle", "0F8E"));
+		if(1 < cond) emit_out(" %");
 	}
-
-	a = sym_lookup(s, function->locals);
-	if(NULL != a)
+	else if(ARMV7L == Architecture) emit_out("^~");
+	else if(AARCH64 == Architecture)
 	{
-		variable_load(a, num_dereference);
-		return;
+		/* b.cond over the four instructions of the far jump when it does not hold */
+		emit_out(o1_define(concat("O1_SKIP_4_INST_", condition_name(cond ^ 1)), hex_bytes(0x540000A0 + (cond ^ 1), 4)));
+		emit_out("\nLOAD_W16_AHEAD\nSKIP_32_DATA\n&");
 	}
-
-	a = sym_lookup(s, function->arguments);
-	if(NULL != a)
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
 	{
-		variable_load(a, num_dereference);
-		return;
+		/* Branch over the jal when it does not hold */
+		cond = cond ^ 1;
+		if(0 == cond) emit_out("rs1_a1 rs2_a0 @8 beq\n$");
+		else if(1 == cond) emit_out("rs1_a1 rs2_a0 @8 bne\n$");
+		else if(2 == cond) emit_out("rs1_a1 rs2_a0 @8 bgeu\n$");
+		else if(3 == cond) emit_out("rs1_a1 rs2_a0 @8 bltu\n$");
+		else if(8 == cond) emit_out("rs1_a0 rs2_a1 @8 bltu\n$");
+		else if(9 == cond) emit_out("rs1_a0 rs2_a1 @8 bgeu\n$");
+		else if(10 == cond) emit_out("rs1_a1 rs2_a0 @8 bge\n$");
+		else if(11 == cond) emit_out("rs1_a1 rs2_a0 @8 blt\n$");
+		else if(12 == cond) emit_out("rs1_a0 rs2_a1 @8 blt\n$");
+		else emit_out("rs1_a0 rs2_a1 @8 bge\n$");
+	}
+
+	emit_out(label);
+	if(ARMV7L == Architecture)
+	{
+		if(0 == cond) emit_out(" JUMP_EQUAL");
+		else if(1 == cond) emit_out(" JUMP_NE");
+		else
+		{
+			emit_out(" ");
+			emit_out(o1_define(concat("O1_JUMP_", condition_name(cond)), hex_bytes((cond << 4) + 10, 1)));
+		}
 	}
+	else if(AARCH64 == Architecture) emit_out("\nBR_X16");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" jal");
+	emit_out("\n");
+}
 
-	a = sym_lookup(s, global_function_list);
-	if(NULL != a)
+/*
+ * Jump to label when the condition just computed is zero (or nonzero).  Under
+ * -O1 a comparison that was only turned into 0 or 1 for this test branches on
+ * its own result instead.
+ */
+void condition_jump(char* label, int zero)
+{
+	struct ir_node* n = ir_tail;
+	if(!OPTIMIZE || (ir_mark != output_list->length)) n = NULL;
+	else if(NULL != n)
 	{
-		function_load(a);
-		return;
+		if(IR_COMPARE != n->op) n = NULL;
 	}
-
-	a = sym_lookup(s, global_symbol_list);
-	if(NULL != a)
+	if(NULL == n)
 	{
-		global_load(a);
+		jump_on_zero(label, zero);
 		return;
 	}
 
-	line_error();
-	fputs(s ,stderr);
-	fputs(" is not a defined symbol\n", stderr);
-	exit(EXIT_FAILURE);
+	char* name = n->s;
+	int cond = compare_condition(name, n->split);
+	if(zero) cond = cond ^ 1;
+	ir_truncate(n);
+
+	/* riscv has no flags, !x just tests x itself */
+	int riscv = (RISCV32 == Architecture) || (RISCV64 == Architecture);
+	if(riscv && match("!", name)) jump_on_zero(label, 8 == cond);
+	else compare_branch(label, cond);
 }
 
-void primary_expr(void);
-struct type* promote_type(struct type* a, struct type* b)
+/*
+ * logical-and-expr:
+ *         bitwise-expr
+ *         logical-and-expr && bitwise-expr
+ *
+ * logical-or-expr:
+ *         logical-and-expr
+ *         logical-or-expr || logical-and-expr
+ *
+ * The right operand is skipped once the left one decides the result, every
+ * operand of a chain jumps to the same label and the result becomes 0 or 1.
+ */
+void logical_recursion(FUNCTION f, char* name, int zero)
 {
-	require(NULL != b, "impossible case 1 in promote_type\n");
-	require(NULL != a, "impossible case 2 in promote_type\n");
+	require(NULL != global_token, "Received EOF in logical_recursion\n");
+	if(!match(name, global_token->s)) return;
 
-	if(a == b) return a;
+	char* number_string = int2str(current_count, 10, TRUE);
+	current_count = current_count + 1;
+	char* label = label_name("_LOGICAL_END_", function->s, number_string);
 
-	struct type* i;
-	for(i = global_types; NULL != i; i = i->next)
+	/* The aarch64 jumps go through X16, which may hold a call frame */
+	if(AARCH64 == Architecture) emit_out("PUSH_X16\t# Protect the call frame register\n");
+
+	while(match(name, global_token->s))
 	{
-		if(a->name == i->name) break;
-		if(b->name == i->name) break;
-		if(a->name == i->indirect->name) break;
-		if(b->name == i->indirect->name) break;
-		if(a->name == i->indirect->indirect->name) break;
-		if(b->name == i->indirect->indirect->name) break;
-	}
-	require(NULL != i, "impossible case 3 in promote_type\n");
-	return i;
+		jump_on_zero(label, zero);
+		global_token = global_token->next;
+		require(NULL != global_token, "Received EOF where a logical operand was expected\n");
+		f();
+		require(NULL != global_token, "Received EOF in logical_recursion\n");
+	}
+	ir_label(label);
+
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("LOADI R1 0\nCMPU R0 R1 R0\nSET.NE R0 R0 1\n");
+	else if(X86 == Architecture) emit_out("test_eax,eax\nsetne_al\nmovzx_eax,al\n");
+	else if(AMD64 == Architecture) emit_out("test_rax,rax\nsetne_al\nmovzx_rax,al\n");
+	else if(ARMV7L == Architecture) emit_out("!0 CMPI8 R0 IMM_ALWAYS\n!1 R0 LOADI8_NE\n");
+	else if(AARCH64 == Architecture) emit_out("SET_X1_FROM_X0\nSET_X0_TO_0\nCMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_NE\nSET_X0_TO_0\nPOP_X16\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs2_a0 sltu\n");
 }
 
-void common_recursion(FUNCTION f)
+void logical_and_expr(void)
 {
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("PUSHR R0 R15\t#_common_recursion\n");
-	else if(X86 == Architecture) emit_out("push_eax\t#_common_recursion\n");
-	else if(AMD64 == Architecture) emit_out("push_rax\t#_common_recursion\n");
-	else if(ARMV7L == Architecture) emit_out("{R0} PUSH_ALWAYS\t#_common_recursion\n");
-	else if(AARCH64 == Architecture) emit_out("PUSH_X0\t#_common_recursion\n");
-	else if(RISCV32 == Architecture) emit_out("rd_sp rs1_sp !-4 addi\t# _common_recursion\nrs1_sp rs2_a0 sw\n");
-	else if(RISCV64 == Architecture) emit_out("rd_sp rs1_sp !-8 addi\t# _common_recursion\nrs1_sp rs2_a0 sd\n");
-
-	struct type* last_type = current_target;
-	global_token = global_token->next;
-	require(NULL != global_token, "Received EOF in common_recursion\n");
-	f();
-	current_target = promote_type(current_target, last_type);
+	bitwise_expr();
+	logical_recursion(bitwise_expr, "&&", TRUE);
+}
 
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("POPR R1 R15\t# _common_recursion\n");
-	else if(X86 == Architecture) emit_out("pop_ebx\t# _common_recursion\n");
-	else if(AMD64 == Architecture) emit_out("pop_rbx\t# _common_recursion\n");
-	else if(ARMV7L == Architecture) emit_out("{R1} POP_ALWAYS\t# _common_recursion\n");
-	else if(AARCH64 == Architecture) emit_out("POP_X1\t# _common_recursion\n");
-	else if(RISCV32 == Architecture) emit_out("rd_a1 rs1_sp lw\nrd_sp rs1_sp !4 addi\t# _common_recursion\n");
-	else if(RISCV64 == Architecture) emit_out("rd_a1 rs1_sp ld\nrd_sp rs1_sp !8 addi\t# _common_recursion\n");
+void logical_or_expr(void)
+{
+	logical_and_expr();
+	logical_recursion(logical_and_expr, "||", FALSE);
 }
 
-void general_recursion(FUNCTION f, char* s, char* name, FUNCTION iterate)
+/*
+ * expression:
+ *         logical-or-expr
+ *         logical-or-expr = expression
+ */
+
+void primary_expr(void)
 {
-	require(NULL != global_token, "Received EOF in general_recursion\n");
-	if(match(name, global_token->s))
+	require(NULL != global_token, "Received EOF where primary expression expected\n");
+	if(match("&", global_token->s))
 	{
-		common_recursion(f);
-		emit_out(s);
-		iterate();
+		Address_of = TRUE;
+		global_token = global_token->next;
+		require(NULL != global_token, "Received EOF after & where primary expression expected\n");
+	}
+	else
+	{
+		Address_of = FALSE;
+	}
+
+	if(match("sizeof", global_token->s)) unary_expr_sizeof();
+	else if('-' == global_token->s[0])
+	{
+		if(OPTIMIZE) primary_expr_number("0");
+		else if(X86 == Architecture) emit_out("mov_eax, %0\n");
+		else if(AMD64 == Architecture) emit_out("mov_rax, %0\n");
+		else if(ARMV7L == Architecture) emit_out("!0 R0 LOADI8_ALWAYS\n");
+		else if(AARCH64 == Architecture) emit_out("SET_X0_TO_0\n");
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 mv\n");
+
+		common_recursion(primary_expr);
+
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) ir_operator("-", "NEG R0 R0\n", TRUE);
+		else if(X86 == Architecture) ir_operator("-", "sub_ebx,eax\nmov_eax,ebx\n", TRUE);
+		else if(AMD64 == Architecture) ir_operator("-", "sub_rbx,rax\nmov_rax,rbx\n", TRUE);
+		else if(ARMV7L == Architecture) ir_operator("-", "'0' R0 R0 SUB R1 ARITH2_ALWAYS\n", TRUE);
+		else if(AARCH64 == Architecture) ir_operator("-", "SUB_X0_X1_X0\n", TRUE);
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) ir_operator("-", "rd_a0 rs1_a1 rs2_a0 sub\n", TRUE);
+	}
+	else if('!' == global_token->s[0])
+	{
+		if(OPTIMIZE && (RISCV32 != Architecture) && (RISCV64 != Architecture)) primary_expr_number("1");
+		else if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))  emit_out("LOADI R0 1\n");
+		else if(X86 == Architecture) emit_out("mov_eax, %1\n");
+		else if(AMD64 == Architecture) emit_out("mov_rax, %1\n");
+		else if(ARMV7L == Architecture) emit_out("!1 R0 LOADI8_ALWAYS\n");
+		else if(AARCH64 == Architecture) emit_out("SET_X0_TO_1\n");
+
+		common_recursion(postfix_expr);
+
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) ir_operator("!", "CMPU R0 R1 R0\nSET.G R0 R0 1\n", TRUE);
+		else if(X86 == Architecture) ir_operator("!", "cmp\nseta_al\nmovzx_eax,al\n", TRUE);
+		else if(AMD64 == Architecture) ir_operator("!", "cmp_rbx,rax\nseta_al\nmovzx_rax,al\n", TRUE);
+		else if(ARMV7L == Architecture) ir_operator("!", "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_HI\n", TRUE);
+		else if(AARCH64 == Architecture) ir_operator("!", "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_HI\nSET_X0_TO_0\n", TRUE);
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) ir_operator("!", "rd_a0 rs1_a0 !1 sltiu\n", TRUE);
+	}
+	else if('~' == global_token->s[0])
+	{
+		common_recursion(postfix_expr);
+
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) ir_operator("~", "NOT R0 R0\n", TRUE);
+		else if(X86 == Architecture) ir_operator("~", "not_eax\n", TRUE);
+		else if(AMD64 == Architecture) ir_operator("~", "not_rax\n", TRUE);
+		else if(ARMV7L == Architecture) ir_operator("~", "'0' R0 R0 MVN_ALWAYS\n", TRUE);
+		else if(AARCH64 == Architecture) ir_operator("~", "MVN_X0\n", TRUE);
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) ir_operator("~", "rd_a0 rs1_a0 not\n", TRUE);
+	}
+	else if(global_token->s[0] == '(')
+	{
+		global_token = global_token->next;
+		expression();
+		require_match("Error in Primary expression\nDidn't get )\n", ")");
+	}
+	else if(TOKEN_CHAR == global_token->kind) primary_expr_char();
+	else if(TOKEN_STRING == global_token->kind) primary_expr_string();
+	else if(TOKEN_IDENTIFIER == global_token->kind) primary_expr_variable();
+	else if(TOKEN_KEYWORD == global_token->kind) primary_expr_variable();
+	else if(global_token->s[0] == '*') primary_expr_variable();
+	else if(TOKEN_NUMBER == global_token->kind)
+	{
+		primary_expr_number(global_token->s);
+		global_token = global_token->next;
 	}
+	else primary_expr_failure();
 }
 
-void arithmetic_recursion(FUNCTION f, char* s1, char* s2, char* name, FUNCTION iterate)
+char* compound_operation(char* operator, int is_signed)
 {
-	require(NULL != global_token, "Received EOF in arithmetic_recursion\n");
-	if(match(name, global_token->s))
+	char* operation = "";
+	if(match("+=", operator))
 	{
-		common_recursion(f);
-		if(NULL == current_target)
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 		{
-			emit_out(s1);
+			if(is_signed) operation = "ADD R0 R1 R0\n";
+			else operation = "ADDU R0 R1 R0\n";
 		}
-		else if(current_target->is_signed)
+		else if(X86 == Architecture) operation = "add_eax,ebx\n";
+		else if(AMD64 == Architecture) operation = "add_rax,rbx\n";
+		else if(ARMV7L == Architecture) operation = "'0' R0 R0 ADD R1 ARITH2_ALWAYS\n";
+		else if(AARCH64 == Architecture) operation = "ADD_X0_X1_X0\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 add\n";
+	}
+	else if(match("-=", operator))
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 		{
-			emit_out(s1);
+			if(is_signed) operation = "SUB R0 R1 R0\n";
+			else operation =  "SUBU R0 R1 R0\n";
 		}
-		else
+		else if(X86 == Architecture) operation = "sub_ebx,eax\nmov_eax,ebx\n";
+		else if(AMD64 == Architecture) operation = "sub_rbx,rax\nmov_rax,rbx\n";
+		else if(ARMV7L == Architecture) operation = "'0' R0 R0 SUB R1 ARITH2_ALWAYS\n";
+		else if(AARCH64 == Architecture) operation = "SUB_X0_X1_X0\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 sub\n";
+	}
+	else if(match("*=", operator))
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
+		{
+			if(is_signed) operation = "MUL R0 R1 R0\n";
+			else operation =  "MULU R0 R1 R0\n";
+		}
+		else if(X86 == Architecture)
 		{
-			emit_out(s2);
+			if(is_signed) operation = "imul_ebx\n";
+			else operation = "mul_ebx\n";
 		}
-		iterate();
+		else if(AMD64 == Architecture)
+		{
+			if(is_signed) operation = "imul_rbx\n";
+			else operation = "mul_rbx\n";
+		}
+		else if(ARMV7L == Architecture) operation = "'9' R0 '0' R1 MULS R0 ARITH2_ALWAYS\n";
+		else if(AARCH64 == Architecture) operation = "MUL_X0_X1_X0\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 mul\n";
 	}
-}
-
-
-/*
- * postfix-expr:
- *         primary-expr
- *         postfix-expr [ expression ]
- *         postfix-expr ( expression-list-opt )
- *         postfix-expr -> member
- *         postfix-expr . member
- */
-struct type* lookup_member(struct type* parent, char* name);
-void postfix_expr_arrow(void)
-{
-	emit_out("# looking up offset\n");
-	global_token = global_token->next;
-	require(NULL != global_token, "naked -> not allowed\n");
-
-	struct type* i = lookup_member(current_target, global_token->s);
-	current_target = i->type;
-	global_token = global_token->next;
-	require(NULL != global_token, "Unterminated -> expression not allowed\n");
-
-	if(0 != i->offset)
+	else if(match("/=", operator))
 	{
-		emit_out("# -> offset calculation\n");
 		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 		{
-			emit_out("ADDUI R0 R0 ");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out("\n");
+			if(is_signed) operation = "DIV R0 R1 R0\n";
+			else operation =  "DIVU R0 R1 R0\n";
 		}
 		else if(X86 == Architecture)
 		{
-			emit_out("mov_ebx, %");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out("\nadd_eax,ebx\n");
+			if (is_signed) operation = "xchg_ebx,eax\ncdq\nidiv_ebx\n";
+			else operation = "xchg_ebx,eax\nmov_edx, %0\ndiv_ebx\n";
+		}
+		else if(AMD64 == Architecture)
+		{
+			if(is_signed) operation = "xchg_rbx,rax\ncqo\nidiv_rbx\n";
+			else operation = "xchg_rbx,rax\nmov_rdx, %0\ndiv_rbx\n";
+		}
+		else if(ARMV7L == Architecture)
+		{
+			if(is_signed) operation = "{LR} PUSH_ALWAYS\n^~divides CALL_ALWAYS\n{LR} POP_ALWAYS\n";
+			else operation = "{LR} PUSH_ALWAYS\n^~divide CALL_ALWAYS\n{LR} POP_ALWAYS\n";
+		}
+		else if(AARCH64 == Architecture)
+		{
+			if(is_signed) operation = "SDIV_X0_X1_X0\n";
+			else operation = "UDIV_X0_X1_X0\n";
+		}
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+		{
+			if(is_signed) operation = "rd_a0 rs1_a1 rs2_a0 div\n";
+			else operation = "rd_a0 rs1_a1 rs2_a0 divu\n";
+		}
+	}
+	else if(match("%=", operator))
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
+		{
+			if(is_signed) operation = "MOD R0 R1 R0\n";
+			else operation = "MODU R0 R1 R0\n";
+		}
+		else if(X86 == Architecture)
+		{
+			if(is_signed) operation = "xchg_ebx,eax\ncdq\nidiv_ebx\nmov_eax,edx\n";
+			else operation = "xchg_ebx,eax\nmov_edx, %0\ndiv_ebx\nmov_eax,edx\n";
 		}
 		else if(AMD64 == Architecture)
 		{
-			emit_out("mov_rbx, %");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out("\nadd_rax,rbx\n");
+			if(is_signed) operation = "xchg_rbx,rax\ncqo\nidiv_rbx\nmov_rax,rdx\n";
+			else operation = "xchg_rbx,rax\nmov_rdx, %0\ndiv_rbx\nmov_rax,rdx\n";
 		}
 		else if(ARMV7L == Architecture)
 		{
-			emit_out("!0 R1 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out("\n'0' R0 R0 ADD R1 ARITH2_ALWAYS\n");
+			if(is_signed) operation = "{LR} PUSH_ALWAYS\n^~moduluss CALL_ALWAYS\n{LR} POP_ALWAYS\n";
+			else operation = "{LR} PUSH_ALWAYS\n^~modulus CALL_ALWAYS\n{LR} POP_ALWAYS\n";
 		}
 		else if(AARCH64 == Architecture)
 		{
-			emit_out("LOAD_W1_AHEAD\nSKIP_32_DATA\n%");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out("\nADD_X0_X1_X0\n");
+			if(is_signed) operation = "SDIV_X2_X1_X0\nMSUB_X0_X0_X2_X1\n";
+			else operation = "UDIV_X2_X1_X0\nMSUB_X0_X0_X2_X1\n";
 		}
 		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
 		{
-			emit_out("rd_a1 !");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out(" addi\n");
-			emit_out("rd_a0 rs1_a1 rs2_a0 add\n");
+			if(is_signed) operation = "rd_a0 rs1_a1 rs2_a0 rem\n";
+			else operation = "rd_a0 rs1_a1 rs2_a0 remu\n";
 		}
 	}
-
-	/* We don't yet support assigning structs to structs */
-	if((!match("=", global_token->s) && !is_compound_assignment(global_token->s) && (register_size >= i->size)))
-	{
-		emit_out(load_value(i->size, i->is_signed));
-	}
-}
-
-void postfix_expr_dot(void)
-{
-	maybe_bootstrap_error("Member access using .");
-	emit_out("# looking up offset\n");
-	global_token = global_token->next;
-	require(NULL != global_token, "naked . not allowed\n");
-
-	struct type* i = lookup_member(current_target, global_token->s);
-	current_target = i->type;
-	global_token = global_token->next;
-	require(NULL != global_token, "Unterminated . expression not allowed\n");
-
-	if(0 != i->offset)
+	else if(match("<<=", operator))
 	{
-		emit_out("# . offset calculation\n");
 		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 		{
-			emit_out("ADDUI R0 R0 ");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out("\n");
+			if(is_signed) operation = "SAL R0 R1 R0\n";
+			else operation = "SL0 R0 R1 R0\n";
 		}
 		else if(X86 == Architecture)
 		{
-			emit_out("mov_ebx, %");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out("\nadd_eax,ebx\n");
+			if(is_signed) operation = "mov_ecx,eax\nmov_eax,ebx\nsal_eax,cl\n";
+			else operation = "mov_ecx,eax\nmov_eax,ebx\nshl_eax,cl\n";
 		}
 		else if(AMD64 == Architecture)
 		{
-			emit_out("mov_rbx, %");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out("\nadd_rax,rbx\n");
+			if(is_signed) operation = "mov_rcx,rax\nmov_rax,rbx\nsal_rax,cl\n";
+			else operation = "mov_rcx,rax\nmov_rax,rbx\nshl_rax,cl\n";
 		}
-		else if(ARMV7L == Architecture)
+		else if(ARMV7L == Architecture) operation = "LEFT R1 R0 R0 SHIFT AUX_ALWAYS\n";
+		else if(AARCH64 == Architecture) operation = "LSHIFT_X0_X1_X0\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 sll\n";
+	}
+	else if(match(">>=", operator))
+	{
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 		{
-			emit_out("!0 R1 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out("\n'0' R0 R0 ADD R1 ARITH2_ALWAYS\n");
+			if(is_signed) operation = "SAR R0 R1 R0\n";
+			else operation = "SR0 R0 R1 R0\n";
 		}
-		else if(AARCH64 == Architecture)
+		else if(X86 == Architecture)
 		{
-			emit_out("LOAD_W1_AHEAD\nSKIP_32_DATA\n%");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out("\nADD_X0_X1_X0\n");
+			if(is_signed) operation = "mov_ecx,eax\nmov_eax,ebx\nsar_eax,cl\n";
+			else operation = "mov_ecx,eax\nmov_eax,ebx\nshr_eax,cl\n";
 		}
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+		else if(AMD64 == Architecture)
 		{
-			emit_out("rd_a1 !");
-			emit_out(int2str(i->offset, 10, TRUE));
-			emit_out(" addi\n");
-			emit_out("rd_a0 rs1_a1 rs2_a0 add\n");
+			if(is_signed) operation = "mov_rcx,rax\nmov_rax,rbx\nsar_rax,cl\n";
+			else operation = "mov_rcx,rax\nmov_rax,rbx\nshr_rax,cl\n";
+		}
+		else if(ARMV7L == Architecture)
+		{
+			if(is_signed) operation = "ARITH_RIGHT R1 R0 R0 SHIFT AUX_ALWAYS\n";
+			else operation = "RIGHT R1 R0 R0 SHIFT AUX_ALWAYS\n";
+		}
+		else if(AARCH64 == Architecture)
+		{
+			if(is_signed) operation = "ARITH_RSHIFT_X0_X1_X0\n";
+			else operation = "LOGICAL_RSHIFT_X0_X1_X0\n";
+		}
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+		{
+			if(is_signed) operation = "rd_a0 rs1_a1 rs2_a0 sra\n";
+			else operation = "rd_a0 rs1_a1 rs2_a0 srl\n";
 		}
 	}
-	if(match("=", global_token->s) || is_compound_assignment(global_token->s)) return;
-	if(match("[", global_token->s)) return;
-
-	emit_out(load_value(current_target->size, current_target->is_signed));
-}
-
-void postfix_expr_array(void)
-{
-	struct type* array = current_target;
-	common_recursion(expression);
-	current_target = array;
-	require(NULL != current_target, "Arrays only apply to variables\n");
-
-	char* assign = load_value(register_size, current_target->is_signed);
-
-	/* Add support for Ints */
-	if(match("char*", current_target->name))
-	{
-		assign = load_value(1, TRUE);
-	}
-	else
-	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("PUSHR R1 R15\nLOADI R1 ");
-		else if(X86 == Architecture) emit_out("push_ebx\nmov_ebx, %");
-		else if(AMD64 == Architecture) emit_out("push_rbx\nmov_rbx, %");
-		else if(ARMV7L == Architecture) emit_out("{R1} PUSH_ALWAYS\n!0 R1 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
-		else if(AARCH64 == Architecture) emit_out("PUSH_X1\nLOAD_W1_AHEAD\nSKIP_32_DATA\n%");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a2 rs1_a1 addi\nrd_a1 !");
-		emit_out(int2str(current_target->type->size, 10, TRUE));
-		if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" addi");
-
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("\nMULU R0 R1 R0\nPOPR R1 R15\n");
-		else if(X86 == Architecture) emit_out("\nmul_ebx\npop_ebx\n");
-		else if(AMD64 == Architecture) emit_out("\nmul_rbx\npop_rbx\n");
-		else if(ARMV7L == Architecture) emit_out("\n'9' R0 '0' R1 MUL R0 ARITH2_ALWAYS\n{R1} POP_ALWAYS\n");
-		else if(AARCH64 == Architecture) emit_out("\nMUL_X0_X1_X0\nPOP_X1\n");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("\nrd_a0 rs1_a1 rs2_a0 mul\nrd_a1 rs1_a2 addi\n");
-	}
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("ADD R0 R0 R1\n");
-	else if(X86 == Architecture) emit_out("add_eax,ebx\n");
-	else if(AMD64 == Architecture) emit_out("add_rax,rbx\n");
-	else if(ARMV7L == Architecture) emit_out("'0' R0 R0 ADD R1 ARITH2_ALWAYS\n");
-	else if(AARCH64 == Architecture) emit_out("ADD_X0_X1_X0\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_a1 rs2_a0 add\n");
-
-	require_match("ERROR in postfix_expr\nMissing ]\n", "]");
-	require(NULL != global_token, "truncated array expression\n");
-
-	if(match("=", global_token->s) || is_compound_assignment(global_token->s) || match(".", global_token->s))
-	{
-		assign = "";
-	}
-	if(match("[", global_token->s))
-	{
-		current_target = current_target->type;
-	}
-
-	emit_out(assign);
-}
-
-/*
- * unary-expr:
- *         &postfix-expr
- *         - postfix-expr
- *         !postfix-expr
- *         sizeof ( type )
- */
-struct type* type_name(void);
-void unary_expr_sizeof(void)
-{
-	global_token = global_token->next;
-	require(NULL != global_token, "Received EOF when starting sizeof\n");
-	require_match("ERROR in unary_expr\nMissing (\n", "(");
-	struct type* a = type_name();
-	require_match("ERROR in unary_expr\nMissing )\n", ")");
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("LOADUI R0 ");
-	else if(X86 == Architecture) emit_out("mov_eax, %");
-	else if(AMD64 == Architecture) emit_out("mov_rax, %");
-	else if(ARMV7L == Architecture) emit_out("!0 R0 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n%");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W0_AHEAD\nSKIP_32_DATA\n%");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 !");
-	emit_out(int2str(a->size, 10, TRUE));
-	if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" addi");
-	emit_out("\n");
-}
-
-void postfix_expr_stub(void)
-{
-	require(NULL != global_token, "Unexpected EOF, improperly terminated primary expression\n");
-	if(match("[", global_token->s))
-	{
-		postfix_expr_array();
-		postfix_expr_stub();
-	}
-
-	if(match("->", global_token->s))
-	{
-		postfix_expr_arrow();
-		postfix_expr_stub();
-	}
-
-	if(match(".", global_token->s))
-	{
-		postfix_expr_dot();
-		postfix_expr_stub();
-	}
-}
-
-void postfix_expr(void)
-{
-	primary_expr();
-	postfix_expr_stub();
-}
-
-/*
- * additive-expr:
- *         postfix-expr
- *         additive-expr * postfix-expr
- *         additive-expr / postfix-expr
- *         additive-expr % postfix-expr
- *         additive-expr + postfix-expr
- *         additive-expr - postfix-expr
- *         additive-expr << postfix-expr
- *         additive-expr >> postfix-expr
- */
-void additive_expr_stub_a(void)
-{
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-	{
-		arithmetic_recursion(postfix_expr, "MUL R0 R1 R0\n", "MULU R0 R1 R0\n", "*", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "DIV R0 R1 R0\n", "DIVU R0 R1 R0\n", "/", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "MOD R0 R1 R0\n", "MODU R0 R1 R0\n", "%", additive_expr_stub_a);
-	}
-	else if(X86 == Architecture)
-	{
-		arithmetic_recursion(postfix_expr, "imul_ebx\n", "mul_ebx\n", "*", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "xchg_ebx,eax\ncdq\nidiv_ebx\n", "xchg_ebx,eax\nmov_edx, %0\ndiv_ebx\n", "/", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "xchg_ebx,eax\ncdq\nidiv_ebx\nmov_eax,edx\n", "xchg_ebx,eax\nmov_edx, %0\ndiv_ebx\nmov_eax,edx\n", "%", additive_expr_stub_a);
-	}
-	else if(AMD64 == Architecture)
-	{
-		arithmetic_recursion(postfix_expr, "imul_rbx\n", "mul_rbx\n", "*", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "xchg_rbx,rax\ncqo\nidiv_rbx\n", "xchg_rbx,rax\nmov_rdx, %0\ndiv_rbx\n", "/", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "xchg_rbx,rax\ncqo\nidiv_rbx\nmov_rax,rdx\n", "xchg_rbx,rax\nmov_rdx, %0\ndiv_rbx\nmov_rax,rdx\n", "%", additive_expr_stub_a);
-	}
-	else if(ARMV7L == Architecture)
-	{
-		arithmetic_recursion(postfix_expr, "'9' R0 '0' R1 MULS R0 ARITH2_ALWAYS\n", "'9' R0 '0' R1 MUL R0 ARITH2_ALWAYS\n", "*", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "{LR} PUSH_ALWAYS\n^~divides CALL_ALWAYS\n{LR} POP_ALWAYS\n", "{LR} PUSH_ALWAYS\n^~divide CALL_ALWAYS\n{LR} POP_ALWAYS\n", "/", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "{LR} PUSH_ALWAYS\n^~moduluss CALL_ALWAYS\n{LR} POP_ALWAYS\n", "{LR} PUSH_ALWAYS\n^~modulus CALL_ALWAYS\n{LR} POP_ALWAYS\n", "%", additive_expr_stub_a);
-	}
-	else if(AARCH64 == Architecture)
-	{
-		general_recursion(postfix_expr, "MUL_X0_X1_X0\n", "*", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "SDIV_X0_X1_X0\n", "UDIV_X0_X1_X0\n", "/", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "SDIV_X2_X1_X0\nMSUB_X0_X0_X2_X1\n", "UDIV_X2_X1_X0\nMSUB_X0_X0_X2_X1\n", "%", additive_expr_stub_a);
-	}
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
-	{
-		general_recursion(postfix_expr, "rd_a0 rs1_a1 rs2_a0 mul\n", "*", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "rd_a0 rs1_a1 rs2_a0 div\n", "rd_a0 rs1_a1 rs2_a0 divu\n", "/", additive_expr_stub_a);
-		arithmetic_recursion(postfix_expr, "rd_a0 rs1_a1 rs2_a0 rem\n", "rd_a0 rs1_a1 rs2_a0 remu\n", "%", additive_expr_stub_a);
-	}
-}
-
-
-void additive_expr_a(void)
-{
-	postfix_expr();
-	additive_expr_stub_a();
-}
-
-void additive_expr_stub_b(void)
-{
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-	{
-		arithmetic_recursion(additive_expr_a, "ADD R0 R1 R0\n", "ADDU R0 R1 R0\n", "+", additive_expr_stub_b);
-		arithmetic_recursion(additive_expr_a, "SUB R0 R1 R0\n", "SUBU R0 R1 R0\n", "-", additive_expr_stub_b);
-	}
-	else if(X86 == Architecture)
-	{
-		arithmetic_recursion(additive_expr_a, "add_eax,ebx\n", "add_eax,ebx\n", "+", additive_expr_stub_b);
-		arithmetic_recursion(additive_expr_a, "sub_ebx,eax\nmov_eax,ebx\n", "sub_ebx,eax\nmov_eax,ebx\n", "-", additive_expr_stub_b);
-	}
-	else if(AMD64 == Architecture)
+	else if(match("&=", operator))
 	{
-		arithmetic_recursion(additive_expr_a, "add_rax,rbx\n", "add_rax,rbx\n", "+", additive_expr_stub_b);
-		arithmetic_recursion(additive_expr_a, "sub_rbx,rax\nmov_rax,rbx\n", "sub_rbx,rax\nmov_rax,rbx\n", "-", additive_expr_stub_b);
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) operation = "AND R0 R0 R1\n";
+		else if(X86 == Architecture) operation = "and_eax,ebx\n";
+		else if(AMD64 == Architecture) operation = "and_rax,rbx\n";
+		else if(ARMV7L == Architecture) operation = "NO_SHIFT R0 R0 AND R1 ARITH2_ALWAYS\n";
+		else if(AARCH64 == Architecture) operation = "AND_X0_X1_X0\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 and\n";
 	}
-	else if(ARMV7L == Architecture)
+	else if(match("^=", operator))
 	{
-		arithmetic_recursion(additive_expr_a, "'0' R0 R0 ADD R1 ARITH2_ALWAYS\n", "'0' R0 R0 ADD R1 ARITH2_ALWAYS\n", "+", additive_expr_stub_b);
-		arithmetic_recursion(additive_expr_a, "'0' R0 R0 SUB R1 ARITH2_ALWAYS\n", "'0' R0 R0 SUB R1 ARITH2_ALWAYS\n", "-", additive_expr_stub_b);
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) operation = "XOR R0 R0 R1\n";
+		else if(X86 == Architecture) operation = "xor_eax,ebx\n";
+		else if(AMD64 == Architecture) operation = "xor_rax,rbx\n";
+		else if(ARMV7L == Architecture) operation = "'0' R0 R0 XOR R1 ARITH2_ALWAYS\n";
+		else if(AARCH64 == Architecture) operation = "XOR_X0_X1_X0\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 xor\n";
 	}
-	else if(AARCH64 == Architecture)
+	else if(match("|=", operator))
 	{
-		general_recursion(additive_expr_a, "ADD_X0_X1_X0\n", "+", additive_expr_stub_b);
-		general_recursion(additive_expr_a, "SUB_X0_X1_X0\n", "-", additive_expr_stub_b);
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) operation = "OR R0 R0 R1\n";
+		else if(X86 == Architecture) operation = "or_eax,ebx\n";
+		else if(AMD64 == Architecture) operation = "or_rax,rbx\n";
+		else if(ARMV7L == Architecture) operation = "NO_SHIFT R0 R0 OR R1 AUX_ALWAYS\n";
+		else if(AARCH64 == Architecture) operation = "OR_X0_X1_X0\n";
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 or\n";
 	}
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	else
 	{
-		general_recursion(additive_expr_a, "rd_a0 rs1_a1 rs2_a0 add\n", "+", additive_expr_stub_b);
-		general_recursion(additive_expr_a, "rd_a0 rs1_a1 rs2_a0 sub\n", "-", additive_expr_stub_b);
+		fputs("Found illegal compound assignment operator: ", stderr);
+		fputs(operator, stderr);
+		fputc('\n', stderr);
+		compile_failure();
 	}
+	return operation;
 }
 
 
-void additive_expr_b(void)
-{
-	additive_expr_a();
-	additive_expr_stub_b();
-}
-
-void additive_expr_stub_c(void)
+void expression(void)
 {
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-	{
-		arithmetic_recursion(additive_expr_b, "SAL R0 R1 R0\n", "SL0 R0 R1 R0\n", "<<", additive_expr_stub_c);
-		arithmetic_recursion(additive_expr_b, "SAR R0 R1 R0\n", "SR0 R0 R1 R0\n", ">>", additive_expr_stub_c);
-	}
-	else if(X86 == Architecture)
-	{
-		arithmetic_recursion(additive_expr_b, "mov_ecx,eax\nmov_eax,ebx\nsal_eax,cl\n", "mov_ecx,eax\nmov_eax,ebx\nshl_eax,cl\n", "<<", additive_expr_stub_c);
-		arithmetic_recursion(additive_expr_b, "mov_ecx,eax\nmov_eax,ebx\nsar_eax,cl\n", "mov_ecx,eax\nmov_eax,ebx\nshr_eax,cl\n", ">>", additive_expr_stub_c);
-	}
-	else if(AMD64 == Architecture)
-	{
-		arithmetic_recursion(additive_expr_b, "mov_rcx,rax\nmov_rax,rbx\nsal_rax,cl\n", "mov_rcx,rax\nmov_rax,rbx\nshl_rax,cl\n", "<<", additive_expr_stub_c);
-		arithmetic_recursion(additive_expr_b, "mov_rcx,rax\nmov_rax,rbx\nsar_rax,cl\n", "mov_rcx,rax\nmov_rax,rbx\nshr_rax,cl\n", ">>", additive_expr_stub_c);
-	}
-	else if(ARMV7L == Architecture)
-	{
-		arithmetic_recursion(additive_expr_b, "LEFT R1 R0 R0 SHIFT AUX_ALWAYS\n", "LEFT R1 R0 R0 SHIFT AUX_ALWAYS\n", "<<", additive_expr_stub_c);
-		arithmetic_recursion(additive_expr_b, "ARITH_RIGHT R1 R0 R0 SHIFT AUX_ALWAYS\n", "RIGHT R1 R0 R0 SHIFT AUX_ALWAYS\n", ">>", additive_expr_stub_c);
-	}
-	else if(AARCH64 == Architecture)
+	logical_or_expr();
+	if(match("=", global_token->s))
 	{
-		general_recursion(additive_expr_b, "LSHIFT_X0_X1_X0\n", "<<", additive_expr_stub_c);
-		arithmetic_recursion(additive_expr_b, "ARITH_RSHIFT_X0_X1_X0\n", "LOGICAL_RSHIFT_X0_X1_X0\n", ">>", additive_expr_stub_c);
+		char* store = "";
+		if(match("]", global_token->prev->s))
+		{
+			store = store_value(current_target->type->size);
+		}
+		else
+		{
+			store = store_value(current_target->size);
+		}
+
+		common_recursion(expression);
+		emit_out(store);
+		current_target = integer;
 	}
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	else if(is_compound_assignment(global_token->s))
 	{
-		general_recursion(additive_expr_b, "rd_a0 rs1_a1 rs2_a0 sll\n", "<<", additive_expr_stub_c);
-		arithmetic_recursion(additive_expr_b, "rd_a0 rs1_a1 rs2_a0 sra\n", "rd_a0 rs1_a1 rs2_a0 srl\n", ">>", additive_expr_stub_c);
-	}
-}
+		maybe_bootstrap_error("compound operator");
+		char* push = "";
+		char* load = "";
+		char* operation = "";
+		char* pop = "";
+		char* store = "";
+		struct type* last_type = current_target;
 
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) push = "PUSHR R1 R15\n";
+		else if(X86 == Architecture) push = "push_ebx\n";
+		else if(AMD64 == Architecture) push = "push_rbx\n";
+		else if(ARMV7L == Architecture) push = "{R1} PUSH_ALWAYS\n";
+		else if(AARCH64 == Architecture) push = "PUSH_X1\n";
+		else if(RISCV32 == Architecture) push = "rs1_sp rs2_a1 @-4 sw\n";
+		else if(RISCV64 == Architecture) push = "rs1_sp rs2_a1 @-8 sd\n";
 
-void additive_expr_c(void)
-{
-	additive_expr_b();
-	additive_expr_stub_c();
-}
+		if(!match("]", global_token->prev->s) || !match("char*", current_target->name))
+		{
+			if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) load = "LOAD R1 R1 0\n";
+			else if(X86 == Architecture) load = "mov_ebx,[ebx]\n";
+			else if(AMD64 == Architecture) load = "mov_rbx,[rbx]\n";
+			else if(ARMV7L == Architecture) load = "!0 R1 LOAD32 R1 MEMORY\n";
+			else if(AARCH64 == Architecture) load = "DEREF_X1\n";
+			else if(RISCV32 == Architecture) load = "rd_a1 rs1_a1 lw\n";
+			else if(RISCV64 == Architecture) load = "rd_a1 rs1_a1 ld\n";
+		}
+		else
+		{
+			if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) load = "LOAD8 R1 R1 0\n";
+			else if(X86 == Architecture) load = "movsx_ebx,BYTE_PTR_[ebx]\n";
+			else if(AMD64 == Architecture) load = "movsx_rbx,BYTE_PTR_[rbx]\n";
+			else if(ARMV7L == Architecture) load = "LOADU8 R1 LOAD R1 MEMORY\n";
+			else if(AARCH64 == Architecture) load = "DEREF_X1_BYTE\n";
+			else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) load = "rd_a1 rs1_a1 lbu\n";
+		}
 
+		char *operator = global_token->s;
 
-/*
- * relational-expr:
- *         additive_expr
- *         relational-expr < additive_expr
- *         relational-expr <= additive_expr
- *         relational-expr >= additive_expr
- *         relational-expr > additive_expr
- */
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) pop = "POPR R1 R15\n";
+		else if(X86 == Architecture) pop = "pop_ebx\n";
+		else if(AMD64 == Architecture) pop = "pop_rbx\n";
+		else if(ARMV7L == Architecture) pop = "{R1} POP_ALWAYS\n";
+		else if(AARCH64 == Architecture) pop = "POP_X1\n";
+		else if(RISCV32 == Architecture) pop = "rd_a1 rs1_sp !-4 lw\n";
+		else if(RISCV64 == Architecture) pop = "rd_a1 rs1_sp !-8 ld\n";
 
-void relational_expr_stub(void)
-{
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-	{
-		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.L R0 R0 1\n", "CMPU R0 R1 R0\nSET.L R0 R0 1\n", "<", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.LE R0 R0 1\n", "CMPU R0 R1 R0\nSET.LE R0 R0 1\n", "<=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.GE R0 R0 1\n", "CMPU R0 R1 R0\nSET.GE R0 R0 1\n", ">=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.G R0 R0 1\n", "CMPU R0 R1 R0\nSET.G R0 R0 1\n", ">", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.E R0 R0 1\n", "CMPU R0 R1 R0\nSET.E R0 R0 1\n", "==", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "CMP R0 R1 R0\nSET.NE R0 R0 1\n", "CMPU R0 R1 R0\nSET.NE R0 R0 1\n", "!=", relational_expr_stub);
-	}
-	else if(X86 == Architecture)
-	{
-		arithmetic_recursion(additive_expr_c, "cmp\nsetl_al\nmovzx_eax,al\n", "cmp\nsetb_al\nmovzx_eax,al\n", "<", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "cmp\nsetle_al\nmovzx_eax,al\n", "cmp\nsetbe_al\nmovzx_eax,al\n", "<=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "cmp\nsetge_al\nmovzx_eax,al\n", "cmp\nsetae_al\nmovzx_eax,al\n", ">=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "cmp\nsetg_al\nmovzx_eax,al\n", "cmp\nseta_al\nmovzx_eax,al\n", ">", relational_expr_stub);
-		general_recursion(additive_expr_c, "cmp\nsete_al\nmovzx_eax,al\n", "==", relational_expr_stub);
-		general_recursion(additive_expr_c, "cmp\nsetne_al\nmovzx_eax,al\n", "!=", relational_expr_stub);
-	}
-	else if(AMD64 == Architecture)
-	{
-		arithmetic_recursion(additive_expr_c, "cmp_rbx,rax\nsetl_al\nmovzx_rax,al\n", "cmp_rbx,rax\nsetb_al\nmovzx_rax,al\n", "<", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "cmp_rbx,rax\nsetle_al\nmovzx_rax,al\n", "cmp_rbx,rax\nsetbe_al\nmovzx_rax,al\n", "<=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "cmp_rbx,rax\nsetge_al\nmovzx_rax,al\n", "cmp_rbx,rax\nsetae_al\nmovzx_rax,al\n", ">=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "cmp_rbx,rax\nsetg_al\nmovzx_rax,al\n", "cmp_rbx,rax\nseta_al\nmovzx_rax,al\n", ">", relational_expr_stub);
-		general_recursion(additive_expr_c, "cmp_rbx,rax\nsete_al\nmovzx_rax,al\n", "==", relational_expr_stub);
-		general_recursion(additive_expr_c, "cmp_rbx,rax\nsetne_al\nmovzx_rax,al\n", "!=", relational_expr_stub);
-	}
-	else if(ARMV7L == Architecture)
-	{
-		arithmetic_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_L\n", "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_LO\n", "<", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_LE\n", "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_LS\n", "<=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_GE\n", "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_HS\n", ">=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_G\n", "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_HI\n", ">", relational_expr_stub);
-		general_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_EQUAL\n", "==", relational_expr_stub);
-		general_recursion(additive_expr_c, "'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_NE\n", "!=", relational_expr_stub);
-	}
-	else if(AARCH64 == Architecture)
-	{
-		arithmetic_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_LT\nSET_X0_TO_0\n", "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_LO\nSET_X0_TO_0\n", "<", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_LE\nSET_X0_TO_0\n", "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_LS\nSET_X0_TO_0\n", "<=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_GE\nSET_X0_TO_0\n", "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_HS\nSET_X0_TO_0\n", ">=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_GT\nSET_X0_TO_0\n", "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_HI\nSET_X0_TO_0\n", ">", relational_expr_stub);
-		general_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_EQ\nSET_X0_TO_0\n", "==", relational_expr_stub);
-		general_recursion(additive_expr_c, "CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_NE\nSET_X0_TO_0\n", "!=", relational_expr_stub);
-	}
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
-	{
-		arithmetic_recursion(additive_expr_c, "rd_a0 rs1_a1 rs2_a0 slt\n", "rd_a0 rs1_a1 rs2_a0 sltu\n", "<", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "rd_a0 rs1_a0 rs2_a1 slt\nrd_a0 rs1_a0 !1 xori\n", "rd_a0 rs1_a0 rs2_a1 sltu\nrd_a0 rs1_a0 !1 xori\n", "<=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "rd_a0 rs1_a1 rs2_a0 slt\nrd_a0 rs1_a0 !1 xori\n", "rd_a0 rs1_a1 rs2_a0 sltu\nrd_a0 rs1_a0 !1 xori\n", ">=", relational_expr_stub);
-		arithmetic_recursion(additive_expr_c, "rd_a0 rs1_a0 rs2_a1 slt\n", "rd_a0 rs1_a0 rs2_a1 sltu\n", ">", relational_expr_stub);
-		general_recursion(additive_expr_c, "rd_a0 rs1_a0 rs2_a1 sub\nrd_a0 rs1_a0 !1 sltiu\n", "==", relational_expr_stub);
-		general_recursion(additive_expr_c, "rd_a0 rs1_a0 rs2_a1 sub\nrd_a0 rs2_a0 sltu\n", "!=", relational_expr_stub);
+		if(match("]", global_token->prev->s))
+		{
+			store = store_value(current_target->type->size);
+		}
+		else
+		{
+			store = store_value(current_target->size);
+		}
+
+		common_recursion(expression);
+		current_target = promote_type(current_target, last_type);
+		emit_out(push);
+		emit_out(load);
+		operation = compound_operation(operator, current_target->is_signed);
+		emit_out(operation);
+		emit_out(pop);
+		emit_out(store);
+		current_target = integer;
 	}
 }
 
-void relational_expr(void)
+
+int iskeywordp(char* s)
+{
+	if(match("auto", s)) return TRUE;
+	if(match("break", s)) return TRUE;
+	if(match("case", s)) return TRUE;
+	if(match("char", s)) return TRUE;
+	if(match("const", s)) return TRUE;
+	if(match("continue", s)) return TRUE;
+	if(match("default", s)) return TRUE;
+	if(match("do", s)) return TRUE;
+	if(match("double", s)) return TRUE;
+	if(match("else", s)) return TRUE;
+	if(match("enum", s)) return TRUE;
+	if(match("extern", s)) return TRUE;
+	if(match("float", s)) return TRUE;
+	if(match("for", s)) return TRUE;
+	if(match("goto", s)) return TRUE;
+	if(match("if", s)) return TRUE;
+	if(match("inline", s)) return TRUE;
+	if(match("int", s)) return TRUE;
+	if(match("long", s)) return TRUE;
+	if(match("register", s)) return TRUE;
+	if(match("return", s)) return TRUE;
+	if(match("short", s)) return TRUE;
+	if(match("signed", s)) return TRUE;
+	if(match("sizeof", s)) return TRUE;
+	if(match("static", s)) return TRUE;
+	if(match("struct", s)) return TRUE;
+	if(match("switch", s)) return TRUE;
+	if(match("typedef", s)) return TRUE;
+	if(match("union", s)) return TRUE;
+	if(match("unsigned", s)) return TRUE;
+	if(match("void", s)) return TRUE;
+	if(match("volatile", s)) return TRUE;
+	if(match("while", s)) return TRUE;
+	return FALSE;
+}
+
+/* Similar to integer division a / b but rounds up */
+unsigned ceil_div(unsigned a, unsigned b)
 {
-	additive_expr_c();
-	relational_expr_stub();
+	return (a + b - 1) / b;
 }
 
-/*
- * bitwise-expr:
- *         relational-expr
- *         bitwise-expr & bitwise-expr
- *         bitwise-expr && bitwise-expr
- *         bitwise-expr | bitwise-expr
- *         bitwise-expr || bitwise-expr
- *         bitwise-expr ^ bitwise-expr
- */
-void bitwise_expr_stub(void)
+/* Stack words used by the locals from first up to but not including last */
+int locals_words(struct token_list* first, struct token_list* last)
 {
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
+	int words = 0;
+	while(first != last)
 	{
-		general_recursion(relational_expr, "AND R0 R0 R1\n", "&", bitwise_expr_stub);
-		general_recursion(relational_expr, "AND R0 R0 R1\n", "&&", bitwise_expr_stub);
-		general_recursion(relational_expr, "OR R0 R0 R1\n", "|", bitwise_expr_stub);
-		general_recursion(relational_expr, "OR R0 R0 R1\n", "||", bitwise_expr_stub);
-		general_recursion(relational_expr, "XOR R0 R0 R1\n", "^", bitwise_expr_stub);
+		if(NULL == first) break;
+		words = words + ceil_div(first->type->size, register_size);
+		first = first->next;
 	}
-	else if(X86 == Architecture)
+	return words;
+}
+
+/* Process local variable */
+void collect_local(void)
+{
+	if(NULL != break_target_func)
 	{
-		general_recursion(relational_expr, "and_eax,ebx\n", "&", bitwise_expr_stub);
-		general_recursion(relational_expr, "and_eax,ebx\n", "&&", bitwise_expr_stub);
-		general_recursion(relational_expr, "or_eax,ebx\n", "|", bitwise_expr_stub);
-		general_recursion(relational_expr, "or_eax,ebx\n", "||", bitwise_expr_stub);
-		general_recursion(relational_expr, "xor_eax,ebx\n", "^", bitwise_expr_stub);
+		fputs("Local variable initialized inside of loop in file: ", stderr);
+		line_error();
+		fputs("\nMove the variable outside of the loop to resolve\n", stderr);
+		fputs("Otherwise the binary will segfault while running\n", stderr);
+		compile_failure();
 	}
-	else if(AMD64 == Architecture)
+	struct type* type_size = type_name();
+	require(NULL != global_token, "Received EOF while collecting locals\n");
+	require(!in_set(global_token->s[0], "[{(<=>)}]|&!^%;:'\""), "forbidden character in local variable name\n");
+	require(TOKEN_KEYWORD != global_token->kind, "You are not allowed to use a keyword as a local variable name\n");
+	require(NULL != type_size, "Must have non-null type\n");
+	struct token_list* a = sym_declare(global_token->s, type_size, function->locals);
+	if(match("main", function->s) && (NULL == function->locals))
 	{
-		general_recursion(relational_expr, "and_rax,rbx\n", "&", bitwise_expr_stub);
-		general_recursion(relational_expr, "and_rax,rbx\n", "&&", bitwise_expr_stub);
-		general_recursion(relational_expr, "or_rax,rbx\n", "|", bitwise_expr_stub);
-		general_recursion(relational_expr, "or_rax,rbx\n", "||", bitwise_expr_stub);
-		general_recursion(relational_expr, "xor_rax,rbx\n", "^", bitwise_expr_stub);
+		if(KNIGHT_NATIVE == Architecture) a->depth = register_size;
+		else if(KNIGHT_POSIX == Architecture) a->depth = 20;
+		else if(X86 == Architecture) a->depth = -20;
+		else if(AMD64 == Architecture) a->depth = -40;
+		else if(ARMV7L == Architecture) a->depth = 16;
+		else if(AARCH64 == Architecture) a->depth = 32; /* argc, argv, envp and the local (8 bytes each) */
+		else if(RISCV32 == Architecture) a->depth = -16;
+		else if(RISCV64 == Architecture) a->depth = -32;
 	}
-	else if(ARMV7L == Architecture)
+	else if((NULL == function->arguments) && (NULL == function->locals))
 	{
-		general_recursion(relational_expr, "NO_SHIFT R0 R0 AND R1 ARITH2_ALWAYS\n", "&", bitwise_expr_stub);
-		general_recursion(relational_expr, "NO_SHIFT R0 R0 AND R1 ARITH2_ALWAYS\n", "&&", bitwise_expr_stub);
-		general_recursion(relational_expr, "NO_SHIFT R0 R0 OR R1 AUX_ALWAYS\n", "|", bitwise_expr_stub);
-		general_recursion(relational_expr, "NO_SHIFT R0 R0 OR R1 AUX_ALWAYS\n", "||", bitwise_expr_stub);
-		general_recursion(relational_expr, "'0' R0 R0 XOR R1 ARITH2_ALWAYS\n", "^", bitwise_expr_stub);
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) a->depth = register_size;
+		else if(X86 == Architecture) a->depth = -8;
+		else if(AMD64 == Architecture) a->depth = -16;
+		else if(ARMV7L == Architecture) a->depth = 8;
+		else if(AARCH64 == Architecture) a->depth = register_size;
+		else if(RISCV32 == Architecture) a->depth = -4;
+		else if(RISCV64 == Architecture) a->depth = -8;
 	}
-	else if(AARCH64 == Architecture)
+	else if(NULL == function->locals)
 	{
-		general_recursion(relational_expr, "AND_X0_X1_X0\n", "&", bitwise_expr_stub);
-		general_recursion(relational_expr, "AND_X0_X1_X0\n", "&&", bitwise_expr_stub);
-		general_recursion(relational_expr, "OR_X0_X1_X0\n", "|", bitwise_expr_stub);
-		general_recursion(relational_expr, "OR_X0_X1_X0\n", "||", bitwise_expr_stub);
-		general_recursion(relational_expr, "XOR_X0_X1_X0\n", "^", bitwise_expr_stub);
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) a->depth = function->arguments->depth + 8;
+		else if(X86 == Architecture) a->depth = function->arguments->depth - 8;
+		else if(AMD64 == Architecture) a->depth = function->arguments->depth - 16;
+		else if(ARMV7L == Architecture) a->depth = function->arguments->depth + 8;
+		else if(AARCH64 == Architecture) a->depth = function->arguments->depth + register_size;
+		else if(RISCV32 == Architecture) a->depth = function->arguments->depth - 4;
+		else if(RISCV64 == Architecture) a->depth = function->arguments->depth - 8;
 	}
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	else
 	{
-		general_recursion(relational_expr, "rd_a0 rs1_a1 rs2_a0 and\n", "&", bitwise_expr_stub);
-		general_recursion(relational_expr, "rd_a0 rs1_a1 rs2_a0 and\n", "&&", bitwise_expr_stub);
-		general_recursion(relational_expr, "rd_a0 rs1_a1 rs2_a0 or\n", "|", bitwise_expr_stub);
-		general_recursion(relational_expr, "rd_a0 rs1_a1 rs2_a0 or\n", "||", bitwise_expr_stub);
-		general_recursion(relational_expr, "rd_a0 rs1_a1 rs2_a0 xor\n", "^", bitwise_expr_stub);
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) a->depth = function->locals->depth + register_size;
+		else if(X86 == Architecture) a->depth = function->locals->depth - register_size;
+		else if(AMD64 == Architecture) a->depth = function->locals->depth - register_size;
+		else if(ARMV7L == Architecture) a->depth = function->locals->depth + register_size;
+		else if(AARCH64 == Architecture) a->depth = function->locals->depth + register_size;
+		else if(RISCV32 == Architecture) a->depth = function->locals->depth - register_size;
+		else if(RISCV64 == Architecture) a->depth = function->locals->depth - register_size;
 	}
-}
 
+	/* Adjust the depth of local structs. When stack grows downwards, we want them to 
+	   start at the bottom of allocated space. */
+	unsigned struct_depth_adjustment = (ceil_div(a->type->size, register_size) - 1) * register_size;
+	if(KNIGHT_POSIX == Architecture) a->depth = a->depth + struct_depth_adjustment;
+	else if(KNIGHT_NATIVE == Architecture) a->depth = a->depth + struct_depth_adjustment;
+	else if(X86 == Architecture) a->depth = a->depth - struct_depth_adjustment;
+	else if(AMD64 == Architecture) a->depth = a->depth - struct_depth_adjustment;
+	else if(ARMV7L == Architecture) a->depth = a->depth + struct_depth_adjustment;
+	else if(AARCH64 == Architecture) a->depth = a->depth + struct_depth_adjustment;
+	else if(RISCV32 == Architecture) a->depth = a->depth - struct_depth_adjustment;
+	else if(RISCV64 == Architecture) a->depth = a->depth - struct_depth_adjustment;
 
-void bitwise_expr(void)
-{
-	relational_expr();
-	bitwise_expr_stub();
-}
+	function->locals = a;
+	function->depth = function->depth | FUNCTION_HAS_LOCALS;
+	sym_index(scope_table, a);
 
-/*
- * expression:
- *         bitwise-or-expr
- *         bitwise-or-expr = expression
- */
+	emit_out("# Defining local ");
+	emit_out(global_token->s);
+	emit_out("\n");
 
-void primary_expr(void)
-{
-	require(NULL != global_token, "Received EOF where primary expression expected\n");
-	if(match("&", global_token->s))
+	global_token = global_token->next;
+	require(NULL != global_token, "incomplete local missing name\n");
+
+	if(match("=", global_token->s))
 	{
-		Address_of = TRUE;
 		global_token = global_token->next;
-		require(NULL != global_token, "Received EOF after & where primary expression expected\n");
+		require(NULL != global_token, "incomplete local assignment\n");
+		expression();
 	}
-	else
+
+	require_match("ERROR in collect_local\nMissing ;\n", ";");
+
+	unsigned i = (a->type->size + register_size - 1) / register_size;
+	if(OPTIMIZE && (1 < i))
 	{
-		Address_of = FALSE;
+		/* Structs and arrays are not initialized, just make room for them */
+		stack_adjust(-(i * register_size));
+		emit_out("# ");
+		emit_out(a->s);
+		emit_out("\n");
+		i = 0;
 	}
-
-	if(match("sizeof", global_token->s)) unary_expr_sizeof();
-	else if('-' == global_token->s[0])
+	while(i != 0)
 	{
-		if(X86 == Architecture) emit_out("mov_eax, %0\n");
-		else if(AMD64 == Architecture) emit_out("mov_rax, %0\n");
-		else if(ARMV7L == Architecture) emit_out("!0 R0 LOADI8_ALWAYS\n");
-		else if(AARCH64 == Architecture) emit_out("SET_X0_TO_0\n");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 mv\n");
+		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("PUSHR R0 R15\t#");
+		else if(X86 == Architecture) emit_out("push_eax\t#");
+		else if(AMD64 == Architecture) emit_out("push_rax\t#");
+		else if(ARMV7L == Architecture) emit_out("{R0} PUSH_ALWAYS\t#");
+		else if(AARCH64 == Architecture) emit_out("PUSH_X0\t#");
+		else if(RISCV32 == Architecture) emit_out("rd_sp rs1_sp !-4 addi\nrs1_sp rs2_a0 sw\t#");
+		else if(RISCV64 == Architecture) emit_out("rd_sp rs1_sp !-8 addi\nrs1_sp rs2_a0 sd\t#");
+		emit_out(a->s);
+		emit_out("\n");
+		i = i - 1;
+	}
+}
 
-		common_recursion(primary_expr);
+void statement(void);
 
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("NEG R0 R0\n");
-		else if(X86 == Architecture) emit_out("sub_ebx,eax\nmov_eax,ebx\n");
-		else if(AMD64 == Architecture) emit_out("sub_rbx,rax\nmov_rax,rbx\n");
-		else if(ARMV7L == Architecture) emit_out("'0' R0 R0 SUB R1 ARITH2_ALWAYS\n");
-		else if(AARCH64 == Architecture) emit_out("SUB_X0_X1_X0\n");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_a1 rs2_a0 sub\n");
-	}
-	else if('!' == global_token->s[0])
-	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))  emit_out("LOADI R0 1\n");
-		else if(X86 == Architecture) emit_out("mov_eax, %1\n");
-		else if(AMD64 == Architecture) emit_out("mov_rax, %1\n");
-		else if(ARMV7L == Architecture) emit_out("!1 R0 LOADI8_ALWAYS\n");
-		else if(AARCH64 == Architecture) emit_out("SET_X0_TO_1\n");
+/* Evaluate if statements */
+void process_if(void)
+{
+	char* number_string = int2str(current_count, 10, TRUE);
+	current_count = current_count + 1;
 
-		common_recursion(postfix_expr);
+	emit_out("# IF_");
+	uniqueID_out(function->s, number_string);
 
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("CMPU R0 R1 R0\nSET.G R0 R0 1\n");
-		else if(X86 == Architecture) emit_out("cmp\nseta_al\nmovzx_eax,al\n");
-		else if(AMD64 == Architecture) emit_out("cmp_rbx,rax\nseta_al\nmovzx_rax,al\n");
-		else if(ARMV7L == Architecture) emit_out("'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_HI\n");
-		else if(AARCH64 == Architecture) emit_out("CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_HI\nSET_X0_TO_0\n");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_a0 !1 sltiu\n");
-	}
-	else if('~' == global_token->s[0])
+	global_token = global_token->next;
+	require_match("ERROR in process_if\nMISSING (\n", "(");
+	expression();
+
+	if(OPTIMIZE) condition_jump(label_name("ELSE_", function->s, number_string), TRUE);
+	else jump_on_zero(label_name("ELSE_", function->s, number_string), TRUE);
+
+	require_match("ERROR in process_if\nMISSING )\n", ")");
+	statement();
+	require(NULL != global_token, "Reached EOF inside of function\n");
+
+	ir_jump(label_name("_END_IF_", function->s, number_string), TRUE);
+
+	ir_label(label_name("ELSE_", function->s, number_string));
+
+	if(keyword_else == global_token->s)
 	{
-		common_recursion(postfix_expr);
+		global_token = global_token->next;
+		require(NULL != global_token, "Received EOF where an else statement expected\n");
+		statement();
+		require(NULL != global_token, "Reached EOF inside of function\n");
+	}
+	ir_label(label_name("_END_IF_", function->s, number_string));
+}
+
+void process_case(void)
+{
+process_case_iter:
+	if(keyword_case == global_token->s) return;
+	if(keyword_default == global_token->s) return;
 
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("NOT R0 R0\n");
-		else if(X86 == Architecture) emit_out("not_eax\n");
-		else if(AMD64 == Architecture) emit_out("not_rax\n");
-		else if(ARMV7L == Architecture) emit_out("'0' R0 R0 MVN_ALWAYS\n");
-		else if(AARCH64 == Architecture) emit_out("MVN_X0\n");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_a0 not\n");
+	if(keyword_break == global_token->s)
+	{
+		statement();
 	}
-	else if(global_token->s[0] == '(')
+	else
 	{
-		global_token = global_token->next;
-		expression();
-		require_match("Error in Primary expression\nDidn't get )\n", ")");
+		statement();
+		goto process_case_iter;
 	}
-	else if(global_token->s[0] == '\'') primary_expr_char();
-	else if(global_token->s[0] == '"') primary_expr_string();
-	else if(in_set(global_token->s[0], "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_")) primary_expr_variable();
-	else if(global_token->s[0] == '*') primary_expr_variable();
-	else if(in_set(global_token->s[0], "0123456789"))
+}
+
+/* Compare the case value with the switch value in R1 and jump to its case if equal */
+void switch_case_jump(char* value, char* number_string)
+{
+	/* put case value in R0 as the switch (value) is in R1 */
+	primary_expr_number(value);
+
+	/* compare R0 and R1 and jump to case if equal */
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("CMPU R0 R0 R1\nJUMP.E R0 @_SWITCH_CASE_");
+	else if(X86 == Architecture) emit_out("cmp\nje %_SWITCH_CASE_");
+	else if(AMD64 == Architecture) emit_out("cmp_rbx,rax\nje %_SWITCH_CASE_");
+	else if(ARMV7L == Architecture) emit_out("'0' R0 CMP R1 AUX_ALWAYS\n^~_SWITCH_CASE_");
+	else if(AARCH64 == Architecture) emit_out("CMP_X1_X0\nSKIP_32_DATA\n&_SWITCH_CASE_");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_a0 rs2_a1 sub\nrs1_a0 @8 bnez\n$_SWITCH_CASE_");
+
+	emit_out(value);
+	emit_out("_");
+	uniqueID_out(function->s, number_string);
+	if(ARMV7L == Architecture) emit_out(" JUMP_EQUAL\n");
+	else if(AARCH64 == Architecture) emit_out("\nSKIP_INST_NE\nBR_X16\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
+}
+
+void switch_default_jump(char* number_string)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @_SWITCH_DEFAULT_");
+	else if(X86 == Architecture) emit_out("jmp %_SWITCH_DEFAULT_");
+	else if(AMD64 == Architecture) emit_out("jmp %_SWITCH_DEFAULT_");
+	else if(ARMV7L == Architecture) emit_out("^~_SWITCH_DEFAULT_");
+	else if(AARCH64 == Architecture) emit_out("SKIP_32_DATA\n&_SWITCH_DEFAULT_");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$_SWITCH_DEFAULT_");
+
+	uniqueID_out(function->s, number_string);
+	if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS\n");
+	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
+}
+
+/*
+ * -O1 switch dispatch.  Dense sets of numeric cases index a table of case
+ * addresses in the data section, bounds checked against the default; other
+ * sets of more than a few cases are searched with a balanced tree of
+ * compares.  Everything else keeps the linear chain of compares.
+ */
+int switch_count;
+int* switch_values;
+char** switch_names;
+
+/* Search the sorted cases lo up to hi for the switch value in R1 */
+void switch_tree(int lo, int hi, char* number_string)
+{
+	if(4 > (hi - lo))
 	{
-		primary_expr_number(global_token->s);
-		global_token = global_token->next;
+		while(lo < hi)
+		{
+			switch_case_jump(switch_names[lo], number_string);
+			lo = lo + 1;
+		}
+		switch_default_jump(number_string);
+		return;
 	}
-	else primary_expr_failure();
+
+	int mid = (lo + hi) >> 1;
+	char* upper = label_name(label_name("_SWITCH_TREE_", int2str(mid, 10, TRUE), ""), function->s, number_string);
+
+	/* R0 = R1 < case value, the values below it are in the lower half */
+	primary_expr_number(switch_names[mid]);
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("CMP R0 R1 R0\nSET.L R0 R0 1\n");
+	else if(X86 == Architecture) emit_out("cmp\nsetl_al\nmovzx_eax,al\n");
+	else if(AMD64 == Architecture) emit_out("cmp_rbx,rax\nsetl_al\nmovzx_rax,al\n");
+	else if(ARMV7L == Architecture) emit_out("'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_L\n");
+	else if(AARCH64 == Architecture) emit_out("CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_LT\nSET_X0_TO_0\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_a1 rs2_a0 slt\n");
+	jump_on_zero(upper, TRUE);
+
+	switch_tree(lo, mid, number_string);
+	ir_label(upper);
+	switch_tree(mid, hi, number_string);
 }
 
-char* compound_operation(char* operator, int is_signed)
+void switch_table(char* number_string)
 {
-	char* operation = "";
-	if(match("+=", operator))
+	int min = switch_values[0];
+	int range = switch_values[switch_count - 1] - min + 1;
+	char* table = label_name("_SWITCH_JUMPS_", function->s, number_string);
+	char* default_label = label_name("_SWITCH_DEFAULT_", function->s, number_string);
+
+	/* R0 = R1 - lowest case */
+	primary_expr_number(switch_names[0]);
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("SUB R0 R1 R0\n");
+	else if(X86 == Architecture) emit_out("sub_ebx,eax\nmov_eax,ebx\n");
+	else if(AMD64 == Architecture) emit_out("sub_rbx,rax\nmov_rax,rbx\n");
+	else if(ARMV7L == Architecture) emit_out("'0' R0 R0 SUB R1 ARITH2_ALWAYS\n");
+	else if(AARCH64 == Architecture) emit_out("SUB_X0_X1_X0\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_a1 rs2_a0 sub\n");
+
+	/* Anything at or past the end of the table, negative included, is the default */
+	ir_append(IR_PUSH, NULL);
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("MOVE R1 R0\n");
+	else if(X86 == Architecture) emit_out("mov_ebx,eax\n");
+	else if(AMD64 == Architecture) emit_out("push_rax\npop_rbx\n");
+	else if(ARMV7L == Architecture) emit_out("'0' R0 R1 NO_SHIFT MOVE_ALWAYS\n");
+	else if(AARCH64 == Architecture) emit_out("SET_X1_FROM_X0\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a1 rs1_a0 mv\n");
+	primary_expr_number(int2str(range, 10, TRUE));
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("CMPU R0 R1 R0\nSET.L R0 R0 1\n");
+	else if(X86 == Architecture) emit_out("cmp\nsetb_al\nmovzx_eax,al\n");
+	else if(AMD64 == Architecture) emit_out("cmp_rbx,rax\nsetb_al\nmovzx_rax,al\n");
+	else if(ARMV7L == Architecture) emit_out("'0' R0 CMP R1 AUX_ALWAYS\n!0 R0 LOADI8_ALWAYS\n!1 R0 LOADI8_LO\n");
+	else if(AARCH64 == Architecture) emit_out("CMP_X1_X0\nSET_X0_TO_1\nSKIP_INST_LO\nSET_X0_TO_0\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_a1 rs2_a0 sltu\n");
+	ir_append(IR_POP, NULL);
+	jump_on_zero(default_label, TRUE);
+
+	/* R0 = index, R1 = table */
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("MOVE R0 R1\nLOADR R1 4\nJUMP 4\n&");
+	else if(X86 == Architecture) emit_out("mov_eax,ebx\nmov_ebx, &");
+	else if(AMD64 == Architecture) emit_out("mov_rax,rbx\nmov_rbx, &");
+	else if(ARMV7L == Architecture) emit_out("'0' R1 R0 NO_SHIFT MOVE_ALWAYS\n!0 R1 LOAD32 R15 MEMORY\n~0 JUMP_ALWAYS\n&");
+	else if(AARCH64 == Architecture) emit_out("PUSH_X1\nPOP_X0\nLOAD_W1_AHEAD\nSKIP_32_DATA\n&");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_a1 mv\nrd_a1 ~");
+	emit_out(table);
+	if((RISCV32 == Architecture) || (RISCV64 == Architecture))
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-		{
-			if(is_signed) operation = "ADD R0 R1 R0\n";
-			else operation = "ADDU R0 R1 R0\n";
-		}
-		else if(X86 == Architecture) operation = "add_eax,ebx\n";
-		else if(AMD64 == Architecture) operation = "add_rax,rbx\n";
-		else if(ARMV7L == Architecture) operation = "'0' R0 R0 ADD R1 ARITH2_ALWAYS\n";
-		else if(AARCH64 == Architecture) operation = "ADD_X0_X1_X0\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 add\n";
+		emit_out(" auipc\nrd_a1 rs1_a1 !");
+		emit_out(table);
+		emit_out(" addi");
 	}
-	else if(match("-=", operator))
+	emit_out("\n");
+
+	/* Load the case address and jump to it */
+	if(!immediate_operation("<<", power_of_two(register_size), FALSE, "")) array_scale(register_size);
+	emit_out(array_add());
+	emit_out(load_value(register_size, FALSE));
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("PUSHR R0 R15\nRET R15\n");
+	else if(X86 == Architecture) emit_out(o1_define("O1_jmp_eax", "FFE0"));
+	else if(AMD64 == Architecture) emit_out(o1_define("O1_jmp_rax", "FFE0"));
+	else if(ARMV7L == Architecture) emit_out("'0' R0 R15 NO_SHIFT MOVE_ALWAYS");
+	else if(AARCH64 == Architecture) emit_out(o1_define("O1_BR_X0", "00001FD6"));
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rs1_a0 jalr");
+	if((KNIGHT_POSIX != Architecture) && (KNIGHT_NATIVE != Architecture)) emit_out("\n");
+
+	/* The table itself, holes go to the default */
+	emit(":", globals_list);
+	emit(table, globals_list);
+	emit("\n", globals_list);
+	int i = 0;
+	int value;
+	int padding;
+	for(value = min; value < (min + range); value = value + 1)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
+		emit("&", globals_list);
+		if(value == switch_values[i])
 		{
-			if(is_signed) operation = "SUB R0 R1 R0\n";
-			else operation =  "SUBU R0 R1 R0\n";
+			emit(label_name(label_name("_SWITCH_CASE_", switch_names[i], ""), function->s, number_string), globals_list);
+			while(value == switch_values[i])
+			{
+				i = i + 1;
+				if(i == switch_count) break;
+			}
 		}
-		else if(X86 == Architecture) operation = "sub_ebx,eax\nmov_eax,ebx\n";
-		else if(AMD64 == Architecture) operation = "sub_rbx,rax\nmov_rax,rbx\n";
-		else if(ARMV7L == Architecture) operation = "'0' R0 R0 SUB R1 ARITH2_ALWAYS\n";
-		else if(AARCH64 == Architecture) operation = "SUB_X0_X1_X0\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 sub\n";
+		else emit(default_label, globals_list);
+
+		/* broken for big endian architectures */
+		for(padding = (register_size / 4) - 1; 0 < padding; padding = padding - 1) emit(" %0", globals_list);
+		emit("\n", globals_list);
 	}
-	else if(match("*=", operator))
+}
+
+void switch_dispatch(struct case_list* cases, char* number_string)
+{
+	struct case_list* i;
+	int numeric = TRUE;
+	switch_count = 0;
+	for(i = cases; NULL != i; i = i->next)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-		{
-			if(is_signed) operation = "MUL R0 R1 R0\n";
-			else operation =  "MULU R0 R1 R0\n";
-		}
-		else if(X86 == Architecture)
-		{
-			if(is_signed) operation = "imul_ebx\n";
-			else operation = "mul_ebx\n";
-		}
-		else if(AMD64 == Architecture)
-		{
-			if(is_signed) operation = "imul_rbx\n";
-			else operation = "mul_rbx\n";
-		}
-		else if(ARMV7L == Architecture) operation = "'9' R0 '0' R1 MULS R0 ARITH2_ALWAYS\n";
-		else if(AARCH64 == Architecture) operation = "MUL_X0_X1_X0\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 mul\n";
+		if(!small_number(i->value)) numeric = FALSE;
+		switch_count = switch_count + 1;
 	}
-	else if(match("/=", operator))
+
+	if(!numeric || (4 > switch_count))
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-		{
-			if(is_signed) operation = "DIV R0 R1 R0\n";
-			else operation =  "DIVU R0 R1 R0\n";
-		}
-		else if(X86 == Architecture)
-		{
-			if (is_signed) operation = "xchg_ebx,eax\ncdq\nidiv_ebx\n";
-			else operation = "xchg_ebx,eax\nmov_edx, %0\ndiv_ebx\n";
-		}
-		else if(AMD64 == Architecture)
-		{
-			if(is_signed) operation = "xchg_rbx,rax\ncqo\nidiv_rbx\n";
-			else operation = "xchg_rbx,rax\nmov_rdx, %0\ndiv_rbx\n";
-		}
-		else if(ARMV7L == Architecture)
-		{
-			if(is_signed) operation = "{LR} PUSH_ALWAYS\n^~divides CALL_ALWAYS\n{LR} POP_ALWAYS\n";
-			else operation = "{LR} PUSH_ALWAYS\n^~divide CALL_ALWAYS\n{LR} POP_ALWAYS\n";
-		}
-		else if(AARCH64 == Architecture)
-		{
-			if(is_signed) operation = "SDIV_X0_X1_X0\n";
-			else operation = "UDIV_X0_X1_X0\n";
-		}
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+		for(i = cases; NULL != i; i = i->next) switch_case_jump(i->value, number_string);
+		switch_default_jump(number_string);
+		return;
+	}
+
+	/* Sort the cases by value */
+	switch_values = calloc(switch_count, sizeof(int));
+	switch_names = calloc(switch_count, sizeof(char*));
+	require((NULL != switch_values) && (NULL != switch_names), "Exhausted memory while lowering a switch\n");
+	int n = 0;
+	int j;
+	int value;
+	char* name;
+	for(i = cases; NULL != i; i = i->next)
+	{
+		value = strtoint(i->value);
+		name = i->value;
+		j = n;
+		while(0 < j)
 		{
-			if(is_signed) operation = "rd_a0 rs1_a1 rs2_a0 div\n";
-			else operation = "rd_a0 rs1_a1 rs2_a0 divu\n";
+			if(switch_values[j - 1] <= value) break;
+			switch_values[j] = switch_values[j - 1];
+			switch_names[j] = switch_names[j - 1];
+			j = j - 1;
 		}
+		switch_values[j] = value;
+		switch_names[j] = name;
+		n = n + 1;
 	}
-	else if(match("%=", operator))
+
+	int range = switch_values[switch_count - 1] - switch_values[0] + 1;
+	if((0 < range) && (range <= (switch_count << 1))) switch_table(number_string);
+	else switch_tree(0, switch_count, number_string);
+
+	free(switch_values);
+	free(switch_names);
+}
+
+void process_switch(void)
+{
+	maybe_bootstrap_error("switch/case statements");
+	struct token_list* nested_locals = break_frame;
+	char* nested_break_head = break_target_head;
+	char* nested_break_func = break_target_func;
+	char* nested_break_num = break_target_num;
+	char* nested_continue_head = continue_target_head;
+
+	char* number_string = int2str(current_count, 10, TRUE);
+	current_count = current_count + 1;
+
+	break_target_head = "_SWITCH_END_";
+	continue_target_head = NULL; /* don't allow continue in switch statements */
+	break_target_num = number_string;
+	break_frame = function->locals;
+	break_target_func = function->s;
+
+	emit_out("# switch_");
+	uniqueID_out(function->s, number_string);
+
+	/* get what we are casing on */
+	global_token = global_token->next;
+	require_match("ERROR in process_switch\nMISSING (\n", "(");
+	expression();
+	require_match("ERROR in process_switch\nMISSING )\n", ")");
+
+	/* Put the value in R1 as it is currently in R0 */
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("MOVE R1 R0\n");
+	else if(X86 == Architecture) emit_out("mov_ebx,eax\n");
+	else if(AMD64 == Architecture) emit_out("push_rax\npop_rbx\n");
+	else if(ARMV7L == Architecture) emit_out("'0' R1 R0 NO_SHIFT MOVE_ALWAYS\n");
+	else if(AARCH64 == Architecture) emit_out("SET_X1_FROM_X0\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a1 rs1_a0 mv\n");
+
+	/* Jump to the switch table */
+	ir_jump(label_name("_SWITCH_TABLE_", function->s, number_string), TRUE);
+
+	/* must be switch (exp) {$STATEMENTS}; form */
+	require_match("ERROR in process_switch\nMISSING {\n", "{");
+	struct case_list* backtrack = NULL;
+process_switch_iter:
+	if(keyword_case == global_token->s)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-		{
-			if(is_signed) operation = "MOD R0 R1 R0\n";
-			else operation = "MODU R0 R1 R0\n";
-		}
-		else if(X86 == Architecture)
-		{
-			if(is_signed) operation = "xchg_ebx,eax\ncdq\nidiv_ebx\nmov_eax,edx\n";
-			else operation = "xchg_ebx,eax\nmov_edx, %0\ndiv_ebx\nmov_eax,edx\n";
-		}
-		else if(AMD64 == Architecture)
-		{
-			if(is_signed) operation = "xchg_rbx,rax\ncqo\nidiv_rbx\nmov_rax,rdx\n";
-			else operation = "xchg_rbx,rax\nmov_rdx, %0\ndiv_rbx\nmov_rax,rdx\n";
-		}
-		else if(ARMV7L == Architecture)
-		{
-			if(is_signed) operation = "{LR} PUSH_ALWAYS\n^~moduluss CALL_ALWAYS\n{LR} POP_ALWAYS\n";
-			else operation = "{LR} PUSH_ALWAYS\n^~modulus CALL_ALWAYS\n{LR} POP_ALWAYS\n";
-		}
-		else if(AARCH64 == Architecture)
+		global_token = global_token->next;
+		if(TOKEN_LABEL == global_token->kind)
 		{
-			if(is_signed) operation = "SDIV_X2_X1_X0\nMSUB_X0_X0_X2_X1\n";
-			else operation = "UDIV_X2_X1_X0\nMSUB_X0_X0_X2_X1\n";
+			struct case_list* c = calloc(1, sizeof(struct case_list));
+			c->next = backtrack;
+			c->value = global_token->s + 1;
+			backtrack = c;
+			emit_out(":_SWITCH_CASE_");
+			emit_out(c->value);
+			emit_out("_");
+			uniqueID_out(function->s, number_string);
+			global_token = global_token->next;
+			process_case();
 		}
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+		else line_error();
+		goto process_switch_iter;
+	}
+	else if(keyword_default == global_token->s)
+	{ /* because of how M2-Planet treats labels */
+		global_token = global_token->next;
+		ir_label(label_name("_SWITCH_DEFAULT_", function->s, number_string));
+
+		/* collect statements until } */
+		while(!match("}", global_token->s))
 		{
-			if(is_signed) operation = "rd_a0 rs1_a1 rs2_a0 rem\n";
-			else operation = "rd_a0 rs1_a1 rs2_a0 remu\n";
+			statement();
 		}
+
+		/* jump over the switch table */
+		ir_jump(label_name("_SWITCH_END_", function->s, number_string), TRUE);
 	}
-	else if(match("<<=", operator))
+
+	/* Switch statements must end with } */
+	require_match("ERROR in process_switch\nMISSING }\n", "}");
+
+	/* create the table */
+	ir_label(label_name("_SWITCH_TABLE_", function->s, number_string));
+
+	struct case_list* hold;
+	if(OPTIMIZE) switch_dispatch(backtrack, number_string);
+	else
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-		{
-			if(is_signed) operation = "SAL R0 R1 R0\n";
-			else operation = "SL0 R0 R1 R0\n";
-		}
-		else if(X86 == Architecture)
-		{
-			if(is_signed) operation = "mov_ecx,eax\nmov_eax,ebx\nsal_eax,cl\n";
-			else operation = "mov_ecx,eax\nmov_eax,ebx\nshl_eax,cl\n";
-		}
-		else if(AMD64 == Architecture)
-		{
-			if(is_signed) operation = "mov_rcx,rax\nmov_rax,rbx\nsal_rax,cl\n";
-			else operation = "mov_rcx,rax\nmov_rax,rbx\nshl_rax,cl\n";
-		}
-		else if(ARMV7L == Architecture) operation = "LEFT R1 R0 R0 SHIFT AUX_ALWAYS\n";
-		else if(AARCH64 == Architecture) operation = "LSHIFT_X0_X1_X0\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 sll\n";
+		for(hold = backtrack; NULL != hold; hold = hold->next) switch_case_jump(hold->value, number_string);
+
+		/* Default to :default */
+		switch_default_jump(number_string);
 	}
-	else if(match(">>=", operator))
+	while(NULL != backtrack)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
-		{
-			if(is_signed) operation = "SAR R0 R1 R0\n";
-			else operation = "SR0 R0 R1 R0\n";
-		}
-		else if(X86 == Architecture)
-		{
-			if(is_signed) operation = "mov_ecx,eax\nmov_eax,ebx\nsar_eax,cl\n";
-			else operation = "mov_ecx,eax\nmov_eax,ebx\nshr_eax,cl\n";
-		}
-		else if(AMD64 == Architecture)
-		{
-			if(is_signed) operation = "mov_rcx,rax\nmov_rax,rbx\nsar_rax,cl\n";
-			else operation = "mov_rcx,rax\nmov_rax,rbx\nshr_rax,cl\n";
-		}
-		else if(ARMV7L == Architecture)
-		{
-			if(is_signed) operation = "ARITH_RIGHT R1 R0 R0 SHIFT AUX_ALWAYS\n";
-			else operation = "RIGHT R1 R0 R0 SHIFT AUX_ALWAYS\n";
-		}
-		else if(AARCH64 == Architecture)
-		{
-			if(is_signed) operation = "ARITH_RSHIFT_X0_X1_X0\n";
-			else operation = "LOGICAL_RSHIFT_X0_X1_X0\n";
-		}
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
-		{
-			if(is_signed) operation = "rd_a0 rs1_a1 rs2_a0 sra\n";
-			else operation = "rd_a0 rs1_a1 rs2_a0 srl\n";
-		}
+		hold = backtrack->next;
+		free(backtrack);
+		backtrack = hold;
 	}
-	else if(match("&=", operator))
+
+	/* put the exit of the switch */
+	ir_label(label_name("_SWITCH_END_", function->s, number_string));
+
+	break_target_head = nested_break_head;
+	break_target_func = nested_break_func;
+	break_target_num = nested_break_num;
+	continue_target_head = nested_continue_head;
+	break_frame = nested_locals;
+}
+
+void process_for(void)
+{
+	struct token_list* nested_locals = break_frame;
+	char* nested_break_head = break_target_head;
+	char* nested_break_func = break_target_func;
+	char* nested_break_num = break_target_num;
+	char* nested_continue_head = continue_target_head;
+
+	char* number_string = int2str(current_count, 10, TRUE);
+	current_count = current_count + 1;
+
+	break_target_head = "FOR_END_";
+	continue_target_head = "FOR_ITER_";
+	break_target_num = number_string;
+	break_frame = function->locals;
+	break_target_func = function->s;
+
+	emit_out("# FOR_initialization_");
+	uniqueID_out(function->s, number_string);
+
+	global_token = global_token->next;
+
+	require_match("ERROR in process_for\nMISSING (\n", "(");
+	if(!match(";",global_token->s))
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) operation = "AND R0 R0 R1\n";
-		else if(X86 == Architecture) operation = "and_eax,ebx\n";
-		else if(AMD64 == Architecture) operation = "and_rax,rbx\n";
-		else if(ARMV7L == Architecture) operation = "NO_SHIFT R0 R0 AND R1 ARITH2_ALWAYS\n";
-		else if(AARCH64 == Architecture) operation = "AND_X0_X1_X0\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 and\n";
+		expression();
 	}
-	else if(match("^=", operator))
+
+	/* Under -O1 the step and the test move below the body, entered once through a jump */
+	struct ir_node* test = NULL;
+	struct ir_node* step = NULL;
+	struct ir_node* mark = NULL;
+	if(OPTIMIZE)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) operation = "XOR R0 R0 R1\n";
-		else if(X86 == Architecture) operation = "xor_eax,ebx\n";
-		else if(AMD64 == Architecture) operation = "xor_rax,rbx\n";
-		else if(ARMV7L == Architecture) operation = "'0' R0 R0 XOR R1 ARITH2_ALWAYS\n";
-		else if(AARCH64 == Architecture) operation = "XOR_X0_X1_X0\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 xor\n";
+		ir_jump(label_name("FOR_", function->s, number_string), FALSE);
+		mark = ir_position();
 	}
-	else if(match("|=", operator))
+	ir_label(label_name("FOR_", function->s, number_string));
+
+	require_match("ERROR in process_for\nMISSING ;1\n", ";");
+	expression();
+
+	if(OPTIMIZE)
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) operation = "OR R0 R0 R1\n";
-		else if(X86 == Architecture) operation = "or_eax,ebx\n";
-		else if(AMD64 == Architecture) operation = "or_rax,rbx\n";
-		else if(ARMV7L == Architecture) operation = "NO_SHIFT R0 R0 OR R1 AUX_ALWAYS\n";
-		else if(AARCH64 == Architecture) operation = "OR_X0_X1_X0\n";
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) operation = "rd_a0 rs1_a1 rs2_a0 or\n";
+		condition_jump(label_name("FOR_THEN_", function->s, number_string), FALSE);
+		test = ir_cut(mark);
 	}
 	else
 	{
-		fputs("Found illegal compound assignment operator: ", stderr);
-		fputs(operator, stderr);
-		fputc('\n', stderr);
-		exit(EXIT_FAILURE);
+		jump_on_zero(label_name("FOR_END_", function->s, number_string), TRUE);
+		ir_jump(label_name("FOR_THEN_", function->s, number_string), TRUE);
 	}
-	return operation;
-}
 
+	ir_label(label_name("FOR_ITER_", function->s, number_string));
 
-void expression(void)
-{
-	bitwise_expr();
-	if(match("=", global_token->s))
-	{
-		char* store = "";
-		if(match("]", global_token->prev->s))
-		{
-			store = store_value(current_target->type->size);
-		}
-		else
-		{
-			store = store_value(current_target->size);
-		}
+	require_match("ERROR in process_for\nMISSING ;2\n", ";");
+	expression();
 
-		common_recursion(expression);
-		emit_out(store);
-		current_target = integer;
+	if(OPTIMIZE) step = ir_cut(mark);
+	else ir_jump(label_name("FOR_", function->s, number_string), TRUE);
+
+	ir_label(label_name("FOR_THEN_", function->s, number_string));
+
+	require_match("ERROR in process_for\nMISSING )\n", ")");
+	statement();
+	require(NULL != global_token, "Reached EOF inside of function\n");
+
+	if(OPTIMIZE)
+	{
+		ir_paste(step);
+		ir_paste(test);
 	}
-	else if(is_compound_assignment(global_token->s))
+	else ir_jump(label_name("FOR_ITER_", function->s, number_string), TRUE);
+
+	ir_label(label_name("FOR_END_", function->s, number_string));
+
+	break_target_head = nested_break_head;
+	break_target_func = nested_break_func;
+	break_target_num = nested_break_num;
+	continue_target_head = nested_continue_head;
+	break_frame = nested_locals;
+}
+
+/* Process Assembly statements */
+void process_asm(void)
+{
+	global_token = global_token->next;
+	require_match("ERROR in process_asm\nMISSING (\n", "(");
+	while(TOKEN_STRING == global_token->kind)
 	{
-		maybe_bootstrap_error("compound operator");
-		char* push = "";
-		char* load = "";
-		char* operation = "";
-		char* pop = "";
-		char* store = "";
-		struct type* last_type = current_target;
+		emit_out((global_token->s + 1));
+		emit_out("\n");
+		global_token = global_token->next;
+		require(NULL != global_token, "Received EOF inside asm statement\n");
+	}
+	require_match("ERROR in process_asm\nMISSING )\n", ")");
+	require_match("ERROR in process_asm\nMISSING ;\n", ";");
+}
 
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) push = "PUSHR R1 R15\n";
-		else if(X86 == Architecture) push = "push_ebx\n";
-		else if(AMD64 == Architecture) push = "push_rbx\n";
-		else if(ARMV7L == Architecture) push = "{R1} PUSH_ALWAYS\n";
-		else if(AARCH64 == Architecture) push = "PUSH_X1\n";
-		else if(RISCV32 == Architecture) push = "rs1_sp rs2_a1 @-4 sw\n";
-		else if(RISCV64 == Architecture) push = "rs1_sp rs2_a1 @-8 sd\n";
+/* Process do while loops */
+void process_do(void)
+{
+	struct token_list* nested_locals = break_frame;
+	char* nested_break_head = break_target_head;
+	char* nested_break_func = break_target_func;
+	char* nested_break_num = break_target_num;
+	char* nested_continue_head = continue_target_head;
 
-		if(!match("]", global_token->prev->s) || !match("char*", current_target->name))
-		{
-			if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) load = "LOAD R1 R1 0\n";
-			else if(X86 == Architecture) load = "mov_ebx,[ebx]\n";
-			else if(AMD64 == Architecture) load = "mov_rbx,[rbx]\n";
-			else if(ARMV7L == Architecture) load = "!0 R1 LOAD32 R1 MEMORY\n";
-			else if(AARCH64 == Architecture) load = "DEREF_X1\n";
-			else if(RISCV32 == Architecture) load = "rd_a1 rs1_a1 lw\n";
-			else if(RISCV64 == Architecture) load = "rd_a1 rs1_a1 ld\n";
-		}
-		else
-		{
-			if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) load = "LOAD8 R1 R1 0\n";
-			else if(X86 == Architecture) load = "movsx_ebx,BYTE_PTR_[ebx]\n";
-			else if(AMD64 == Architecture) load = "movsx_rbx,BYTE_PTR_[rbx]\n";
-			else if(ARMV7L == Architecture) load = "LOADU8 R1 LOAD R1 MEMORY\n";
-			else if(AARCH64 == Architecture) load = "DEREF_X1_BYTE\n";
-			else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) load = "rd_a1 rs1_a1 lbu\n";
-		}
+	char* number_string = int2str(current_count, 10, TRUE);
+	current_count = current_count + 1;
 
-		char *operator = global_token->s;
+	break_target_head = "DO_END_";
+	continue_target_head = "DO_TEST_";
+	break_target_num = number_string;
+	break_frame = function->locals;
+	break_target_func = function->s;
 
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) pop = "POPR R1 R15\n";
-		else if(X86 == Architecture) pop = "pop_ebx\n";
-		else if(AMD64 == Architecture) pop = "pop_rbx\n";
-		else if(ARMV7L == Architecture) pop = "{R1} POP_ALWAYS\n";
-		else if(AARCH64 == Architecture) pop = "POP_X1\n";
-		else if(RISCV32 == Architecture) pop = "rd_a1 rs1_sp !-4 lw\n";
-		else if(RISCV64 == Architecture) pop = "rd_a1 rs1_sp !-8 ld\n";
+	ir_label(label_name("DO_", function->s, number_string));
 
-		if(match("]", global_token->prev->s))
-		{
-			store = store_value(current_target->type->size);
-		}
-		else
-		{
-			store = store_value(current_target->size);
-		}
+	global_token = global_token->next;
+	require(NULL != global_token, "Received EOF where do statement is expected\n");
+	statement();
+	require(NULL != global_token, "Reached EOF inside of function\n");
 
-		common_recursion(expression);
-		current_target = promote_type(current_target, last_type);
-		emit_out(push);
-		emit_out(load);
-		operation = compound_operation(operator, current_target->is_signed);
-		emit_out(operation);
-		emit_out(pop);
-		emit_out(store);
-		current_target = integer;
-	}
+	ir_label(label_name("DO_TEST_", function->s, number_string));
+
+	require_match("ERROR in process_do\nMISSING while\n", "while");
+	require_match("ERROR in process_do\nMISSING (\n", "(");
+	expression();
+	require_match("ERROR in process_do\nMISSING )\n", ")");
+	require_match("ERROR in process_do\nMISSING ;\n", ";");
+
+	if(OPTIMIZE) condition_jump(label_name("DO_", function->s, number_string), FALSE);
+	else jump_on_zero(label_name("DO_", function->s, number_string), FALSE);
+
+	ir_label(label_name("DO_END_", function->s, number_string));
+
+	break_frame = nested_locals;
+	break_target_head = nested_break_head;
+	break_target_func = nested_break_func;
+	break_target_num = nested_break_num;
+	continue_target_head = nested_continue_head;
 }
 
 
-int iskeywordp(char* s)
+/* Process while loops */
+void process_while(void)
 {
-	if(match("auto", s)) return TRUE;
-	if(match("break", s)) return TRUE;
-	if(match("case", s)) return TRUE;
-	if(match("char", s)) return TRUE;
-	if(match("const", s)) return TRUE;
-	if(match("continue", s)) return TRUE;
-	if(match("default", s)) return TRUE;
-	if(match("do", s)) return TRUE;
-	if(match("double", s)) return TRUE;
-	if(match("else", s)) return TRUE;
-	if(match("enum", s)) return TRUE;
-	if(match("extern", s)) return TRUE;
-	if(match("float", s)) return TRUE;
-	if(match("for", s)) return TRUE;
-	if(match("goto", s)) return TRUE;
-	if(match("if", s)) return TRUE;
-	if(match("int", s)) return TRUE;
-	if(match("long", s)) return TRUE;
-	if(match("register", s)) return TRUE;
-	if(match("return", s)) return TRUE;
-	if(match("short", s)) return TRUE;
-	if(match("signed", s)) return TRUE;
-	if(match("sizeof", s)) return TRUE;
-	if(match("static", s)) return TRUE;
-	if(match("struct", s)) return TRUE;
-	if(match("switch", s)) return TRUE;
-	if(match("typedef", s)) return TRUE;
-	if(match("union", s)) return TRUE;
-	if(match("unsigned", s)) return TRUE;
-	if(match("void", s)) return TRUE;
-	if(match("volatile", s)) return TRUE;
-	if(match("while", s)) return TRUE;
-	return FALSE;
+	struct token_list* nested_locals = break_frame;
+	char* nested_break_head = break_target_head;
+	char* nested_break_func = break_target_func;
+	char* nested_break_num = break_target_num;
+	char* nested_continue_head = continue_target_head;
+
+	char* number_string = int2str(current_count, 10, TRUE);
+	current_count = current_count + 1;
+
+	break_target_head = "END_WHILE_";
+	continue_target_head = "WHILE_";
+	break_target_num = number_string;
+	break_frame = function->locals;
+	break_target_func = function->s;
+
+	/* Under -O1 the test moves below the body, entered once through a jump */
+	struct ir_node* test = NULL;
+	struct ir_node* mark = NULL;
+	if(OPTIMIZE)
+	{
+		ir_jump(label_name("WHILE_", function->s, number_string), FALSE);
+		mark = ir_position();
+	}
+	ir_label(label_name("WHILE_", function->s, number_string));
+
+	global_token = global_token->next;
+	require_match("ERROR in process_while\nMISSING (\n", "(");
+	expression();
+
+	if(OPTIMIZE)
+	{
+		condition_jump(label_name("WHILE_BODY_", function->s, number_string), FALSE);
+		test = ir_cut(mark);
+		ir_label(label_name("WHILE_BODY_", function->s, number_string));
+	}
+	else jump_on_zero(label_name("END_WHILE_", function->s, number_string), TRUE);
+	emit_out("# THEN_while_");
+	uniqueID_out(function->s, number_string);
+
+	require_match("ERROR in process_while\nMISSING )\n", ")");
+	statement();
+	require(NULL != global_token, "Reached EOF inside of function\n");
+
+	if(OPTIMIZE) ir_paste(test);
+	else ir_jump(label_name("WHILE_", function->s, number_string), TRUE);
+	ir_label(label_name("END_WHILE_", function->s, number_string));
+
+	break_target_head = nested_break_head;
+	break_target_func = nested_break_func;
+	break_target_num = nested_break_num;
+	continue_target_head = nested_continue_head;
+	break_frame = nested_locals;
 }
 
-/* Similar to integer division a / b but rounds up */
-unsigned ceil_div(unsigned a, unsigned b)
+/* Ensure that functions return */
+void return_result(void)
 {
-	return (a + b - 1) / b;
+	global_token = global_token->next;
+	require(NULL != global_token, "Incomplete return statement received\n");
+	if(global_token->s[0] != ';') expression();
+
+	require_match("ERROR in return_result\nMISSING ;\n", ";");
+
+	release_stack(locals_words(function->locals, NULL), "_return_result_locals");
+
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("RET R15\n");
+	else if(X86 == Architecture) emit_out("ret\n");
+	else if(AMD64 == Architecture) emit_out("ret\n");
+	else if(ARMV7L == Architecture) emit_out("'1' LR RETURN\n");
+	else if(AARCH64 == Architecture) emit_out("RETURN\n");
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("ret\n");
 }
 
-/* Process local variable */
-void collect_local(void)
+void process_break(void)
 {
-	if(NULL != break_target_func)
+	if(NULL == break_target_head)
 	{
-		fputs("Local variable initialized inside of loop in file: ", stderr);
 		line_error();
-		fputs("\nMove the variable outside of the loop to resolve\n", stderr);
-		fputs("Otherwise the binary will segfault while running\n", stderr);
-		exit(EXIT_FAILURE);
-	}
-	struct type* type_size = type_name();
-	require(NULL != global_token, "Received EOF while collecting locals\n");
-	require(!in_set(global_token->s[0], "[{(<=>)}]|&!^%;:'\""), "forbidden character in local variable name\n");
-	require(!iskeywordp(global_token->s), "You are not allowed to use a keyword as a local variable name\n");
-	require(NULL != type_size, "Must have non-null type\n");
-	struct token_list* a = sym_declare(global_token->s, type_size, function->locals);
-	if(match("main", function->s) && (NULL == function->locals))
-	{
-		if(KNIGHT_NATIVE == Architecture) a->depth = register_size;
-		else if(KNIGHT_POSIX == Architecture) a->depth = 20;
-		else if(X86 == Architecture) a->depth = -20;
-		else if(AMD64 == Architecture) a->depth = -40;
-		else if(ARMV7L == Architecture) a->depth = 16;
-		else if(AARCH64 == Architecture) a->depth = 32; /* argc, argv, envp and the local (8 bytes each) */
-		else if(RISCV32 == Architecture) a->depth = -16;
-		else if(RISCV64 == Architecture) a->depth = -32;
-	}
-	else if((NULL == function->arguments) && (NULL == function->locals))
-	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) a->depth = register_size;
-		else if(X86 == Architecture) a->depth = -8;
-		else if(AMD64 == Architecture) a->depth = -16;
-		else if(ARMV7L == Architecture) a->depth = 8;
-		else if(AARCH64 == Architecture) a->depth = register_size;
-		else if(RISCV32 == Architecture) a->depth = -4;
-		else if(RISCV64 == Architecture) a->depth = -8;
-	}
-	else if(NULL == function->locals)
-	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) a->depth = function->arguments->depth + 8;
-		else if(X86 == Architecture) a->depth = function->arguments->depth - 8;
-		else if(AMD64 == Architecture) a->depth = function->arguments->depth - 16;
-		else if(ARMV7L == Architecture) a->depth = function->arguments->depth + 8;
-		else if(AARCH64 == Architecture) a->depth = function->arguments->depth + register_size;
-		else if(RISCV32 == Architecture) a->depth = function->arguments->depth - 4;
-		else if(RISCV64 == Architecture) a->depth = function->arguments->depth - 8;
-	}
-	else
-	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) a->depth = function->locals->depth + register_size;
-		else if(X86 == Architecture) a->depth = function->locals->depth - register_size;
-		else if(AMD64 == Architecture) a->depth = function->locals->depth - register_size;
-		else if(ARMV7L == Architecture) a->depth = function->locals->depth + register_size;
-		else if(AARCH64 == Architecture) a->depth = function->locals->depth + register_size;
-		else if(RISCV32 == Architecture) a->depth = function->locals->depth - register_size;
-		else if(RISCV64 == Architecture) a->depth = function->locals->depth - register_size;
+		fputs("Not inside of a loop or case statement\n", stderr);
+		compile_failure();
 	}
+	release_stack(locals_words(function->locals, break_frame), "break_cleanup_locals");
+	global_token = global_token->next;
 
-	/* Adjust the depth of local structs. When stack grows downwards, we want them to 
-	   start at the bottom of allocated space. */
-	unsigned struct_depth_adjustment = (ceil_div(a->type->size, register_size) - 1) * register_size;
-	if(KNIGHT_POSIX == Architecture) a->depth = a->depth + struct_depth_adjustment;
-	else if(KNIGHT_NATIVE == Architecture) a->depth = a->depth + struct_depth_adjustment;
-	else if(X86 == Architecture) a->depth = a->depth - struct_depth_adjustment;
-	else if(AMD64 == Architecture) a->depth = a->depth - struct_depth_adjustment;
-	else if(ARMV7L == Architecture) a->depth = a->depth + struct_depth_adjustment;
-	else if(AARCH64 == Architecture) a->depth = a->depth + struct_depth_adjustment;
-	else if(RISCV32 == Architecture) a->depth = a->depth - struct_depth_adjustment;
-	else if(RISCV64 == Architecture) a->depth = a->depth - struct_depth_adjustment;
+	ir_jump(label_name(break_target_head, break_target_func, break_target_num), FALSE);
+	require_match("ERROR in break statement\nMissing ;\n", ";");
+}
 
-	function->locals = a;
+void process_continue(void)
+{
+	if(NULL == continue_target_head)
+	{
+		line_error();
+		fputs("Not inside of a loop\n", stderr);
+		compile_failure();
+	}
+	global_token = global_token->next;
 
-	emit_out("# Defining local ");
-	emit_out(global_token->s);
-	emit_out("\n");
+	ir_jump(label_name(continue_target_head, break_target_func, break_target_num), FALSE);
+	require_match("ERROR in continue statement\nMissing ;\n", ";");
+}
 
+void recursive_statement(void)
+{
 	global_token = global_token->next;
-	require(NULL != global_token, "incomplete local missing name\n");
+	require(NULL != global_token, "Received EOF in recursive statement\n");
+	struct token_list* frame = function->locals;
 
-	if(match("=", global_token->s))
+	while(!match("}", global_token->s))
 	{
-		global_token = global_token->next;
-		require(NULL != global_token, "incomplete local assignment\n");
-		expression();
+		statement();
+		require(NULL != global_token, "Received EOF in recursive statement prior to }\n");
 	}
+	global_token = global_token->next;
 
-	require_match("ERROR in collect_local\nMissing ;\n", ";");
+	/* Clean up any locals added */
 
-	unsigned i = (a->type->size + register_size - 1) / register_size;
-	while(i != 0)
+	if(((X86 == Architecture) && !last_emitted(output_list, "ret\n")) ||
+	   ((AMD64 == Architecture) && !last_emitted(output_list, "ret\n")) ||
+	   (((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) && !last_emitted(output_list, "RET R15\n")) ||
+	   ((ARMV7L == Architecture) && !last_emitted(output_list, "'1' LR RETURN\n")) ||
+	   ((AARCH64 == Architecture) && !last_emitted(output_list, "RETURN\n")) ||
+	   (((RISCV32 == Architecture) || (RISCV64 == Architecture)) && !last_emitted(output_list, "ret\n")))
 	{
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("PUSHR R0 R15\t#");
-		else if(X86 == Architecture) emit_out("push_eax\t#");
-		else if(AMD64 == Architecture) emit_out("push_rax\t#");
-		else if(ARMV7L == Architecture) emit_out("{R0} PUSH_ALWAYS\t#");
-		else if(AARCH64 == Architecture) emit_out("PUSH_X0\t#");
-		else if(RISCV32 == Architecture) emit_out("rd_sp rs1_sp !-4 addi\nrs1_sp rs2_a0 sw\t#");
-		else if(RISCV64 == Architecture) emit_out("rd_sp rs1_sp !-8 addi\nrs1_sp rs2_a0 sd\t#");
-		emit_out(a->s);
-		emit_out("\n");
-		i = i - 1;
+		release_stack(locals_words(function->locals, frame), "_recursive_statement_locals");
 	}
+	sym_unindex_list(scope_table, function->locals, frame);
+	function->locals = frame;
 }
 
-void statement(void);
+/*
+ * statement:
+ *     { statement-list-opt }
+ *     type-name identifier ;
+ *     type-name identifier = expression;
+ *     if ( expression ) statement
+ *     if ( expression ) statement else statement
+ *     do statement while ( expression ) ;
+ *     while ( expression ) statement
+ *     for ( expression ; expression ; expression ) statement
+ *     asm ( "assembly" ... "assembly" ) ;
+ *     goto label ;
+ *     label:
+ *     return ;
+ *     break ;
+ *     expr ;
+ */
 
-/* Evaluate if statements */
-void process_if(void)
+struct type* lookup_primitive(char* s);
+void statement(void)
 {
-	char* number_string = int2str(current_count, 10, TRUE);
-	current_count = current_count + 1;
+	require(NULL != global_token, "expected a C statement but received EOF\n");
+	/* Always an integer until told otherwise */
+	current_target = integer;
 
-	emit_out("# IF_");
-	uniqueID_out(function->s, number_string);
+	if(global_token->s[0] == '{')
+	{
+		recursive_statement();
+	}
+	else if(TOKEN_LABEL == global_token->kind)
+	{
+		emit_out(global_token->s);
+		emit_out("\t#C goto label\n");
+		global_token = global_token->next;
+	}
+	else if((NULL != lookup_primitive(global_token->s)) ||
+	          (keyword_struct == global_token->s))
+	{
+		collect_local();
+	}
+	else if(keyword_if == global_token->s)
+	{
+		process_if();
+	}
+	else if(keyword_switch == global_token->s)
+	{
+		process_switch();
+	}
+	else if(keyword_do == global_token->s)
+	{
+		process_do();
+	}
+	else if(keyword_while == global_token->s)
+	{
+		process_while();
+	}
+	else if(keyword_for == global_token->s)
+	{
+		process_for();
+	}
+	else if(keyword_asm == global_token->s)
+	{
+		process_asm();
+	}
+	else if(keyword_goto == global_token->s)
+	{
+		global_token = global_token->next;
+		require(NULL != global_token, "naked goto is not supported\n");
+		ir_jump(global_token->s, FALSE);
+		global_token = global_token->next;
+		require_match("ERROR in statement\nMissing ;\n", ";");
+	}
+	else if(keyword_return == global_token->s)
+	{
+		return_result();
+	}
+	else if(keyword_break == global_token->s)
+	{
+		process_break();
+	}
+	else if(keyword_continue == global_token->s)
+	{
+		process_continue();
+	}
+	else
+	{
+		expression();
+		require_match("ERROR in statement\nMISSING ;\n", ";");
+	}
+}
 
+/* Collect function arguments */
+void collect_arguments(void)
+{
 	global_token = global_token->next;
-	require_match("ERROR in process_if\nMISSING (\n", "(");
-	expression();
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP.Z R0 @ELSE_");
-	else if(X86 == Architecture) emit_out("test_eax,eax\nje %ELSE_");
-	else if(AMD64 == Architecture) emit_out("test_rax,rax\nje %ELSE_");
-	else if(ARMV7L == Architecture) emit_out("!0 CMPI8 R0 IMM_ALWAYS\n^~ELSE_");
-	else if(AARCH64 == Architecture) emit_out("CBNZ_X0_PAST_BR\nLOAD_W16_AHEAD\nSKIP_32_DATA\n&ELSE_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rs1_a0 @8 bnez\n$ELSE_");
+	require(NULL != global_token, "Received EOF when attempting to collect arguments\n");
+	struct type* type_size;
+	struct token_list* a;
 
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_EQUAL\n");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
+	while(!match(")", global_token->s))
+	{
+		type_size = type_name();
+		require(NULL != global_token, "Received EOF when attempting to collect arguments\n");
+		require(NULL != type_size, "Must have non-null type\n");
+		if(global_token->s[0] == ')')
+		{
+			/* foo(int,char,void) doesn't need anything done */
+			continue;
+		}
+		else if(global_token->s[0] != ',')
+		{
+			/* deal with foo(int a, char b) */
+			require(!in_set(global_token->s[0], "[{(<=>)}]|&!^%;:'\""), "forbidden character in argument variable name\n");
+			require(TOKEN_KEYWORD != global_token->kind, "You are not allowed to use a keyword as a argument variable name\n");
+			a = sym_declare(global_token->s, type_size, function->arguments);
+			if(NULL == function->arguments)
+			{
+				if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) a->depth = 0;
+				else if(X86 == Architecture) a->depth = -4;
+				else if(AMD64 == Architecture) a->depth = -8;
+				else if(ARMV7L == Architecture) a->depth = 4;
+				else if(AARCH64 == Architecture) a->depth = register_size;
+				else if(RISCV32 == Architecture) a->depth = -4;
+				else if(RISCV64 == Architecture) a->depth = -8;
+			}
+			else
+			{
+				if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) a->depth = function->arguments->depth + register_size;
+				else if(X86 == Architecture) a->depth = function->arguments->depth - register_size;
+				else if(AMD64 == Architecture) a->depth = function->arguments->depth - register_size;
+				else if(ARMV7L == Architecture) a->depth = function->arguments->depth + register_size;
+				else if(AARCH64 == Architecture) a->depth = function->arguments->depth + register_size;
+				else if(RISCV32 == Architecture) a->depth = function->arguments->depth - register_size;
+				else if(RISCV64 == Architecture) a->depth = function->arguments->depth - register_size;
+			}
 
-	require_match("ERROR in process_if\nMISSING )\n", ")");
-	statement();
-	require(NULL != global_token, "Reached EOF inside of function\n");
+			global_token = global_token->next;
+			require(NULL != global_token, "Incomplete argument list\n");
+			function->arguments = a;
+			sym_index(scope_table, a);
+		}
 
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @_END_IF_");
-	else if(X86 == Architecture) emit_out("jmp %_END_IF_");
-	else if(AMD64 == Architecture) emit_out("jmp %_END_IF_");
-	else if(ARMV7L == Architecture) emit_out("^~_END_IF_");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&_END_IF_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$_END_IF_");
+		/* ignore trailing comma (needed for foo(bar(), 1); expressions*/
+		if(global_token->s[0] == ',')
+		{
+			global_token = global_token->next;
+			require(NULL != global_token, "naked comma in collect arguments\n");
+		}
 
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS\n");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
+		require(NULL != global_token, "Argument list never completed\n");
+	}
+	global_token = global_token->next;
+}
 
-	emit_out(":ELSE_");
-	uniqueID_out(function->s, number_string);
+/*
+ * Scratch registers for expression temporaries (-O1) on the targets that
+ * have caller saved registers to spare: r8 to r11 on amd64, x9 to x15 on
+ * aarch64 and a3 to a7 on riscv.  Nothing else M2-Planet generates touches them, but the callee of
+ * a function call might, so only temporaries that live across no call are
+ * kept in them.
+ */
+char** scratch_save;
+char** scratch_restore;
 
-	if(match("else", global_token->s))
-	{
-		global_token = global_token->next;
-		require(NULL != global_token, "Received EOF where an else statement expected\n");
-		statement();
-		require(NULL != global_token, "Reached EOF inside of function\n");
-	}
-	emit_out(":_END_IF_");
-	uniqueID_out(function->s, number_string);
+int scratch_count(void)
+{
+	if(AMD64 == Architecture) return 4;
+	else if(AARCH64 == Architecture) return 7;
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) return 5;
+	return 0;
 }
 
-void process_case(void)
+void init_scratch(void)
 {
-process_case_iter:
-	if(match("case", global_token->s)) return;
-	if(match(":default", global_token->s)) return;
+	int count = scratch_count();
+	scratch_save = calloc(count + 1, sizeof(char*));
+	scratch_restore = calloc(count + 1, sizeof(char*));
+	require((NULL != scratch_save) && (NULL != scratch_restore), "Exhausted memory while setting up scratch registers\n");
 
-	if(match("break", global_token->s))
-	{
-		statement();
-	}
-	else
+	int k;
+	char* r;
+	for(k = 0; k < count; k = k + 1)
 	{
-		statement();
-		goto process_case_iter;
+		if(AMD64 == Architecture)
+		{
+			/* mov r8+k, rax and mov rbx, r8+k */
+			r = int2str(k + 8, 10, TRUE);
+			scratch_save[k] = o1_define(concat(concat("O1_mov_r", r), ",rax"), hex_bytes(0xC08949 + (k << 16), 3));
+			scratch_restore[k] = o1_define(concat("O1_mov_rbx,r", r), hex_bytes(0xC3894C + (k << 19), 3));
+		}
+		else if(AARCH64 == Architecture)
+		{
+			/* orr x9+k, xzr, x0 and orr x1, xzr, x9+k */
+			r = int2str(k + 9, 10, TRUE);
+			scratch_save[k] = o1_define(concat(concat("O1_SET_X", r), "_FROM_X0"), hex_bytes(0xAA0003E9 + k, 4));
+			scratch_restore[k] = o1_define(concat("O1_SET_X1_FROM_X", r), hex_bytes(0xAA0903E1 + (k << 16), 4));
+		}
+		else
+		{
+			r = int2str(k + 3, 10, TRUE);
+			scratch_save[k] = concat(concat("rd_a", r), " rs1_a0 mv");
+			scratch_restore[k] = concat(concat("rd_a1 rs1_a", r), " mv");
+		}
 	}
 }
 
-void process_switch(void)
+/* Keep temporaries that live across no function call in scratch registers */
+void ir_allocate_registers(void)
 {
-	maybe_bootstrap_error("switch/case statements");
-	struct token_list* nested_locals = break_frame;
-	char* nested_break_head = break_target_head;
-	char* nested_break_func = break_target_func;
-	char* nested_break_num = break_target_num;
-	char* nested_continue_head = continue_target_head;
-
-	char* number_string = int2str(current_count, 10, TRUE);
-	current_count = current_count + 1;
-
-	break_target_head = "_SWITCH_END_";
-	continue_target_head = NULL; /* don't allow continue in switch statements */
-	break_target_num = number_string;
-	break_frame = function->locals;
-	break_target_func = function->s;
-
-	emit_out("# switch_");
-	uniqueID_out(function->s, number_string);
-
-	/* get what we are casing on */
-	global_token = global_token->next;
-	require_match("ERROR in process_switch\nMISSING (\n", "(");
-	expression();
-	require_match("ERROR in process_switch\nMISSING )\n", ")");
-
-	/* Put the value in R1 as it is currently in R0 */
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("MOVE R1 R0\n");
-	else if(X86 == Architecture) emit_out("mov_ebx,eax\n");
-	else if(AMD64 == Architecture) emit_out("push_rax\npop_rbx\n");
-	else if(ARMV7L == Architecture) emit_out("'0' R1 R0 NO_SHIFT MOVE_ALWAYS\n");
-	else if(AARCH64 == Architecture) emit_out("SET_X1_FROM_X0\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a1 rs1_a0 mv\n");
-
-	/* Jump to the switch table */
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @_SWITCH_TABLE_");
-	else if(X86 == Architecture) emit_out("jmp %_SWITCH_TABLE_");
-	else if(AMD64 == Architecture) emit_out("jmp %_SWITCH_TABLE_");
-	else if(ARMV7L == Architecture) emit_out("^~_SWITCH_TABLE_");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&_SWITCH_TABLE_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$_SWITCH_TABLE_");
-
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS\n");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
+	int limit = scratch_count();
+	if(0 == limit) return;
 
-	/* must be switch (exp) {$STATEMENTS}; form */
-	require_match("ERROR in process_switch\nMISSING {\n", "{");
-	struct case_list* backtrack = NULL;
-process_switch_iter:
-	if(match("case", global_token->s))
+	/* Pair every push with its pop, reg is -1 if a call happened in between */
+	struct ir_node* open = NULL;
+	struct ir_node* n;
+	struct ir_node* p;
+	int calls = 0;
+	for(n = ir_head; NULL != n; n = n->next)
 	{
-		global_token = global_token->next;
-		if(':' == global_token->s[0])
+		if(IR_PUSH == n->op)
 		{
-			struct case_list* c = calloc(1, sizeof(struct case_list));
-			c->next = backtrack;
-			c->value = global_token->s + 1;
-			backtrack = c;
-			emit_out(":_SWITCH_CASE_");
-			emit_out(c->value);
-			emit_out("_");
-			uniqueID_out(function->s, number_string);
-			global_token = global_token->next;
-			process_case();
+			n->partner = open;
+			n->reg = calls;
+			open = n;
 		}
-		else line_error();
-		goto process_switch_iter;
+		else if(IR_POP == n->op)
+		{
+			require(NULL != open, "Impossible unbalanced expression stack\n");
+			p = open;
+			open = p->partner;
+			p->partner = n;
+			n->partner = p;
+			if(p->reg == calls) p->reg = 0;
+			else p->reg = -1;
+		}
+		else if(IR_CALL == n->op) calls = calls + 1;
 	}
-	else if(match(":default", global_token->s))
-	{ /* because of how M2-Planet treats labels */
-		global_token = global_token->next;
-		emit_out(":_SWITCH_DEFAULT_");
-		uniqueID_out(function->s, number_string);
 
-		/* collect statements until } */
-		while(!match("}", global_token->s))
+	/* Nesting depth decides the register, deeper than we have stays on the stack */
+	int depth = 0;
+	for(n = ir_head; NULL != n; n = n->next)
+	{
+		if(IR_PUSH == n->op)
 		{
-			statement();
+			if((0 == n->reg) && (depth < limit))
+			{
+				depth = depth + 1;
+				n->reg = depth;
+			}
+			else n->reg = 0;
+			p = n->partner;
+			p->reg = n->reg;
 		}
-
-		/* jump over the switch table */
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @_SWITCH_END_");
-		else if(X86 == Architecture) emit_out("jmp %_SWITCH_END_");
-		else if(AMD64 == Architecture) emit_out("jmp %_SWITCH_END_");
-		else if(ARMV7L == Architecture) emit_out("^~_SWITCH_END_");
-		else if(AARCH64 == Architecture) emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&_SWITCH_END_");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$_SWITCH_END_");
-
-		uniqueID_out(function->s, number_string);
-		if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS\n");
-		else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
+		else if((IR_POP == n->op) && (0 != n->reg)) depth = depth - 1;
 	}
+}
 
-	/* Switch statements must end with } */
-	require_match("ERROR in process_switch\nMISSING }\n", "}");
-
-	/* create the table */
-	emit_out(":_SWITCH_TABLE_");
-	uniqueID_out(function->s, number_string);
+void lower_jump(struct ir_node* n, struct emit_buffer* b)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit("JUMP @", b);
+	else if((X86 == Architecture) || (AMD64 == Architecture)) emit("jmp %", b);
+	else if(ARMV7L == Architecture) emit("^~", b);
+	else if(AARCH64 == Architecture) emit("LOAD_W16_AHEAD\nSKIP_32_DATA\n&", b);
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit("$", b);
+	emit(n->s, b);
+
+	if(n->split)
+	{
+		emit("\n", b);
+		if(ARMV7L == Architecture) emit(" JUMP_ALWAYS\n", b);
+		else if(AARCH64 == Architecture) emit("\nBR_X16\n", b);
+		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit("jal\n", b);
+		return;
+	}
+	if(ARMV7L == Architecture) emit(" JUMP_ALWAYS", b);
+	else if(AARCH64 == Architecture) emit("\nBR_X16", b);
+	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit(" jal", b);
+	emit("\n", b);
+}
 
-	struct case_list* hold;
-	while(NULL != backtrack)
+/* Write the M1 for the collected function into b */
+void lower_ir(struct emit_buffer* b)
+{
+	struct ir_node* n;
+	char hold;
+	for(n = ir_head; NULL != n; n = n->next)
 	{
-		/* put case value in R0 as the switch (value) is in R1 */
-		primary_expr_number(backtrack->value);
-		hold = backtrack->next;
-
-		/* compare R0 and R1 and jump to case if equal */
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("CMPU R0 R0 R1\nJUMP.E R0 @_SWITCH_CASE_");
-		else if(X86 == Architecture) emit_out("cmp\nje %_SWITCH_CASE_");
-		else if(AMD64 == Architecture) emit_out("cmp_rbx,rax\nje %_SWITCH_CASE_");
-		else if(ARMV7L == Architecture) emit_out("'0' R0 CMP R1 AUX_ALWAYS\n^~_SWITCH_CASE_");
-		else if(AARCH64 == Architecture) emit_out("CMP_X1_X0\nSKIP_32_DATA\n&_SWITCH_CASE_");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rd_a0 rs1_a0 rs2_a1 sub\nrs1_a0 @8 bnez\n$_SWITCH_CASE_");
-
-		emit_out(backtrack->value);
-		emit_out("_");
-		uniqueID_out(function->s, number_string);
-		if(ARMV7L == Architecture) emit_out(" JUMP_EQUAL\n");
-		else if(AARCH64 == Architecture) emit_out("\nSKIP_INST_NE\nBR_X16\n");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
-
-		free(backtrack);
-		backtrack = hold;
+		if((IR_TEXT == n->op) || (IR_COMPARE == n->op))
+		{
+			/* output_list keeps room for a terminator past its end */
+			hold = output_list->data[n->end];
+			output_list->data[n->end] = 0;
+			emit(output_list->data + n->start, b);
+			output_list->data[n->end] = hold;
+		}
+		else if(IR_LABEL == n->op)
+		{
+			emit(":", b);
+			emit(n->s, b);
+			emit("\n", b);
+		}
+		else if(IR_JUMP == n->op) lower_jump(n, b);
+		else if((IR_PUSH == n->op) && (0 != n->reg))
+		{
+			emit(scratch_save[n->reg - 1], b);
+			emit("\t#_common_recursion\n", b);
+		}
+		else if((IR_POP == n->op) && (0 != n->reg))
+		{
+			emit(scratch_restore[n->reg - 1], b);
+			emit("\t# _common_recursion\n", b);
+		}
+		else if(IR_PUSH == n->op)
+		{
+			if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit("PUSHR R0 R15\t#_common_recursion\n", b);
+			else if(X86 == Architecture) emit("push_eax\t#_common_recursion\n", b);
+			else if(AMD64 == Architecture) emit("push_rax\t#_common_recursion\n", b);
+			else if(ARMV7L == Architecture) emit("{R0} PUSH_ALWAYS\t#_common_recursion\n", b);
+			else if(AARCH64 == Architecture) emit("PUSH_X0\t#_common_recursion\n", b);
+			else if(RISCV32 == Architecture) emit("rd_sp rs1_sp !-4 addi\t# _common_recursion\nrs1_sp rs2_a0 sw\n", b);
+			else if(RISCV64 == Architecture) emit("rd_sp rs1_sp !-8 addi\t# _common_recursion\nrs1_sp rs2_a0 sd\n", b);
+		}
+		else if(IR_POP == n->op)
+		{
+			if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit("POPR R1 R15\t# _common_recursion\n", b);
+			else if(X86 == Architecture) emit("pop_ebx\t# _common_recursion\n", b);
+			else if(AMD64 == Architecture) emit("pop_rbx\t# _common_recursion\n", b);
+			else if(ARMV7L == Architecture) emit("{R1} POP_ALWAYS\t# _common_recursion\n", b);
+			else if(AARCH64 == Architecture) emit("POP_X1\t# _common_recursion\n", b);
+			else if(RISCV32 == Architecture) emit("rd_a1 rs1_sp lw\nrd_sp rs1_sp !4 addi\t# _common_recursion\n", b);
+			else if(RISCV64 == Architecture) emit("rd_a1 rs1_sp ld\nrd_sp rs1_sp !8 addi\t# _common_recursion\n", b);
+		}
+		else if(IR_CONSTANT == n->op) lower_constant(n->s, b);
 	}
-
-	/* Default to :default */
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @_SWITCH_DEFAULT_");
-	else if(X86 == Architecture) emit_out("jmp %_SWITCH_DEFAULT_");
-	else if(AMD64 == Architecture) emit_out("jmp %_SWITCH_DEFAULT_");
-	else if(ARMV7L == Architecture) emit_out("^~_SWITCH_DEFAULT_");
-	else if(AARCH64 == Architecture) emit_out("SKIP_32_DATA\n&_SWITCH_DEFAULT_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$_SWITCH_DEFAULT_");
-
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS\n");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
-
-	/* put the exit of the switch */
-	emit_out(":_SWITCH_END_");
-	uniqueID_out(function->s, number_string);
-
-	break_target_head = nested_break_head;
-	break_target_func = nested_break_func;
-	break_target_num = nested_break_num;
-	continue_target_head = nested_continue_head;
-	break_frame = nested_locals;
 }
 
-void process_for(void)
+/* Drop jumps to a label that directly follows them */
+void ir_jump_threading(void)
 {
-	struct token_list* nested_locals = break_frame;
-	char* nested_break_head = break_target_head;
-	char* nested_break_func = break_target_func;
-	char* nested_break_num = break_target_num;
-	char* nested_continue_head = continue_target_head;
-
-	char* number_string = int2str(current_count, 10, TRUE);
-	current_count = current_count + 1;
-
-	break_target_head = "FOR_END_";
-	continue_target_head = "FOR_ITER_";
-	break_target_num = number_string;
-	break_frame = function->locals;
-	break_target_func = function->s;
-
-	emit_out("# FOR_initialization_");
-	uniqueID_out(function->s, number_string);
-
-	global_token = global_token->next;
-
-	require_match("ERROR in process_for\nMISSING (\n", "(");
-	if(!match(";",global_token->s))
+	struct ir_node* prev = NULL;
+	struct ir_node* n = ir_head;
+	struct ir_node* i;
+	while(NULL != n)
 	{
-		expression();
+		if(IR_JUMP == n->op)
+		{
+			for(i = n->next; NULL != i; i = i->next)
+			{
+				if(IR_LABEL != i->op)
+				{
+					i = NULL;
+					break;
+				}
+				if(match(n->s, i->s)) break;
+			}
+			if(NULL != i)
+			{
+				if(NULL == prev) ir_head = n->next;
+				else prev->next = n->next;
+				if(NULL != n->next) n->next->prev = prev;
+				i = n;
+				n = n->next;
+				i->next = ir_free;
+				ir_free = i;
+				continue;
+			}
+		}
+		prev = n;
+		n = n->next;
 	}
-
-	emit_out(":FOR_");
-	uniqueID_out(function->s, number_string);
-
-	require_match("ERROR in process_for\nMISSING ;1\n", ";");
-	expression();
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP.Z R0 @FOR_END_");
-	else if(X86 == Architecture) emit_out("test_eax,eax\nje %FOR_END_");
-	else if(AMD64 == Architecture) emit_out("test_rax,rax\nje %FOR_END_");
-	else if(ARMV7L == Architecture) emit_out("!0 CMPI8 R0 IMM_ALWAYS\n^~FOR_END_");
-	else if(AARCH64 == Architecture) emit_out("CBNZ_X0_PAST_BR\nLOAD_W16_AHEAD\nSKIP_32_DATA\n&FOR_END_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rs1_a0 @8 bnez\n$FOR_END_");
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_EQUAL\n");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @FOR_THEN_");
-	else if(X86 == Architecture) emit_out("jmp %FOR_THEN_");
-	else if(AMD64 == Architecture) emit_out("jmp %FOR_THEN_");
-	else if(ARMV7L == Architecture) emit_out("^~FOR_THEN_");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&FOR_THEN_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$FOR_THEN_");
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS\n");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
-
-	emit_out(":FOR_ITER_");
-	uniqueID_out(function->s, number_string);
-
-	require_match("ERROR in process_for\nMISSING ;2\n", ";");
-	expression();
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @FOR_");
-	else if(X86 == Architecture) emit_out("jmp %FOR_");
-	else if(AMD64 == Architecture) emit_out("jmp %FOR_");
-	else if(ARMV7L == Architecture) emit_out("^~FOR_");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&FOR_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$FOR_");
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS\n");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
-
-	emit_out(":FOR_THEN_");
-	uniqueID_out(function->s, number_string);
-
-	require_match("ERROR in process_for\nMISSING )\n", ")");
-	statement();
-	require(NULL != global_token, "Reached EOF inside of function\n");
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @FOR_ITER_");
-	else if(X86 == Architecture) emit_out("jmp %FOR_ITER_");
-	else if(AMD64 == Architecture) emit_out("jmp %FOR_ITER_");
-	else if(ARMV7L == Architecture) emit_out("^~FOR_ITER_");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&FOR_ITER_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$FOR_ITER_");
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS\n");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
-
-	emit_out(":FOR_END_");
-	uniqueID_out(function->s, number_string);
-
-	break_target_head = nested_break_head;
-	break_target_func = nested_break_func;
-	break_target_num = nested_break_num;
-	continue_target_head = nested_continue_head;
-	break_frame = nested_locals;
+	ir_tail = prev;
 }
 
-/* Process Assembly statements */
-void process_asm(void)
+void peephole(struct emit_buffer* b);
+void prune_function(struct emit_buffer* b);
+struct emit_buffer* lowered;
+
+/* Optimize, lower and write out the function collected so far */
+void write_function(FILE* out)
 {
-	global_token = global_token->next;
-	require_match("ERROR in process_asm\nMISSING (\n", "(");
-	while('"' == global_token->s[0])
+	ir_text();
+	if(OPTIMIZE)
 	{
-		emit_out((global_token->s + 1));
-		emit_out("\n");
-		global_token = global_token->next;
-		require(NULL != global_token, "Received EOF inside asm statement\n");
+		if(NULL == scratch_save) init_scratch();
+		ir_jump_threading();
+		ir_allocate_registers();
 	}
-	require_match("ERROR in process_asm\nMISSING )\n", ")");
-	require_match("ERROR in process_asm\nMISSING ;\n", ";");
+
+	if(NULL == lowered) lowered = new_emit_buffer();
+	lower_ir(lowered);
+	if(OPTIMIZE) peephole(lowered);
+	if(PRUNE) prune_function(lowered);
+	else write_emit_buffer(lowered, out);
+
+	/* Reuse the nodes and text storage for the next function */
+	if(NULL != ir_tail)
+	{
+		ir_tail->next = ir_free;
+		ir_free = ir_head;
+	}
+	ir_head = NULL;
+	ir_tail = NULL;
+	ir_mark = 0;
+	output_list->length = 0;
+	output_list->last = 0;
 }
 
-/* Process do while loops */
-void process_do(void)
+/*
+ * Dead code elimination (--prune).  Functions are held back as text
+ * instead of being streamed out.  At the end that text, one entry per
+ * function, and globals_list and strings_list, one entry per :label line,
+ * are written out only when a label they define is named by an entry
+ * that is already kept, starting from main and the --keep names.
+ * Entries that define no label at all are always kept.
+ */
+struct prune_entry
 {
-	struct token_list* nested_locals = break_frame;
-	char* nested_break_head = break_target_head;
-	char* nested_break_func = break_target_func;
-	char* nested_break_num = break_target_num;
-	char* nested_continue_head = continue_target_head;
+	struct prune_entry* next;
+	struct prune_entry* work;
+	struct emit_buffer* b;
+	int start;
+	int end;
+	int live;
+};
+
+/* A label and the entry that defines it, name is not NUL terminated */
+struct prune_label
+{
+	struct prune_label* next;
+	char* name;
+	int length;
+	struct prune_entry* entry;
+};
+
+struct emit_buffer* function_text;
+struct prune_entry* function_entries;
+struct prune_entry* function_entries_tail;
+struct prune_entry* prune_work;
+struct prune_label** prune_table;
+struct token_list* keep_list;
+
+/* Another root for --prune */
+void prune_keep(char* name)
+{
+	keep_list = sym_declare(name, NULL, keep_list);
+}
 
-	char* number_string = int2str(current_count, 10, TRUE);
-	current_count = current_count + 1;
+struct prune_entry* prune_entry_new(struct emit_buffer* b, int start, int end)
+{
+	struct prune_entry* e = arena_alloc(sizeof(struct prune_entry));
+	e->b = b;
+	e->start = start;
+	e->end = end;
+	return e;
+}
 
-	break_target_head = "DO_END_";
-	continue_target_head = "DO_TEST_";
-	break_target_num = number_string;
-	break_frame = function->locals;
-	break_target_func = function->s;
+void prune_function(struct emit_buffer* b)
+{
+	if(NULL == function_text) function_text = new_emit_buffer();
+	if(0 != b->length)
+	{
+		struct prune_entry* e = prune_entry_new(function_text, function_text->length, 0);
+		emit(b->data, function_text);
+		e->end = function_text->length;
+		if(NULL == function_entries) function_entries = e;
+		else function_entries_tail->next = e;
+		function_entries_tail = e;
+	}
+	b->length = 0;
+	b->last = 0;
+	b->data[0] = 0;
+}
 
-	emit_out(":DO_");
-	uniqueID_out(function->s, number_string);
+int hash_slice(char* s, int length);
+struct prune_label* prune_lookup(char* s, int length)
+{
+	struct prune_label* l = prune_table[hash_slice(s, length) & (SYMBOL_TABLE_SIZE - 1)];
+	int i;
+	while(NULL != l)
+	{
+		if(length == l->length)
+		{
+			i = 0;
+			while(i < length)
+			{
+				if(s[i] != l->name[i]) break;
+				i = i + 1;
+			}
+			if(i == length) return l;
+		}
+		l = l->next;
+	}
+	return NULL;
+}
 
-	global_token = global_token->next;
-	require(NULL != global_token, "Received EOF where do statement is expected\n");
-	statement();
-	require(NULL != global_token, "Reached EOF inside of function\n");
+void prune_mark(struct prune_entry* e)
+{
+	if(e->live) return;
+	e->live = TRUE;
+	e->work = prune_work;
+	prune_work = e;
+}
 
-	emit_out(":DO_TEST_");
-	uniqueID_out(function->s, number_string);
+int prune_space(char c)
+{
+	if(' ' == c) return TRUE;
+	if('\t' == c) return TRUE;
+	if('\n' == c) return TRUE;
+	return FALSE;
+}
 
-	require_match("ERROR in process_do\nMISSING while\n", "while");
-	require_match("ERROR in process_do\nMISSING (\n", "(");
-	expression();
-	require_match("ERROR in process_do\nMISSING )\n", ")");
-	require_match("ERROR in process_do\nMISSING ;\n", ";");
+/* Index the labels defined by e, keep it if it defines none */
+void prune_labels(struct prune_entry* e)
+{
+	char* text = e->b->data;
+	int i = e->start;
+	int j;
+	int h;
+	int found = FALSE;
+	struct prune_label* l;
 
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP.NZ R0 @DO_");
-	else if(X86 == Architecture) emit_out("test_eax,eax\njne %DO_");
-	else if(AMD64 == Architecture) emit_out("test_rax,rax\njne %DO_");
-	else if(ARMV7L == Architecture) emit_out("!0 CMPI8 R0 IMM_ALWAYS\n^~DO_");
-	else if(AARCH64 == Architecture) emit_out("CBZ_X0_PAST_BR\nLOAD_W16_AHEAD\nSKIP_32_DATA\n&DO_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rs1_a0 @DO_END_");
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_NE\n");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture))
+	while(i < e->end)
 	{
-		emit_out("beqz\n$DO_");
-		uniqueID_out(function->s, number_string);
-		emit_out("jal\n");
+		if(':' == text[i])
+		{
+			j = i + 1;
+			while(j < e->end)
+			{
+				if(prune_space(text[j])) break;
+				j = j + 1;
+			}
+			l = arena_alloc(sizeof(struct prune_label));
+			l->name = text + i + 1;
+			l->length = j - i - 1;
+			l->entry = e;
+			h = hash_slice(l->name, l->length) & (SYMBOL_TABLE_SIZE - 1);
+			l->next = prune_table[h];
+			prune_table[h] = l;
+			found = TRUE;
+		}
+
+		/* On to the next line */
+		while(i < e->end)
+		{
+			if('\n' == text[i]) break;
+			i = i + 1;
+		}
+		i = i + 1;
 	}
+	if(!found) prune_mark(e);
+}
 
-	emit_out(":DO_END_");
-	uniqueID_out(function->s, number_string);
+/* Keep whatever defines the labels e refers to */
+void prune_scan(struct prune_entry* e)
+{
+	char* text = e->b->data;
+	int i = e->start;
+	int j;
+	struct prune_label* l;
 
-	break_frame = nested_locals;
-	break_target_head = nested_break_head;
-	break_target_func = nested_break_func;
-	break_target_num = nested_break_num;
-	continue_target_head = nested_continue_head;
+	while(i < e->end)
+	{
+		if(prune_space(text[i])) i = i + 1;
+		else if(('#' == text[i]) || (';' == text[i]))
+		{
+			/* Names in comments are not references */
+			while(i < e->end)
+			{
+				if('\n' == text[i]) break;
+				i = i + 1;
+			}
+		}
+		else
+		{
+			/* Skip the : of a definition and M1's reference prefixes */
+			while(in_set(text[i], ":&%$~!@^")) i = i + 1;
+			j = i;
+			while(j < e->end)
+			{
+				if(prune_space(text[j])) break;
+				j = j + 1;
+			}
+			if(j > i)
+			{
+				l = prune_lookup(text + i, j - i);
+				if(NULL != l) prune_mark(l->entry);
+			}
+			i = j;
+		}
+	}
 }
 
+void prune_root(char* head, char* name)
+{
+	char* s = arena_alloc(string_length(head) + string_length(name) + 1);
+	append_string(s, append_string(s, 0, head), name);
+	struct prune_label* l = prune_lookup(s, string_length(s));
+	if(NULL != l) prune_mark(l->entry);
+}
 
-/* Process while loops */
-void process_while(void)
+/* Split a data buffer into one entry per label */
+struct prune_entry* prune_split(struct emit_buffer* b)
 {
-	struct token_list* nested_locals = break_frame;
-	char* nested_break_head = break_target_head;
-	char* nested_break_func = break_target_func;
-	char* nested_break_num = break_target_num;
-	char* nested_continue_head = continue_target_head;
+	struct prune_entry* head = prune_entry_new(b, 0, 0);
+	struct prune_entry* e = head;
+	int i = 0;
+	while(i < b->length)
+	{
+		if(':' == b->data[i])
+		{
+			e->end = i;
+			e->next = prune_entry_new(b, i, 0);
+			e = e->next;
+		}
+		while(i < b->length)
+		{
+			if('\n' == b->data[i]) break;
+			i = i + 1;
+		}
+		i = i + 1;
+	}
+	e->end = b->length;
+	return head;
+}
 
-	char* number_string = int2str(current_count, 10, TRUE);
-	current_count = current_count + 1;
+/* Drop the dead entries of a data buffer, keeping the live ones in order */
+void prune_compact(struct emit_buffer* b, struct prune_entry* e)
+{
+	int length = 0;
+	int i;
+	while(NULL != e)
+	{
+		if(e->live)
+		{
+			for(i = e->start; i < e->end; i = i + 1)
+			{
+				b->data[length] = b->data[i];
+				length = length + 1;
+			}
+		}
+		e = e->next;
+	}
+	b->length = length;
+	b->last = length;
+	b->data[length] = 0;
+}
 
-	break_target_head = "END_WHILE_";
-	continue_target_head = "WHILE_";
-	break_target_num = number_string;
-	break_frame = function->locals;
-	break_target_func = function->s;
+/* Work out what main and the --keep names reach, write out those functions
+ * and leave only the globals and strings they use */
+void prune_program(FILE* out)
+{
+	struct prune_entry* globals = prune_split(globals_list);
+	struct prune_entry* strings = prune_split(strings_list);
+	struct prune_entry* e;
+	struct token_list* k;
+	char c;
 
-	emit_out(":WHILE_");
-	uniqueID_out(function->s, number_string);
+	prune_table = calloc(SYMBOL_TABLE_SIZE, sizeof(struct prune_label*));
+	require(NULL != prune_table, "Exhausted memory while creating the prune table\n");
+	for(e = function_entries; NULL != e; e = e->next) prune_labels(e);
+	for(e = globals; NULL != e; e = e->next) prune_labels(e);
+	for(e = strings; NULL != e; e = e->next) prune_labels(e);
 
-	global_token = global_token->next;
-	require_match("ERROR in process_while\nMISSING (\n", "(");
-	expression();
+	prune_root("FUNCTION_", "main");
+	for(k = keep_list; NULL != k; k = k->next)
+	{
+		prune_root("FUNCTION_", k->s);
+		prune_root("GLOBAL_", k->s);
+	}
 
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP.Z R0 @END_WHILE_");
-	else if(X86 == Architecture) emit_out("test_eax,eax\nje %END_WHILE_");
-	else if(AMD64 == Architecture) emit_out("test_rax,rax\nje %END_WHILE_");
-	else if(ARMV7L == Architecture) emit_out("!0 CMPI8 R0 IMM_ALWAYS\n^~END_WHILE_");
-	else if(AARCH64 == Architecture) emit_out("CBNZ_X0_PAST_BR\nLOAD_W16_AHEAD\nSKIP_32_DATA\n&END_WHILE_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("rs1_a0 @8 bnez\n$END_WHILE_");
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_EQUAL\t");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
-	emit_out("# THEN_while_");
-	uniqueID_out(function->s, number_string);
+	while(NULL != prune_work)
+	{
+		e = prune_work;
+		prune_work = e->work;
+		prune_scan(e);
+	}
 
-	require_match("ERROR in process_while\nMISSING )\n", ")");
-	statement();
-	require(NULL != global_token, "Reached EOF inside of function\n");
+	for(e = function_entries; NULL != e; e = e->next)
+	{
+		if(e->live)
+		{
+			c = function_text->data[e->end];
+			function_text->data[e->end] = 0;
+			fputs(function_text->data + e->start, out);
+			function_text->data[e->end] = c;
+		}
+	}
+	prune_compact(globals_list, globals);
+	prune_compact(strings_list, strings);
+}
 
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @WHILE_");
-	else if(X86 == Architecture) emit_out("jmp %WHILE_");
-	else if(AMD64 == Architecture) emit_out("jmp %WHILE_");
-	else if(ARMV7L == Architecture) emit_out("^~WHILE_");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&WHILE_");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$WHILE_");
-	uniqueID_out(function->s, number_string);
-	if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS\n");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("jal\n");
-	emit_out(":END_WHILE_");
-	uniqueID_out(function->s, number_string);
+/*
+ * Optional peephole pass (-O1) over the lowered text of a function.
+ * The expression code is a strict stack machine, so the common case of
+ * pushing the accumulator only to load a constant, address or variable
+ * into it before popping the old value back becomes a register move.
+ * A store to a frame slot followed by loading that slot back keeps the
+ * value in the accumulator instead.
+ */
+int peephole_prefix(char* line, char* prefix)
+{
+	int i = 0;
+	while(0 != prefix[i])
+	{
+		if(line[i] != prefix[i]) return FALSE;
+		i = i + 1;
+	}
+	return TRUE;
+}
 
-	break_target_head = nested_break_head;
-	break_target_func = nested_break_func;
-	break_target_num = nested_break_num;
-	continue_target_head = nested_continue_head;
-	break_frame = nested_locals;
+/* The instruction on line is exactly insn, ignoring any trailing comment */
+int peephole_is(char* line, char* insn)
+{
+	int i = 0;
+	while(0 != insn[i])
+	{
+		if(line[i] != insn[i]) return FALSE;
+		i = i + 1;
+	}
+	if(0 == line[i]) return TRUE;
+	return ('\t' == line[i]);
 }
 
-/* Ensure that functions return */
-void return_result(void)
+/* The instruction on line (comment excluded) ends with suffix */
+int peephole_suffix(char* line, char* suffix)
 {
-	global_token = global_token->next;
-	require(NULL != global_token, "Incomplete return statement received\n");
-	if(global_token->s[0] != ';') expression();
+	int i = 0;
+	while((0 != line[i]) && ('\t' != line[i])) i = i + 1;
+	int j = 0;
+	while(0 != suffix[j]) j = j + 1;
+	if(j > i) return FALSE;
+	return peephole_is(line + i - j, suffix);
+}
 
-	require_match("ERROR in return_result\nMISSING ;\n", ";");
+/* Scratch register saved to by the last push peephole_push found, 0 for the stack */
+int peephole_scratch;
 
-	struct token_list* i;
-	unsigned size_local_var;
-	for(i = function->locals; NULL != i; i = i->next)
+/* Lines taken by a push of the accumulator at lines[i], 0 if there is none */
+int peephole_push(char** lines, int i, int n)
+{
+	char* l = lines[i];
+	int k;
+	peephole_scratch = 0;
+	for(k = scratch_count(); 0 < k; k = k - 1)
 	{
-		size_local_var = ceil_div(i->type->size, register_size);
-		while(size_local_var != 0)
+		if(peephole_is(l, scratch_save[k - 1]))
 		{
-			if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("POPR R1 R15\t# _return_result_locals\n");
-			else if(X86 == Architecture) emit_out("pop_ebx\t# _return_result_locals\n");
-			else if(AMD64 == Architecture) emit_out("pop_rbx\t# _return_result_locals\n");
-			else if(ARMV7L == Architecture) emit_out("{R1} POP_ALWAYS\t# _return_result_locals\n");
-			else if(AARCH64 == Architecture) emit_out("POP_X1\t# _return_result_locals\n");
-			else if(RISCV32 == Architecture) emit_out("rd_a1 rs1_sp lw	# _return_result_locals\nrd_sp rs1_sp !4 addi\n");
-			else if(RISCV64 == Architecture) emit_out("rd_a1 rs1_sp ld	# _return_result_locals\nrd_sp rs1_sp !8 addi\n");
-			size_local_var = size_local_var - 1;
+			peephole_scratch = k;
+			return 1;
 		}
 	}
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("RET R15\n");
-	else if(X86 == Architecture) emit_out("ret\n");
-	else if(AMD64 == Architecture) emit_out("ret\n");
-	else if(ARMV7L == Architecture) emit_out("'1' LR RETURN\n");
-	else if(AARCH64 == Architecture) emit_out("RETURN\n");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("ret\n");
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return peephole_is(l, "PUSHR R0 R15");
+	else if(X86 == Architecture) return peephole_is(l, "push_eax");
+	else if(AMD64 == Architecture) return peephole_is(l, "push_rax");
+	else if(ARMV7L == Architecture) return peephole_is(l, "{R0} PUSH_ALWAYS");
+	else if(AARCH64 == Architecture) return peephole_is(l, "PUSH_X0");
+	if((i + 1) == n) return 0;
+	if((RISCV32 == Architecture) && peephole_is(l, "rd_sp rs1_sp !-4 addi") && peephole_is(lines[i + 1], "rs1_sp rs2_a0 sw")) return 2;
+	if((RISCV64 == Architecture) && peephole_is(l, "rd_sp rs1_sp !-8 addi") && peephole_is(lines[i + 1], "rs1_sp rs2_a0 sd")) return 2;
+	return 0;
 }
 
-void process_break(void)
+/* Lines taken by a pop into the secondary register at lines[i], 0 if there is none */
+int peephole_pop(char** lines, int i, int n)
 {
-	if(NULL == break_target_head)
-	{
-		line_error();
-		fputs("Not inside of a loop or case statement\n", stderr);
-		exit(EXIT_FAILURE);
-	}
-	struct token_list* i = function->locals;
-	while(i != break_frame)
-	{
-		if(NULL == i) break;
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("POPR R1 R15\t# break_cleanup_locals\n");
-		else if(X86 == Architecture) emit_out("pop_ebx\t# break_cleanup_locals\n");
-		else if(AMD64 == Architecture) emit_out("pop_rbx\t# break_cleanup_locals\n");
-		else if(ARMV7L == Architecture) emit_out("{R1} POP_ALWAYS\t# break_cleanup_locals\n");
-		else if(AARCH64 == Architecture) emit_out("POP_X1\t# break_cleanup_locals\n");
-		else if(RISCV32 == Architecture) emit_out("rd_a1 rs1_sp lw\t# break_cleanup_locals\nrd_sp rs1_sp !4 addi\n");
-		else if(RISCV64 == Architecture) emit_out("rd_a1 rs1_sp ld\t# break_cleanup_locals\nrd_sp rs1_sp !8 addi\n");
-		i = i->next;
-	}
-	global_token = global_token->next;
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @");
-	else if(X86 == Architecture) emit_out("jmp %");
-	else if(AMD64 == Architecture) emit_out("jmp %");
-	else if(ARMV7L == Architecture) emit_out("^~");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$");
+	char* l = lines[i];
+	if(0 != peephole_scratch) return peephole_is(l, scratch_restore[peephole_scratch - 1]);
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return peephole_is(l, "POPR R1 R15");
+	else if(X86 == Architecture) return peephole_is(l, "pop_ebx");
+	else if(AMD64 == Architecture) return peephole_is(l, "pop_rbx");
+	else if(ARMV7L == Architecture) return peephole_is(l, "{R1} POP_ALWAYS");
+	else if(AARCH64 == Architecture) return peephole_is(l, "POP_X1");
+	if((i + 1) == n) return 0;
+	if((RISCV32 == Architecture) && peephole_is(l, "rd_a1 rs1_sp lw") && peephole_is(lines[i + 1], "rd_sp rs1_sp !4 addi")) return 2;
+	if((RISCV64 == Architecture) && peephole_is(l, "rd_a1 rs1_sp ld") && peephole_is(lines[i + 1], "rd_sp rs1_sp !8 addi")) return 2;
+	return 0;
+}
 
-	emit_out(break_target_head);
-	emit_out(break_target_func);
-	emit_out("_");
-	emit_out(break_target_num);
-	if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" jal");
-	emit_out("\n");
-	require_match("ERROR in break statement\nMissing ;\n", ";");
+/* Copy the accumulator into the secondary register, its old value may be lost */
+char* peephole_move(void)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return "MOVE R1 R0";
+	else if(X86 == Architecture) return "mov_ebx,eax";
+	else if(AMD64 == Architecture) return "xchg_rbx,rax";
+	else if(ARMV7L == Architecture) return "'0' R0 R1 NO_SHIFT MOVE_ALWAYS";
+	else if(AARCH64 == Architecture) return "SET_X1_FROM_X0";
+	return "rd_a1 rs1_a0 mv";
 }
 
-void process_continue(void)
+/* Overwrites the accumulator without reading any register but the frame pointer */
+int peephole_loads_accumulator(char* l)
 {
-	if(NULL == continue_target_head)
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 	{
-		line_error();
-		fputs("Not inside of a loop\n", stderr);
-		exit(EXIT_FAILURE);
+		if(peephole_prefix(l, "LOADI R0 ")) return TRUE;
+		if(peephole_is(l, "LOADR R0 4")) return TRUE;
+		return peephole_prefix(l, "ADDI R0 R14 ");
 	}
-	global_token = global_token->next;
-
-	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @");
-	else if(X86 == Architecture) emit_out("jmp %");
-	else if(AMD64 == Architecture) emit_out("jmp %");
-	else if(ARMV7L == Architecture) emit_out("^~");
-	else if(AARCH64 == Architecture) emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$");
+	else if(X86 == Architecture)
+	{
+		if(peephole_prefix(l, "mov_eax, %")) return TRUE;
+		if(peephole_prefix(l, "mov_eax, &")) return TRUE;
+		return peephole_prefix(l, "lea_eax,[ebp+DWORD] %");
+	}
+	else if(AMD64 == Architecture)
+	{
+		if(peephole_prefix(l, "mov_rax, %")) return TRUE;
+		if(peephole_prefix(l, "lea_rax,[rip+DWORD] %")) return TRUE;
+		return peephole_prefix(l, "lea_rax,[rbp+DWORD] %");
+	}
+	else if(ARMV7L == Architecture)
+	{
+		if(peephole_is(l, "!0 R0 LOAD32 R15 MEMORY")) return TRUE;
+		if(!peephole_prefix(l, "!")) return FALSE;
+		if(peephole_suffix(l, " R0 LOADI8_ALWAYS")) return TRUE;
+		return peephole_suffix(l, " R0 SUB BP ARITH_ALWAYS");
+	}
+	else if(AARCH64 == Architecture) return peephole_is(l, "LOAD_W0_AHEAD");
 
-	emit_out(continue_target_head);
-	emit_out(break_target_func);
-	emit_out("_");
-	emit_out(break_target_num);
-	if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS");
-	else if(AARCH64 == Architecture) emit_out("\nBR_X16");
-	else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" jal");
-	emit_out("\n");
-	require_match("ERROR in continue statement\nMissing ;\n", ";");
+	if(peephole_prefix(l, "rd_a0 !")) return TRUE;
+	if(peephole_prefix(l, "rd_a0 ~")) return TRUE;
+	return peephole_prefix(l, "rd_a0 rs1_fp !");
 }
 
-void recursive_statement(void)
+/* Only touches the accumulator, or is inline data or a comment */
+int peephole_keeps_accumulator(char* l)
 {
-	global_token = global_token->next;
-	require(NULL != global_token, "Received EOF in recursive statement\n");
-	struct token_list* frame = function->locals;
-
-	while(!match("}", global_token->s))
+	if('#' == l[0]) return TRUE;
+	if(peephole_loads_accumulator(l)) return TRUE;
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture))
 	{
-		statement();
-		require(NULL != global_token, "Received EOF in recursive statement prior to }\n");
+		if(in_set(l[0], "%&'")) return TRUE;
+		if(peephole_is(l, "JUMP 4")) return TRUE;
+		if(peephole_prefix(l, "LOAD R0 R0 ")) return TRUE;
+		if(peephole_prefix(l, "LOAD8 R0 R0 ")) return TRUE;
+		if(peephole_prefix(l, "LOADU8 R0 R0 ")) return TRUE;
+		if(peephole_prefix(l, "LOAD16 R0 R0 ")) return TRUE;
+		return peephole_prefix(l, "LOADU16 R0 R0 ");
+	}
+	else if(X86 == Architecture)
+	{
+		if(peephole_is(l, "mov_eax,[eax]")) return TRUE;
+		if(peephole_prefix(l, "movsx_eax,")) return TRUE;
+		return peephole_prefix(l, "movzx_eax,");
+	}
+	else if(AMD64 == Architecture)
+	{
+		if(peephole_is(l, "mov_rax,[rax]")) return TRUE;
+		if(peephole_is(l, "mov_eax,[rax]")) return TRUE;
+		if(peephole_prefix(l, "movsx_rax,")) return TRUE;
+		return peephole_prefix(l, "movzx_rax,");
+	}
+	else if(ARMV7L == Architecture)
+	{
+		if(in_set(l[0], "%&")) return TRUE;
+		if(peephole_is(l, "~0 JUMP_ALWAYS")) return TRUE;
+		if(peephole_is(l, "!0 R0 LOAD32 R0 MEMORY")) return TRUE;
+		if(peephole_is(l, "!0 R0 LOAD R0 MEMORY")) return TRUE;
+		return peephole_suffix(l, " R0 LOAD R0 HALF_MEMORY");
+	}
+	else if(AARCH64 == Architecture)
+	{
+		if(in_set(l[0], "%&")) return TRUE;
+		if(peephole_is(l, "SKIP_32_DATA")) return TRUE;
+		return peephole_prefix(l, "DEREF_X0");
 	}
-	global_token = global_token->next;
 
-	/* Clean up any locals added */
+	/* Split string address loads leave the opcode on a line of its own */
+	if(peephole_is(l, "auipc")) return TRUE;
+	if(peephole_is(l, "addi")) return TRUE;
+	if(peephole_prefix(l, "rd_a0 rs1_a0 !")) return TRUE;
+	return peephole_prefix(l, "rd_a0 rs1_a0 l");
+}
 
-	if(((X86 == Architecture) && !match("ret\n", output_list->s)) ||
-	   ((AMD64 == Architecture) && !match("ret\n", output_list->s)) ||
-	   (((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) && !match("RET R15\n", output_list->s)) ||
-	   ((ARMV7L == Architecture) && !match("'1' LR RETURN\n", output_list->s)) ||
-	   ((AARCH64 == Architecture) && !match("RETURN\n", output_list->s)) ||
-	   (((RISCV32 == Architecture) || (RISCV64 == Architecture)) && !match("ret\n", output_list->s)))
+/* The instructions on a and b match, ignoring any trailing comments */
+int peephole_same(char* a, char* b)
+{
+	int i = 0;
+	while((0 != a[i]) && ('\t' != a[i]))
 	{
-		struct token_list* i;
-		for(i = function->locals; frame != i; i = i->next)
-		{
-			if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("POPR R1 R15\t# _recursive_statement_locals\n");
-			else if(X86 == Architecture) emit_out( "pop_ebx\t# _recursive_statement_locals\n");
-			else if(AMD64 == Architecture) emit_out("pop_rbx\t# _recursive_statement_locals\n");
-			else if(ARMV7L == Architecture) emit_out("{R1} POP_ALWAYS\t# _recursive_statement_locals\n");
-			else if(AARCH64 == Architecture) emit_out("POP_X1\t# _recursive_statement_locals\n");
-			else if(RISCV32 == Architecture) emit_out("rd_a1 rs1_sp lw\t# _recursive_statement_locals\nrd_sp rs1_sp !4 addi\n");
-			else if(RISCV64 == Architecture) emit_out("rd_a1 rs1_sp ld\t# _recursive_statement_locals\nrd_sp rs1_sp !8 addi\n");
-		}
+		if(a[i] != b[i]) return FALSE;
+		i = i + 1;
 	}
-	function->locals = frame;
+	if(0 == b[i]) return TRUE;
+	return ('\t' == b[i]);
 }
 
-/*
- * statement:
- *     { statement-list-opt }
- *     type-name identifier ;
- *     type-name identifier = expression;
- *     if ( expression ) statement
- *     if ( expression ) statement else statement
- *     do statement while ( expression ) ;
- *     while ( expression ) statement
- *     for ( expression ; expression ; expression ) statement
- *     asm ( "assembly" ... "assembly" ) ;
- *     goto label ;
- *     label:
- *     return ;
- *     break ;
- *     expr ;
- */
-
-struct type* lookup_type(char* s, struct type* start);
-void statement(void)
+/* The instruction on line (comment excluded) contains s */
+int peephole_mentions(char* line, char* s)
 {
-	require(NULL != global_token, "expected a C statement but received EOF\n");
-	/* Always an integer until told otherwise */
-	current_target = integer;
-
-	if(global_token->s[0] == '{')
+	int i = 0;
+	while((0 != line[i]) && ('\t' != line[i]))
 	{
-		recursive_statement();
+		if(peephole_prefix(line + i, s)) return TRUE;
+		i = i + 1;
 	}
-	else if(':' == global_token->s[0])
+	return FALSE;
+}
+
+/* Lines taken by putting the address of a frame slot in the accumulator at lines[i], 0 if there are none */
+int peephole_frame_address(char** lines, int i, int n)
+{
+	char* l = lines[i];
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return peephole_prefix(l, "ADDI R0 R14 ");
+	else if(X86 == Architecture) return peephole_prefix(l, "lea_eax,[ebp+DWORD] %");
+	else if(AMD64 == Architecture) return peephole_prefix(l, "lea_rax,[rbp+DWORD] %");
+	else if(ARMV7L == Architecture)
 	{
-		emit_out(global_token->s);
-		emit_out("\t#C goto label\n");
-		global_token = global_token->next;
+		if(!peephole_prefix(l, "!")) return 0;
+		return peephole_suffix(l, " R0 SUB BP ARITH_ALWAYS");
 	}
-	else if((NULL != lookup_type(global_token->s, prim_types)) ||
-	          match("struct", global_token->s))
+	else if(AARCH64 == Architecture)
 	{
-		collect_local();
-	}
-	else if(match("if", global_token->s))
+		if((i + 5) > n) return 0;
+		if(!peephole_is(l, "SET_X0_FROM_BP")) return 0;
+		if(!peephole_is(lines[i + 1], "LOAD_W1_AHEAD")) return 0;
+		if(!peephole_is(lines[i + 2], "SKIP_32_DATA")) return 0;
+		if(!peephole_is(lines[i + 4], "SUB_X0_X0_X1")) return 0;
+		/* The offset is followed by an empty line */
+		if((i + 5) == n) return 5;
+		if(0 == lines[i + 5][0]) return 6;
+		return 5;
+	}
+	return peephole_prefix(l, "rd_a0 rs1_fp !");
+}
+
+/* Stores the whole accumulator through the secondary register */
+int peephole_store_word(char* l)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return peephole_is(l, "STORE R0 R1 0");
+	else if(X86 == Architecture) return peephole_is(l, "mov_[ebx],eax");
+	else if(AMD64 == Architecture) return peephole_is(l, "mov_[rbx],rax");
+	else if(ARMV7L == Architecture) return peephole_is(l, "!0 R0 STORE32 R1 MEMORY");
+	else if(AARCH64 == Architecture) return peephole_is(l, "STR_X0_[X1]");
+	else if(RISCV32 == Architecture) return peephole_is(l, "rs1_a1 rs2_a0 sw");
+	return peephole_is(l, "rs1_a1 rs2_a0 sd");
+}
+
+/* Replaces the address in the accumulator with the whole word it points at */
+int peephole_load_word(char* l)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return peephole_is(l, "LOAD R0 R0 0");
+	else if(X86 == Architecture) return peephole_is(l, "mov_eax,[eax]");
+	else if(AMD64 == Architecture) return peephole_is(l, "mov_rax,[rax]");
+	else if(ARMV7L == Architecture) return peephole_is(l, "!0 R0 LOAD32 R0 MEMORY");
+	else if(AARCH64 == Architecture) return peephole_is(l, "DEREF_X0");
+	else if(RISCV32 == Architecture) return peephole_is(l, "rd_a0 rs1_a0 lw");
+	return peephole_is(l, "rd_a0 rs1_a0 ld");
+}
+
+/* Might move the stack pointer in some way the push and pop rules don't know */
+int peephole_touches_stack(char* l)
+{
+	if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) return peephole_mentions(l, "R15");
+	else if((X86 == Architecture) || (AMD64 == Architecture))
 	{
-		process_if();
+		/* Named pushes and pops of the argument registers included */
+		if(peephole_mentions(l, "push")) return TRUE;
+		if(peephole_mentions(l, "pop")) return TRUE;
+		return peephole_mentions(l, "sp");
 	}
-	else if(match("switch", global_token->s))
+	else if(ARMV7L == Architecture)
 	{
-		process_switch();
+		if(peephole_mentions(l, "PUSH")) return TRUE;
+		if(peephole_mentions(l, "POP")) return TRUE;
+		return peephole_mentions(l, "SP");
 	}
-	else if(match("do", global_token->s))
+	else if(AARCH64 == Architecture)
 	{
-		process_do();
+		if(peephole_mentions(l, "PUSH")) return TRUE;
+		if(peephole_mentions(l, "POP")) return TRUE;
+		if(peephole_mentions(l, "SP")) return TRUE;
+		return peephole_mentions(l, "X18");
 	}
-	else if(match("while", global_token->s))
+	return peephole_mentions(l, "sp");
+}
+
+/* Lines taken by a push of the accumulator onto the stack at lines[i] */
+int peephole_stack_push(char** lines, int i, int n)
+{
+	int p = peephole_push(lines, i, n);
+	if(0 != peephole_scratch) return 0;
+	return p;
+}
+
+/* Lines taken by a pop off the stack into the secondary register at lines[i] */
+int peephole_stack_pop(char** lines, int i, int n)
+{
+	peephole_scratch = 0;
+	return peephole_pop(lines, i, n);
+}
+
+/* Index of the push that the pop at lines[i] takes back off the stack, -1 if it can't be told */
+int peephole_pushed_at(char** lines, int i, int n)
+{
+	int depth = 1;
+	while(0 < i)
 	{
-		process_while();
+		i = i - 1;
+		/* Two line pushes and pops are recognised by their first line */
+		if(0 < i)
+		{
+			if(2 == peephole_stack_push(lines, i - 1, n))
+			{
+				i = i - 1;
+				depth = depth - 1;
+				if(0 == depth) return i;
+				continue;
+			}
+			if(2 == peephole_stack_pop(lines, i - 1, n))
+			{
+				i = i - 1;
+				depth = depth + 1;
+				continue;
+			}
+		}
+		if(1 == peephole_stack_push(lines, i, n))
+		{
+			depth = depth - 1;
+			if(0 == depth) return i;
+		}
+		else if(1 == peephole_stack_pop(lines, i, n)) depth = depth + 1;
+		else if(peephole_touches_stack(lines[i])) return -1;
 	}
-	else if(match("for", global_token->s))
+	return -1;
+}
+
+/* Index of the line that copied the accumulator out to become the address
+ * the store at lines[i] writes through, -1 if it can't be told */
+int peephole_store_source(char** lines, int i, int n)
+{
+	int j = i - 1;
+	int k;
+	if(0 > j) return -1;
+
+	/* Kept in a scratch register, whose last save is the one restored */
+	for(k = scratch_count(); 0 < k; k = k - 1)
 	{
-		process_for();
+		if(peephole_is(lines[j], scratch_restore[k - 1]))
+		{
+			while(0 < j)
+			{
+				j = j - 1;
+				if(peephole_is(lines[j], scratch_save[k - 1])) return j;
+			}
+			return -1;
+		}
 	}
-	else if(match("asm", global_token->s))
+
+	/* Pushed and popped back */
+	if(0 < j)
 	{
-		process_asm();
+		if(2 == peephole_stack_pop(lines, j - 1, n)) return peephole_pushed_at(lines, j - 1, n);
 	}
-	else if(match("goto", global_token->s))
+	if(1 == peephole_stack_pop(lines, j, n)) return peephole_pushed_at(lines, j, n);
+
+	/* Moved across by the push/pop rule */
+	while(0 <= j)
 	{
-		global_token = global_token->next;
-		require(NULL != global_token, "naked goto is not supported\n");
-		if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) emit_out("JUMP @");
-		else if(X86 == Architecture) emit_out("jmp %");
-		else if(AMD64 == Architecture) emit_out("jmp %");
-		else if(ARMV7L == Architecture) emit_out("^~");
-		else if(AARCH64 == Architecture) emit_out("LOAD_W16_AHEAD\nSKIP_32_DATA\n&");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out("$");
-		emit_out(global_token->s);
-		if(ARMV7L == Architecture) emit_out(" JUMP_ALWAYS");
-		else if(AARCH64 == Architecture) emit_out("\nBR_X16");
-		else if((RISCV32 == Architecture) || (RISCV64 == Architecture)) emit_out(" jal");
-		emit_out("\n");
-		global_token = global_token->next;
-		require_match("ERROR in statement\nMissing ;\n", ";");
+		if(peephole_is(lines[j], peephole_move())) return j;
+		if(!peephole_keeps_accumulator(lines[j])) return -1;
+		j = j - 1;
 	}
-	else if(match("return", global_token->s))
+	return -1;
+}
+
+/* The a lines of the frame address at lines[address] also end just before lines[i] */
+int peephole_address_before(char** lines, int i, int address, int a, int n)
+{
+	int k;
+	if(0 > (i - a)) return FALSE;
+	if(a != peephole_frame_address(lines, i - a, n)) return FALSE;
+	for(k = 0; k < a; k = k + 1)
 	{
-		return_result();
+		if(!peephole_same(lines[i - a + k], lines[address + k])) return FALSE;
 	}
-	else if(match("break", global_token->s))
-	{
-		process_break();
+	return TRUE;
+}
+
+/* Copy in to out dropping loads of a frame slot right after the whole
+ * accumulator was stored to it, returns the number of lines kept */
+int peephole_forward(char** in, int n, char** out)
+{
+	int m = 0;
+	int i = 0;
+	int j;
+	int a;
+	int source;
+	while(i < n)
+	{
+		out[m] = in[i];
+		m = m + 1;
+		a = 0;
+		j = i + 1;
+		if(peephole_store_word(in[i]))
+		{
+			/* Comments don't change anything, labels would */
+			while(j < n)
+			{
+				if('#' != in[j][0]) break;
+				j = j + 1;
+			}
+			if(j < n) a = peephole_frame_address(in, j, n);
+			if(0 != a)
+			{
+				if((j + a) >= n) a = 0;
+				else if(!peephole_load_word(in[j + a])) a = 0;
+			}
+			if(0 != a)
+			{
+				source = peephole_store_source(in, i, n);
+				if(0 > source) a = 0;
+				else if(!peephole_address_before(in, source, j, a, n)) a = 0;
+			}
+		}
+		i = i + 1;
+		if(0 != a)
+		{
+			/* The accumulator still holds what was stored, skip the reload */
+			while(i < j)
+			{
+				out[m] = in[i];
+				m = m + 1;
+				i = i + 1;
+			}
+			i = j + a + 1;
+		}
 	}
-	else if(match("continue", global_token->s))
+	return m;
+}
+
+/* Argument register the last pop peephole_argument_pop found goes into */
+int peephole_argument;
+
+/* Lines taken by a pop into an argument register at lines[i], 0 if there is none */
+int peephole_argument_pop(char** lines, int i, int n)
+{
+	int k;
+	for(k = argument_count() - 1; 0 <= k; k = k - 1)
 	{
-		process_continue();
+		if(peephole_is(lines[i], argument_pop[k]))
+		{
+			peephole_argument = k;
+			if((RISCV32 != Architecture) && (RISCV64 != Architecture)) return 1;
+			if((i + 1) == n) return 0;
+			if((RISCV32 == Architecture) && peephole_is(lines[i + 1], "rd_sp rs1_sp !4 addi")) return 2;
+			if((RISCV64 == Architecture) && peephole_is(lines[i + 1], "rd_sp rs1_sp !8 addi")) return 2;
+			return 0;
+		}
 	}
-	else
+	return 0;
+}
+
+/* Copies the accumulator into an argument register */
+int peephole_argument_move(char* l)
+{
+	int k;
+	for(k = argument_count() - 1; 0 <= k; k = k - 1)
 	{
-		expression();
-		require_match("ERROR in statement\nMISSING ;\n", ";");
+		if(peephole_is(l, argument_move[k])) return TRUE;
 	}
+	return FALSE;
 }
 
-/* Collect function arguments */
-void collect_arguments(void)
+/* Copy in to out turning the push of an argument that is popped into its
+ * register with only loads of later arguments in between into a move,
+ * returns the number of lines kept */
+int peephole_arguments(char** in, int n, char** out)
 {
-	global_token = global_token->next;
-	require(NULL != global_token, "Received EOF when attempting to collect arguments\n");
-	struct type* type_size;
-	struct token_list* a;
+	int m = 0;
+	int i = 0;
+	int j;
+	int p;
+	int q;
+	while(i < n)
+	{
+		p = peephole_stack_push(in, i, n);
+		j = i + p;
+		q = 0;
+		if(0 != p)
+		{
+			while(j < n)
+			{
+				if(!peephole_keeps_accumulator(in[j]) && !peephole_argument_move(in[j])) break;
+				j = j + 1;
+			}
+			if(j < n) q = peephole_argument_pop(in, j, n);
+		}
 
-	while(!match(")", global_token->s))
-	{
-		type_size = type_name();
-		require(NULL != global_token, "Received EOF when attempting to collect arguments\n");
-		require(NULL != type_size, "Must have non-null type\n");
-		if(global_token->s[0] == ')')
+		/* On aarch64 and riscv the accumulator is the first argument register,
+		 * so that push can only go when nothing comes between it and its pop */
+		if((0 != q) && (0 == peephole_argument) && (AMD64 != Architecture))
 		{
-			/* foo(int,char,void) doesn't need anything done */
+			if(j != (i + p)) q = 0;
+			else
+			{
+				i = j + q;
+				continue;
+			}
+		}
+
+		if(0 != q)
+		{
+			out[m] = argument_move[peephole_argument];
+			m = m + 1;
+			i = i + p;
+			while(i < j)
+			{
+				out[m] = in[i];
+				m = m + 1;
+				i = i + 1;
+			}
+			i = j + q;
 			continue;
 		}
-		else if(global_token->s[0] != ',')
+
+		out[m] = in[i];
+		m = m + 1;
+		i = i + 1;
+	}
+	return m;
+}
+
+void peephole(struct emit_buffer* b)
+{
+	/* Split a copy of the function into lines */
+	char* text = calloc(b->length + 1, sizeof(char));
+	require(NULL != text, "Exhausted memory while optimizing\n");
+	copy_string(text, b->data, b->length);
+	int n = 1;
+	int i = 0;
+	while(i < b->length)
+	{
+		if('\n' == text[i]) n = n + 1;
+		i = i + 1;
+	}
+	char** lines = calloc(n, sizeof(char*));
+	char** out = calloc(n, sizeof(char*));
+	require((NULL != lines) && (NULL != out), "Exhausted memory while optimizing\n");
+	lines[0] = text;
+	n = 1;
+	i = 0;
+	while(i < b->length)
+	{
+		if('\n' == text[i])
 		{
-			/* deal with foo(int a, char b) */
-			require(!in_set(global_token->s[0], "[{(<=>)}]|&!^%;:'\""), "forbidden character in argument variable name\n");
-			require(!iskeywordp(global_token->s), "You are not allowed to use a keyword as a argument variable name\n");
-			a = sym_declare(global_token->s, type_size, function->arguments);
-			if(NULL == function->arguments)
+			text[i] = 0;
+			lines[n] = text + i + 1;
+			n = n + 1;
+		}
+		i = i + 1;
+	}
+
+	int m = 0;
+	int j;
+	int p;
+	int q;
+	i = 0;
+	while(i < n)
+	{
+		/* push; load into the accumulator; pop => move; load */
+		p = peephole_push(lines, i, n);
+		j = i + p;
+		q = 0;
+		if((0 != p) && (j < n))
+		{
+			if(peephole_loads_accumulator(lines[j]))
 			{
-				if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) a->depth = 0;
-				else if(X86 == Architecture) a->depth = -4;
-				else if(AMD64 == Architecture) a->depth = -8;
-				else if(ARMV7L == Architecture) a->depth = 4;
-				else if(AARCH64 == Architecture) a->depth = register_size;
-				else if(RISCV32 == Architecture) a->depth = -4;
-				else if(RISCV64 == Architecture) a->depth = -8;
+				j = j + 1;
+				while(j < n)
+				{
+					if(!peephole_keeps_accumulator(lines[j])) break;
+					j = j + 1;
+				}
+				if(j < n) q = peephole_pop(lines, j, n);
 			}
-			else
+		}
+		if(0 != q)
+		{
+			out[m] = peephole_move();
+			m = m + 1;
+			i = i + p;
+			while(i < j)
 			{
-				if((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) a->depth = function->arguments->depth + register_size;
-				else if(X86 == Architecture) a->depth = function->arguments->depth - register_size;
-				else if(AMD64 == Architecture) a->depth = function->arguments->depth - register_size;
-				else if(ARMV7L == Architecture) a->depth = function->arguments->depth + register_size;
-				else if(AARCH64 == Architecture) a->depth = function->arguments->depth + register_size;
-				else if(RISCV32 == Architecture) a->depth = function->arguments->depth - register_size;
-				else if(RISCV64 == Architecture) a->depth = function->arguments->depth - register_size;
+				out[m] = lines[i];
+				m = m + 1;
+				i = i + 1;
 			}
-
-			global_token = global_token->next;
-			require(NULL != global_token, "Incomplete argument list\n");
-			function->arguments = a;
+			i = j + q;
+			continue;
 		}
 
-		/* ignore trailing comma (needed for foo(bar(), 1); expressions*/
-		if(global_token->s[0] == ',')
+		out[m] = lines[i];
+		m = m + 1;
+		i = i + 1;
+	}
+
+	/* Arguments moved straight into their registers, innermost first */
+	if((0 != argument_count()) && (NULL != argument_pop))
+	{
+		j = 0;
+		while(j != m)
 		{
-			global_token = global_token->next;
-			require(NULL != global_token, "naked comma in collect arguments\n");
+			j = m;
+			m = peephole_arguments(out, m, lines);
+			for(i = 0; i < m; i = i + 1) out[i] = lines[i];
 		}
+	}
 
-		require(NULL != global_token, "Argument list never completed\n");
+	/* Then forward stores into the loads that follow them */
+	m = peephole_forward(out, m, lines);
+
+	b->length = 0;
+	b->data[0] = 0;
+	i = 0;
+	while(i < m)
+	{
+		emit(lines[i], b);
+		if((i + 1) < m) emit("\n", b);
+		i = i + 1;
 	}
-	global_token = global_token->next;
+	free(text);
+	free(lines);
+	free(out);
+}
+
+/* Remember the expression of a body that is only { return expression; }
+ * when it is at most INLINE_LIMIT tokens long or inline was asked for */
+void inline_candidate(int forced)
+{
+	struct token_list* i = global_token;
+	struct token_list* start;
+	int count = 0;
+
+	if(!match("{", i->s)) return;
+	i = i->next;
+	if(NULL == i) return;
+	if(!match("return", i->s)) return;
+	start = i->next;
+
+	for(i = start; NULL != i; i = i->next)
+	{
+		if(match(";", i->s)) break;
+		count = count + 1;
+	}
+	if(NULL == i) return;
+	if(0 == count) return;
+	if(NULL == i->next) return;
+	if(!match("}", i->next->s)) return;
+	if(!forced)
+	{
+		if(count > INLINE_LIMIT) return;
+	}
+
+	/* Functions have no previous token; prev holds the expression */
+	function->prev = start;
+	function->depth = function->depth | FUNCTION_INLINE;
 }
 
 void declare_function(void)
 {
+	int count;
+	int registers;
+	int placed;
 	current_count = 0;
+
+	/* Forget the arguments and locals of the previous function */
+	if(NULL != function)
+	{
+		sym_unindex_list(scope_table, function->locals, NULL);
+		sym_unindex_list(scope_table, function->arguments, NULL);
+	}
+	/* A prototype repeated after the body still has its label behind it */
+	placed = function_emitted(global_token->prev->s);
 	function = sym_declare(global_token->prev->s, NULL, global_function_list);
+	function->depth = placed;
 
 	/* allow previously defined functions to be looked up */
 	global_function_list = function;
+	sym_index(global_function_table, function);
 	if((KNIGHT_NATIVE == Architecture) && match("main", function->s))
 	{
 		require_match("Impossible error ( vanished\n", "(");
@@ -2860,19 +5728,37 @@ void declare_function(void)
 		emit_out("# Defining function ");
 		emit_out(function->s);
 		emit_out("\n");
+		register_calls = FALSE;
+		count = list_length(function->arguments);
+		registers = FALSE;
+		if((0 < count) && (count <= argument_count())) registers = !match("main", function->s);
+		if(registers) register_entry(count);
 		emit_out(":FUNCTION_");
 		emit_out(function->s);
 		emit_out("\n");
+		/* Functions have no stack depth; it holds their FUNCTION_ flags */
+		function->depth = FUNCTION_PLACED;
+		if(registers) function->depth = function->depth | FUNCTION_REGISTERS;
+		inline_candidate(inline_keyword);
 		statement();
+		/* Arguments are read through the base pointer, so only functions without any can skip it;
+		 * calls to an empty frame don't save rdi, so neither can functions making register calls */
+		if(NULL == function->arguments)
+		{
+			if((0 == (function->depth & FUNCTION_HAS_LOCALS)) && !register_calls) function->depth = function->depth | FUNCTION_EMPTY_FRAME;
+		}
 
 		/* Prevent duplicate RETURNS */
-		if(((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) && !match("RET R15\n", output_list->s)) emit_out("RET R15\n");
-		else if((X86 == Architecture) && !match("ret\n", output_list->s)) emit_out("ret\n");
-		else if((AMD64 == Architecture) && !match("ret\n", output_list->s)) emit_out("ret\n");
-		else if((ARMV7L == Architecture) && !match("'1' LR RETURN\n", output_list->s)) emit_out("'1' LR RETURN\n");
-		else if((AARCH64 == Architecture) && !match("RETURN\n", output_list->s)) emit_out("RETURN\n");
-		else if((RISCV32 == Architecture) && !match("ret\n", output_list->s)) emit_out("ret\n");
-		else if((RISCV64 == Architecture) && !match("ret\n", output_list->s)) emit_out("ret\n");
+		if(((KNIGHT_POSIX == Architecture) || (KNIGHT_NATIVE == Architecture)) && !last_emitted(output_list, "RET R15\n")) emit_out("RET R15\n");
+		else if((X86 == Architecture) && !last_emitted(output_list, "ret\n")) emit_out("ret\n");
+		else if((AMD64 == Architecture) && !last_emitted(output_list, "ret\n")) emit_out("ret\n");
+		else if((ARMV7L == Architecture) && !last_emitted(output_list, "'1' LR RETURN\n")) emit_out("'1' LR RETURN\n");
+		else if((AARCH64 == Architecture) && !last_emitted(output_list, "RETURN\n")) emit_out("RETURN\n");
+		else if((RISCV32 == Architecture) && !last_emitted(output_list, "ret\n")) emit_out("ret\n");
+		else if((RISCV64 == Architecture) && !last_emitted(output_list, "ret\n")) emit_out("ret\n");
+
+		/* Only the function being compiled is kept in memory */
+		write_function(function_stream);
 	}
 }
 
@@ -2881,6 +5767,7 @@ void global_constant(void)
 	global_token = global_token->next;
 	require(NULL != global_token, "CONSTANT lacks a name\n");
 	global_constant_list = sym_declare(global_token->s, NULL, global_constant_list);
+	sym_index(global_constant_table, global_constant_list);
 
 	require(NULL != global_token->next, "CONSTANT lacks a value\n");
 	if(match("sizeof", global_token->next->s))
@@ -2890,6 +5777,7 @@ void global_constant(void)
 		struct type* a = type_name();
 		require_match("ERROR in CONSTANT with sizeof\nMissing )\n", ")");
 		global_token->prev->s = int2str(a->size, 10, TRUE);
+		global_token->prev->kind = TOKEN_NUMBER;
 		global_constant_list->arguments = global_token->prev;
 	}
 	else
@@ -2917,16 +5805,16 @@ void global_static_array(struct type* type_size, struct token_list* name)
 {
 	int size;
 	maybe_bootstrap_error("global array definitions");
-	globals_list = emit(":GLOBAL_", globals_list);
-	globals_list = emit(name->s, globals_list);
-	globals_list = emit("\n&GLOBAL_STORAGE_", globals_list);
-	globals_list = emit(name->s, globals_list);
+	emit(":GLOBAL_", globals_list);
+	emit(name->s, globals_list);
+	emit("\n&GLOBAL_STORAGE_", globals_list);
+	emit(name->s, globals_list);
 	if (AARCH64 == Architecture || AMD64 == Architecture || RISCV64 == Architecture)
 	{
-		globals_list = emit(" %0", globals_list);
+		emit(" %0", globals_list);
 	}
-	globals_list = emit("\n:GLOBAL_STORAGE_", globals_list);
-	globals_list = emit(name->s, globals_list);
+	emit("\n:GLOBAL_STORAGE_", globals_list);
+	emit(name->s, globals_list);
 
 	require(NULL != global_token->next, "Unterminated global\n");
 	global_token = global_token->next;
@@ -2936,7 +5824,7 @@ void global_static_array(struct type* type_size, struct token_list* name)
 	{
 		line_error();
 		fputs("Negative values are not supported for allocated arrays\n", stderr);
-		exit(EXIT_FAILURE);
+		compile_failure();
 	}
 
 	/* length */
@@ -2947,7 +5835,7 @@ void global_static_array(struct type* type_size, struct token_list* name)
 	{
 		line_error();
 		fputs("M2-Planet is very inefficient so you probably don't want to allocate over 1MB into your binary for NULLs\n", stderr);
-		exit(EXIT_FAILURE);
+		compile_failure();
 	}
 
 	/* Ensure properly closed */
@@ -2955,49 +5843,49 @@ void global_static_array(struct type* type_size, struct token_list* name)
 	require_match("missing close bracket\n", "]");
 	require_match("missing ;\n", ";");
 
-	globals_list = emit("\n'", globals_list);
+	emit("\n'", globals_list);
 	while (0 != size)
 	{
-		globals_list = emit(" 00", globals_list);
+		emit(" 00", globals_list);
 		size = size - 1;
 	}
-	globals_list = emit("'\n", globals_list);
+	emit("'\n", globals_list);
 }
 
 void global_assignment(void)
 {
 	/* Store the global's value*/
-	globals_list = emit(":GLOBAL_", globals_list);
-	globals_list = emit(global_token->prev->s, globals_list);
-	globals_list = emit("\n", globals_list);
+	emit(":GLOBAL_", globals_list);
+	emit(global_token->prev->s, globals_list);
+	emit("\n", globals_list);
 	global_token = global_token->next;
 	require(NULL != global_token, "Global locals value in assignment\n");
 	unsigned padding_zeroes;
-	if(in_set(global_token->s[0], "0123456789"))
+	if(TOKEN_NUMBER == global_token->kind)
 	{ /* Assume Int */
-		globals_list = emit("%", globals_list);
-		globals_list = emit(global_token->s, globals_list);
+		emit("%", globals_list);
+		emit(global_token->s, globals_list);
 
 		/* broken for big endian architectures */
 		padding_zeroes = (register_size / 4) - 1;
 		while(padding_zeroes > 0)
 		{
 			/* Assume positive Int */
-			globals_list = emit(" %0", globals_list);
+			emit(" %0", globals_list);
 			padding_zeroes = padding_zeroes - 1;
 		}
-		globals_list = emit("\n", globals_list);
+		emit("\n", globals_list);
 	}
-	else if(('"' == global_token->s[0]))
+	else if(TOKEN_STRING == global_token->kind)
 	{ /* Assume a string*/
-		globals_list = emit("&GLOBAL_", globals_list);
-		globals_list = emit(global_token->prev->prev->s, globals_list);
-		globals_list = emit("_contents\n", globals_list);
+		emit("&GLOBAL_", globals_list);
+		emit(global_token->prev->prev->s, globals_list);
+		emit("_contents\n", globals_list);
 
-		globals_list = emit(":GLOBAL_", globals_list);
-		globals_list = emit(global_token->prev->prev->s, globals_list);
-		globals_list = emit("_contents\n", globals_list);
-		globals_list = emit(parse_string(global_token->s), globals_list);
+		emit(":GLOBAL_", globals_list);
+		emit(global_token->prev->prev->s, globals_list);
+		emit("_contents\n", globals_list);
+		emit(parse_string(global_token->s), globals_list);
 	}
 	else
 	{
@@ -3005,7 +5893,7 @@ void global_assignment(void)
 		fputs("Received ", stderr);
 		fputs(global_token->s, stderr);
 		fputs(" in program\n", stderr);
-		exit(EXIT_FAILURE);
+		compile_failure();
 	}
 
 	global_token = global_token->next;
@@ -3033,18 +5921,41 @@ void global_assignment(void)
  * parameter-declaration:
  *     type-name identifier-opt
  */
+void init_keywords(void)
+{
+	keyword_struct = intern("struct");
+	keyword_if = intern("if");
+	keyword_else = intern("else");
+	keyword_switch = intern("switch");
+	keyword_case = intern("case");
+	keyword_default = intern(":default");
+	keyword_do = intern("do");
+	keyword_while = intern("while");
+	keyword_for = intern("for");
+	keyword_asm = intern("asm");
+	keyword_goto = intern("goto");
+	keyword_return = intern("return");
+	keyword_break = intern("break");
+	keyword_continue = intern("continue");
+}
+
 void program(void)
 {
 	unsigned i;
 	function = NULL;
 	Address_of = FALSE;
 	struct type* type_size;
+	init_keywords();
+	global_symbol_table = new_sym_table();
+	global_function_table = new_sym_table();
+	global_constant_table = new_sym_table();
+	scope_table = new_sym_table();
 
 new_type:
 	/* Deal with garbage input */
 	if (NULL == global_token) return;
-	require('#' != global_token->s[0], "unhandled macro directive\n");
-	require(!match("\n", global_token->s), "unexpected newline token\n");
+	require(TOKEN_DIRECTIVE != global_token->kind, "unhandled macro directive\n");
+	require(TOKEN_NEWLINE != global_token->kind, "unexpected newline token\n");
 
 	/* Handle cc_* CONSTANT statements */
 	if(match("CONSTANT", global_token->s))
@@ -3060,6 +5971,15 @@ new_type:
 		goto new_type;
 	}
 
+	/* inline only applies to the function that follows it */
+	inline_keyword = FALSE;
+	if(match("inline", global_token->s))
+	{
+		inline_keyword = TRUE;
+		global_token = global_token->next;
+		require(NULL != global_token, "Received EOF after inline\n");
+	}
+
 	type_size = type_name();
 	/* Deal with case of struct definitions */
 	if(NULL == type_size) goto new_type;
@@ -3068,6 +5988,7 @@ new_type:
 
 	/* Add to global symbol table */
 	global_symbol_list = sym_declare(global_token->s, type_size, global_symbol_list);
+	sym_index(global_symbol_table, global_symbol_list);
 	global_token = global_token->next;
 
 	/* Deal with global variables */
@@ -3075,15 +5996,15 @@ new_type:
 	{
 		/* Ensure enough bytes are allocated to store global variable.
 		   In some cases it allocates too much but that is harmless. */
-		globals_list = emit(":GLOBAL_", globals_list);
-		globals_list = emit(global_token->prev->s, globals_list);
+		emit(":GLOBAL_", globals_list);
+		emit(global_token->prev->s, globals_list);
 
 		/* round up division */
 		i = ceil_div(type_size->size, register_size);
-		globals_list = emit("\n", globals_list);
+		emit("\n", globals_list);
 		while(i != 0)
 		{
-			globals_list = emit("NULL\n", globals_list);
+			emit("NULL\n", globals_list);
 			i = i - 1;
 		}
 		global_token = global_token->next;
@@ -3116,17 +6037,7 @@ new_type:
 	fputs("Received ", stderr);
 	fputs(global_token->s, stderr);
 	fputs(" in program\n", stderr);
-	exit(EXIT_FAILURE);
-}
-
-void recursive_output(struct token_list* head, FILE* out)
-{
-	struct token_list* i = reverse_list(head);
-	while(NULL != i)
-	{
-		fputs(i->s, out);
-		i = i->next;
-	}
+	compile_failure();
 }
 
 void output_tokens(struct token_list *i, FILE* out)
@@ -16,6 +16,8 @@
  * along with M2-Planet.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include "cc.h"
+
 /* What types we have */
 struct type* global_types;
 struct type* prim_types;
@@ -24,9 +26,18 @@ struct type* prim_types;
 struct token_list* global_token;
 
 /* Output reorder collections*/
-struct token_list* output_list;
-struct token_list* strings_list;
-struct token_list* globals_list;
+struct emit_buffer* output_list;
+struct emit_buffer* strings_list;
+struct emit_buffer* globals_list;
+
+/* DEFINEs for the instructions -O1 names itself */
+struct emit_buffer* defines_list;
+
+/* Each function is written here as soon as it is compiled */
+FILE* function_stream;
+
+/* Where -o sends it, so a failed compile can remove what was written */
+char* destination_name;
 
 /* Make our string collection more efficient */
 char* hold_string;
@@ -42,5 +53,47 @@ struct type* integer;
 /* enable bootstrap-mode */
 int BOOTSTRAP_MODE;
 
+/* enable the peephole pass (-O1) */
+int OPTIMIZE;
+
+/* longest return expression, in tokens, that -O1 inlines */
+int INLINE_LIMIT;
+
+/* only write out what main and the --keep names reach */
+int PRUNE;
+
+/* pass the first arguments of calls in registers (--register-arguments) */
+int REGISTER_ARGUMENTS;
+
 /* enable preprocessor-only mode */
 int PREPROCESSOR_MODE;
+
+/* How often lookup_macro was asked and how often it found a macro */
+int macro_lookups;
+int macro_hits;
+
+/* Tokens, symbols and types live until we exit, so bump allocate them */
+char* arena;
+int arena_left;
+int arena_used;
+
+void* arena_alloc(int size)
+{
+	char* r;
+
+	/* Keep every node pointer aligned */
+	size = ((size + 7) >> 3) << 3;
+	if(size > arena_left)
+	{
+		arena_left = 1 << 20;
+		if(size > arena_left) arena_left = size;
+		arena = calloc(arena_left, sizeof(char));
+		require(NULL != arena, "Exhausted memory while growing the arena\n");
+	}
+
+	r = arena;
+	arena = arena + size;
+	arena_left = arena_left - size;
+	arena_used = arena_used + size;
+	return r;
+}
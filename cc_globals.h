@@ -24,9 +24,14 @@ extern struct type* prim_types;
 extern struct token_list* global_token;
 
 /* Output reorder collections*/
-extern struct token_list* output_list;
-extern struct token_list* strings_list;
-extern struct token_list* globals_list;
+extern struct emit_buffer* output_list;
+extern struct emit_buffer* strings_list;
+extern struct emit_buffer* globals_list;
+extern struct emit_buffer* defines_list;
+
+/* Each function is written here as soon as it is compiled */
+extern FILE* function_stream;
+extern char* destination_name;
 
 /* Make our string collection more efficient */
 extern char* hold_string;
@@ -45,5 +50,24 @@ extern struct type* integer;
 /* enable bootstrap-mode */
 extern int BOOTSTRAP_MODE;
 
+/* enable the peephole pass (-O1) */
+extern int OPTIMIZE;
+
+/* longest return expression, in tokens, that -O1 inlines */
+extern int INLINE_LIMIT;
+
+/* only write out what main and the --keep names reach */
+extern int PRUNE;
+
+/* pass the first arguments of calls in registers (--register-arguments) */
+extern int REGISTER_ARGUMENTS;
+
 /* enable preprocessor-only mode */
 extern int PREPROCESSOR_MODE;
+
+/* Total bytes handed out by arena_alloc */
+extern int arena_used;
+
+/* How often lookup_macro was asked and how often it found a macro */
+extern int macro_lookups;
+extern int macro_hits;
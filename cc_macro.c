@@ -38,22 +38,42 @@ struct macro_list
 	struct token_list* expansion;
 };
 
-struct macro_list* macro_env;
+/* Macros are chained per bucket, newest first, so the latest #define wins */
+struct macro_list** macro_table;
 struct conditional_inclusion* conditional_inclusion_top;
 
 /* point where we are currently modifying the global_token list */
 struct token_list* macro_token;
 
+int macro_hash(char* s)
+{
+	return hash_string(s) & (MACRO_TABLE_SIZE - 1);
+}
+
+/* Symbols are interned so the bucket chains can be compared by pointer */
+void add_macro(struct macro_list* hold)
+{
+	if(NULL == macro_table)
+	{
+		macro_table = calloc(MACRO_TABLE_SIZE, sizeof(struct macro_list*));
+		require(NULL != macro_table, "Exhausted memory while creating the macro table\n");
+	}
+
+	int h = macro_hash(hold->symbol);
+	hold->next = macro_table[h];
+	macro_table[h] = hold;
+}
+
 void init_macro_env(char* sym, char* value, char* source, int num)
 {
-	struct macro_list* hold = macro_env;
-	macro_env = calloc(1, sizeof(struct macro_list));
-	macro_env->symbol = sym;
-	macro_env->next = hold;
-	macro_env->expansion = calloc(1, sizeof(struct token_list));
-	macro_env->expansion->s = value;
-	macro_env->expansion->filename = source;
-	macro_env->expansion->linenumber = num;
+	struct macro_list* hold = calloc(1, sizeof(struct macro_list));
+	hold->symbol = intern(sym);
+	hold->expansion = arena_alloc(sizeof(struct token_list));
+	hold->expansion->s = intern(value);
+	hold->expansion->kind = classify_token(hold->expansion->s);
+	hold->expansion->filename = source;
+	hold->expansion->linenumber = num;
+	add_macro(hold);
 }
 
 void eat_current_token(void)
@@ -95,8 +115,9 @@ struct token_list* insert_tokens(struct token_list* point, struct token_list* to
 
 	while (NULL != token)
 	{
-		copy = calloc(1, sizeof(struct token_list));
+		copy = arena_alloc(sizeof(struct token_list));
 		copy->s = token->s;
+		copy->kind = token->kind;
 		copy->filename = token->filename;
 		copy->linenumber = token->linenumber;
 
@@ -134,13 +155,17 @@ struct macro_list* lookup_macro(struct token_list* token)
 		exit(EXIT_FAILURE);
 	}
 
-	struct macro_list* hold = macro_env;
+	macro_lookups = macro_lookups + 1;
+	if(NULL == macro_table) return NULL;
+
+	struct macro_list* hold = macro_table[macro_hash(token->s)];
 
 	while (NULL != hold)
 	{
-		if (match(token->s, hold->symbol))
+		if (token->s == hold->symbol)
 		{
 			/* found! */
+			macro_hits = macro_hits + 1;
 			return hold;
 		}
 
@@ -160,12 +185,19 @@ void remove_macro(struct token_list* token)
 		exit(EXIT_FAILURE);
 	}
 
-	struct macro_list* hold = macro_env;
+	/* nothing was ever defined */
+	if(NULL == macro_table) return;
+
+	int h = macro_hash(token->s);
+	struct macro_list* hold = macro_table[h];
 	struct macro_list* temp;
 
+	/* nothing in this bucket */
+	if(NULL == hold) return;
+
 	/* Deal with the first element */
-	if (match(token->s, hold->symbol)) {
-		macro_env = hold->next;
+	if (token->s == hold->symbol) {
+		macro_table[h] = hold->next;
 		free(hold);
 		return;
 	}
@@ -173,7 +205,7 @@ void remove_macro(struct token_list* token)
 	/* Remove element form the middle of linked list */
 	while (NULL != hold->next)
 	{
-		if (match(token->s, hold->next->symbol))
+		if (token->s == hold->next->symbol)
 		{
 			temp = hold->next;
 			hold->next = hold->next->next;
@@ -274,11 +306,11 @@ int macro_primary_expr(void)
 
 		return hold;
 	}
-	else if(in_set(macro_token->s[0], "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_"))
+	else if((TOKEN_IDENTIFIER == macro_token->kind) || (TOKEN_KEYWORD == macro_token->kind))
 	{
 		return macro_variable();
 	}
-	else if(in_set(macro_token->s[0], "0123456789"))
+	else if(TOKEN_NUMBER == macro_token->kind)
 	{
 		return macro_number();
 	}
@@ -442,14 +474,13 @@ void handle_define(void)
 	eat_current_token();
 
 	require(NULL != macro_token, "got an EOF terminated #define\n");
-	require('\n' != macro_token->s[0], "unexpected newline after #define\n");
+	require(TOKEN_NEWLINE != macro_token->kind, "unexpected newline after #define\n");
 
 	/* insert new macro */
 	hold = calloc(1, sizeof(struct macro_list));
 	hold->symbol = macro_token->s;
-	hold->next = macro_env;
 	/* provided it isn't in a non-included block */
-	if(conditional_define) macro_env = hold;
+	if(conditional_define) add_macro(hold);
 
 	/* discard the macro name */
 	eat_current_token();
@@ -458,7 +489,7 @@ void handle_define(void)
 	{
 		require(NULL != macro_token, "got an EOF terminated #define\n");
 
-		if ('\n' == macro_token->s[0])
+		if (TOKEN_NEWLINE == macro_token->kind)
 		{
 			if(NULL == expansion_end)
 			{
@@ -520,7 +551,7 @@ void handle_error(int warning_p)
 		while (TRUE)
 		{
 			require(NULL != macro_token, "\nFailed to properly terminate error message with \\n\n");
-			if ('\n' == macro_token->s[0]) break;
+			if (TOKEN_NEWLINE == macro_token->kind) break;
 			fputs(macro_token->s, stderr);
 			macro_token = macro_token->next;
 			fputs(" ", stderr);
@@ -532,7 +563,7 @@ void handle_error(int warning_p)
 	{
 		require(NULL != macro_token, "\nFailed to properly terminate error message with \\n\n");
 		/* discard the error */
-		if ('\n' == macro_token->s[0])
+		if (TOKEN_NEWLINE == macro_token->kind)
 		{
 			return;
 		}
@@ -696,7 +727,7 @@ void macro_directive(void)
 				return;
 			}
 
-			if('\n' == macro_token->s[0])
+			if(TOKEN_NEWLINE == macro_token->kind)
 			{
 				return;
 			}
@@ -791,13 +822,13 @@ void preprocess(void)
 
 	while(NULL != macro_token)
 	{
-		if(start_of_line && '#' == macro_token->s[0])
+		if(start_of_line && (TOKEN_DIRECTIVE == macro_token->kind))
 		{
 			macro_directive();
 
 			if(macro_token)
 			{
-				if('\n' != macro_token->s[0])
+				if(TOKEN_NEWLINE != macro_token->kind)
 				{
 					line_error_token(macro_token);
 					fputs("newline expected at end of macro directive\n", stderr);
@@ -808,7 +839,7 @@ void preprocess(void)
 				}
 			}
 		}
-		else if('\n' == macro_token->s[0])
+		else if(TOKEN_NEWLINE == macro_token->kind)
 		{
 			start_of_line = TRUE;
 			macro_token = macro_token->next;
@@ -19,34 +19,88 @@
 #include "cc.h"
 
 int strtoint(char *a);
+int iskeywordp(char* s);
 
 /* Globals */
-FILE* input;
+char* source;
+int source_size;
+int source_index;
+int token_start;
+int token_length;
 struct token_list* token;
 int line;
 char* file;
 
+/* Every token spelling is stored once so names can be compared by pointer */
+struct interned
+{
+	struct interned* next;
+	char* s;
+	int length;
+	int kind;
+};
+struct interned** intern_table;
+
+/* Pull the whole input file into memory so the lexer can walk a buffer */
+void load_source(FILE* in)
+{
+	int size = 4096;
+	char* buffer = malloc(size);
+	int count;
+	require(NULL != buffer, "Exhausted memory while loading source file\n");
+
+	/* Always keep a spare byte so the last token can be terminated in place */
+	source_size = 0;
+	count = fread(buffer, sizeof(char), size - 1, in);
+	while(0 < count)
+	{
+		source_size = source_size + count;
+		if((source_size + 1) == size)
+		{
+			/* Out of room, double the buffer */
+			size = size << 1;
+			buffer = realloc(buffer, size);
+			require(NULL != buffer, "Exhausted memory while growing source buffer\n");
+		}
+		count = fread(buffer + source_size, sizeof(char), size - source_size - 1, in);
+	}
+	buffer[source_size] = 0;
+
+	source = buffer;
+	source_index = 0;
+}
+
 int grab_byte(void)
 {
-	int c = fgetc(input);
+	if(source_index >= source_size) return EOF;
+	int c = source[source_index] & 0xFF;
+	source_index = source_index + 1;
 	if(10 == c) line = line + 1;
 	return c;
 }
 
 int clearWhiteSpace(int c)
 {
-	if((32 == c) || (9 == c)) return clearWhiteSpace(grab_byte());
+	while((32 == c) || (9 == c))
+	{
+		c = grab_byte();
+	}
 	return c;
 }
 
-int consume_byte(int c)
+/* Token text is never copied while lexing, only its extent in source is tracked */
+int consume_byte(void)
 {
-	hold_string[string_index] = c;
-	string_index = string_index + 1;
-	require(MAX_STRING > string_index, "Token exceeded MAX_STRING char limit\nuse --max-string number to increase\n");
+	token_length = token_length + 1;
 	return grab_byte();
 }
 
+void start_token(void)
+{
+	token_start = source_index - 1;
+	token_length = 0;
+}
+
 int preserve_string(int c)
 {
 	int frequent = c;
@@ -55,7 +109,7 @@ int preserve_string(int c)
 	{
 		if(!escape && '\\' == c ) escape = TRUE;
 		else escape = FALSE;
-		c = consume_byte(c);
+		c = consume_byte();
 		require(EOF != c, "Unterminated string\n");
 	} while(escape || (c != frequent));
 	return grab_byte();
@@ -73,26 +127,155 @@ void copy_string(char* target, char* source, int max)
 	}
 }
 
+/* Copy the current token into the arena, leaving room for a prefix */
+char* copy_token(int offset)
+{
+	char* s = arena_alloc(offset + token_length + 1);
+	int i = 0;
+	while(i < token_length)
+	{
+		s[offset + i] = source[token_start + i];
+		i = i + 1;
+	}
+	return s;
+}
 
-void fixup_label(void)
+int hash_slice(char* s, int length)
 {
-	int hold = ':';
-	int prev;
+	int h = 0;
 	int i = 0;
-	do
+	while(i < length)
 	{
-		prev = hold;
-		hold = hold_string[i];
-		hold_string[i] = prev;
+		h = (((h << 5) - h) + (s[i] & 0xFF)) & 0xFFFFFF;
 		i = i + 1;
-	} while(0 != hold);
+	}
+	return h;
+}
+
+/* Same hash as the intern table uses, callers mask it to their table size */
+int hash_string(char* s)
+{
+	int length = 0;
+	while(0 != s[length])
+	{
+		length = length + 1;
+	}
+	return hash_slice(s, length);
+}
+
+struct interned* lookup_slice(char* s, int length, int h)
+{
+	struct interned* i;
+	int j;
+	if(NULL == intern_table)
+	{
+		intern_table = calloc(INTERN_TABLE_SIZE, sizeof(struct interned*));
+		require(NULL != intern_table, "Exhausted memory while creating the intern table\n");
+	}
+
+	for(i = intern_table[h]; NULL != i; i = i->next)
+	{
+		if(length == i->length)
+		{
+			j = 0;
+			while((j < length) && (s[j] == i->s[j]))
+			{
+				j = j + 1;
+			}
+			if(j == length) return i;
+		}
+	}
+	return NULL;
+}
+
+/* The kind only depends on the spelling, so it is worked out once per spelling */
+int classify_token(char* s)
+{
+	int c = s[0];
+	if('\n' == c) return TOKEN_NEWLINE;
+	if('#' == c) return TOKEN_DIRECTIVE;
+	if('"' == c) return TOKEN_STRING;
+	if('\'' == c) return TOKEN_CHAR;
+	if(in_set(c, "0123456789")) return TOKEN_NUMBER;
+	if((':' == c) && (0 != s[1])) return TOKEN_LABEL;
+	if(in_set(c, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_"))
+	{
+		if(iskeywordp(s)) return TOKEN_KEYWORD;
+		return TOKEN_IDENTIFIER;
+	}
+	return TOKEN_PUNCTUATOR;
+}
+
+struct interned* add_interned(char* s, int length, int h)
+{
+	struct interned* i = arena_alloc(sizeof(struct interned));
+	i->s = s;
+	i->length = length;
+	i->kind = classify_token(s);
+	i->next = intern_table[h];
+	intern_table[h] = i;
+	return i;
+}
+
+struct interned* intern_entry(char* s)
+{
+	int length = 0;
+	while(0 != s[length])
+	{
+		length = length + 1;
+	}
+
+	int h = hash_slice(s, length) & (INTERN_TABLE_SIZE - 1);
+	struct interned* i = lookup_slice(s, length, h);
+	if(NULL != i) return i;
+
+	return add_interned(s, length, h);
+}
+
+/* Return the single shared copy of s, which must never be modified after */
+char* intern(char* s)
+{
+	struct interned* i = intern_entry(s);
+	return i->s;
+}
+
+/* The token is a slice of the source buffer; reuse its spelling if we have
+ * seen it before. If the byte after it is whitespace or otherwise consumed,
+ * NUL terminate it in place and use the buffer directly. Otherwise that byte
+ * starts the next token and we copy. */
+struct interned* token_text(int c, int terminate)
+{
+	char* s = source + token_start;
+	int h = hash_slice(s, token_length) & (INTERN_TABLE_SIZE - 1);
+	struct interned* i = lookup_slice(s, token_length, h);
+	if(NULL != i) return i;
+
+	if((32 == c) || (9 == c) || (10 == c) || (EOF == c)) terminate = TRUE;
+
+	if(terminate)
+	{
+		s[token_length] = 0;
+	}
+	else
+	{
+		s = copy_token(0);
+	}
+
+	return add_interned(s, token_length, h);
+}
+
+struct interned* fixup_label(void)
+{
+	char* s = copy_token(1);
+	s[0] = ':';
+	return intern_entry(s);
 }
 
 int preserve_keyword(int c, char* S)
 {
 	while(in_set(c, S))
 	{
-		c = consume_byte(c);
+		c = consume_byte();
 	}
 	return c;
 }
@@ -129,7 +312,7 @@ struct token_list* eat_until_newline(struct token_list* head)
 {
 	while (NULL != head)
 	{
-		if('\n' == head->s[0])
+		if(TOKEN_NEWLINE == head->kind)
 		{
 			return head;
 		}
@@ -194,7 +377,7 @@ struct token_list* remove_preprocessor_directives(struct token_list* head)
 
 	while (NULL != head)
 	{
-		if('#' == head->s[0])
+		if(TOKEN_DIRECTIVE == head->kind)
 		{
 			head = eat_until_newline(head);
 		}
@@ -211,16 +394,11 @@ struct token_list* remove_preprocessor_directives(struct token_list* head)
 	return first;
 }
 
-void new_token(char* s, int size)
+void new_token(struct interned* i)
 {
-	struct token_list* current = calloc(1, sizeof(struct token_list));
-	require(NULL != current, "Exhausted memory while getting token\n");
-
-	/* More efficiently allocate memory for string */
-	current->s = calloc(size, sizeof(char));
-	require(NULL != current->s, "Exhausted memory while trying to copy a token\n");
-	copy_string(current->s, s, MAX_STRING);
-
+	struct token_list* current = arena_alloc(sizeof(struct token_list));
+	current->s = i->s;
+	current->kind = i->kind;
 	current->prev = token;
 	current->next = token;
 	current->linenumber = line;
@@ -230,22 +408,19 @@ void new_token(char* s, int size)
 
 int get_token(int c)
 {
-	struct token_list* current = calloc(1, sizeof(struct token_list));
-	require(NULL != current, "Exhausted memory while getting token\n");
+	/* Set when the byte following the token is not needed anymore */
+	int terminate = FALSE;
 
 reset:
-	reset_hold_string();
-	string_index = 0;
-
 	c = clearWhiteSpace(c);
+	start_token();
 	if(c == EOF)
 	{
-		free(current);
 		return c;
 	}
 	else if('#' == c)
 	{
-		c = consume_byte(c);
+		c = consume_byte();
 		c = preserve_keyword(c, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
 	}
 	else if(in_set(c, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_"))
@@ -253,8 +428,8 @@ reset:
 		c = preserve_keyword(c, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_");
 		if(':' == c)
 		{
-			fixup_label();
-			c = ' ';
+			new_token(fixup_label());
+			return ' ';
 		}
 	}
 	else if(in_set(c, "<=>|&!^%"))
@@ -264,10 +439,12 @@ reset:
 	else if(in_set(c, "'\""))
 	{
 		c = preserve_string(c);
+		/* The closing quote is not part of the token */
+		terminate = TRUE;
 	}
 	else if(c == '/')
 	{
-		c = consume_byte(c);
+		c = consume_byte();
 		if(c == '*')
 		{
 			c = grab_byte();
@@ -286,66 +463,66 @@ reset:
 		}
 		else if(c == '/')
 		{
-			c = consume_byte(c);
+			c = consume_byte();
 		}
 		else if(c == '=')
 		{
-			c = consume_byte(c);
+			c = consume_byte();
 		}
 	}
 	else if (c == '\n')
 	{
-		c = consume_byte(c);
+		new_token(intern_entry("\n"));
+		return grab_byte();
 	}
 	else if(c == '*')
 	{
-		c = consume_byte(c);
+		c = consume_byte();
 		if(c == '=')
 		{
-			c = consume_byte(c);
+			c = consume_byte();
 		}
 	}
 	else if(c == '+')
 	{
-		c = consume_byte(c);
+		c = consume_byte();
 		if(c == '=')
 		{
-			c = consume_byte(c);
+			c = consume_byte();
 		}
 		if(c == '+')
 		{
-			c = consume_byte(c);
+			c = consume_byte();
 		}
 	}
 	else if(c == '-')
 	{
-		c = consume_byte(c);
+		c = consume_byte();
 		if(c == '=')
 		{
-			c = consume_byte(c);
+			c = consume_byte();
 		}
 		if(c == '>')
 		{
-			c = consume_byte(c);
+			c = consume_byte();
 		}
 		if(c == '-')
 		{
-			c = consume_byte(c);
+			c = consume_byte();
 		}
 	}
 	else
 	{
-		c = consume_byte(c);
+		c = consume_byte();
 	}
 
-	new_token(hold_string, string_index + 2);
+	new_token(token_text(c, terminate));
 	return c;
 }
 
 
 int consume_filename(int c)
 {
-	reset_hold_string();
 	int done = FALSE;
 
 	while(!done)
@@ -361,17 +538,18 @@ int consume_filename(int c)
 		}
 		else
 		{
+			start_token();
 			do
 			{
-				c = consume_byte(c);
+				c = consume_byte();
 				require(EOF != c, "Unterminated filename in #FILENAME\n");
 			} while((32 != c) && (9 != c) && ('\n' != c));
 			done = TRUE;
 		}
 	}
 
-	/* with just a little extra to put in the matching at the end */
-	new_token(hold_string, string_index + 3);
+	/* Always followed by whitespace, so never copied */
+	new_token(token_text(c, TRUE));
 	return c;
 }
 
@@ -424,7 +602,7 @@ struct token_list* reverse_list(struct token_list* head)
 
 struct token_list* read_all_tokens(FILE* a, struct token_list* current, char* filename)
 {
-	input  = a;
+	load_source(a);
 	line = 1;
 	file = filename;
 	token = current;
@@ -19,8 +19,9 @@
 #include "cc.h"
 #include <stdint.h>
 
-struct token_list* emit(char *s, struct token_list* head);
+void emit(char *s, struct emit_buffer* b);
 void require(int bool, char* error);
+void compile_failure(void);
 
 char upcase(char a)
 {
@@ -48,7 +49,7 @@ int hexify(int c, int high)
 	if(0 > i)
 	{
 		fputs("Tried to print non-hex number\n", stderr);
-		exit(EXIT_FAILURE);
+		compile_failure();
 	}
 
 	if(high)
@@ -106,7 +107,7 @@ int escape_lookup(char* c)
 	fputs("Unknown escape received: ", stderr);
 	fputs(c, stderr);
 	fputs(" Unable to process\n", stderr);
-	exit(EXIT_FAILURE);
+	compile_failure();
 }
 
 /* Deal with human strings */
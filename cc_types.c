@@ -20,11 +20,56 @@
 /* Imported functions */
 int strtoint(char *a);
 void line_error(void);
+void compile_failure(void);
 void require(int bool, char* error);
 
+/* Hashed views of the type lists; owner is only used by member_table */
+struct type_index
+{
+	struct type_index* next;
+	struct type* type;
+	struct type* owner;
+};
+
+/* Primitives and typedefs, the first definition of a name wins */
+struct type_index** prim_table;
+/* Structs, the newest definition of a name wins */
+struct type_index** struct_table;
+/* Members of large structs, keyed by the struct's member chain */
+struct type_index** member_table;
+
+struct type_index** new_type_table(void)
+{
+	struct type_index** r = calloc(TYPE_TABLE_SIZE, sizeof(struct type_index*));
+	require(NULL != r, "Exhausted memory while creating a type table\n");
+	return r;
+}
+
+struct type_index* find_type_index(struct type_index** table, char* s, struct type* owner)
+{
+	struct type_index* i;
+	for(i = table[hash_string(s) & (TYPE_TABLE_SIZE - 1)]; NULL != i; i = i->next)
+	{
+		/* Type names and tokens are both interned */
+		if((s == i->type->name) && (owner == i->owner)) return i;
+	}
+	return NULL;
+}
+
+void add_type_index(struct type_index** table, struct type* a, struct type* owner)
+{
+	int h = hash_string(a->name) & (TYPE_TABLE_SIZE - 1);
+	struct type_index* i = arena_alloc(sizeof(struct type_index));
+	i->type = a;
+	i->owner = owner;
+	i->next = table[h];
+	table[h] = i;
+}
+
 /* enable easy primitive extension */
 struct type* add_primitive(struct type* a)
 {
+	if(NULL == find_type_index(prim_table, a->name, NULL)) add_type_index(prim_table, a, NULL);
 	if(NULL == prim_types) return a;
 	struct type* i = prim_types;
 	while(NULL != i->next)
@@ -40,25 +85,22 @@ struct type* add_primitive(struct type* a)
 struct type* new_primitive(char* name0, char* name1, char* name2, int size, int sign)
 {
 	/* Create type** */
-	struct type* a = calloc(1, sizeof(struct type));
-	require(NULL != a, "Exhausted memory while declaring new primitive**\n");
-	a->name = name2;
+	struct type* a = arena_alloc(sizeof(struct type));
+	a->name = intern(name2);
 	a->size = register_size;
 	a->indirect = a;
 	a->is_signed = sign;
 
 	/* Create type* */
-	struct type* b = calloc(1, sizeof(struct type));
-	require(NULL != b, "Exhausted memory while declaring new primitive*\n");
-	b->name = name1;
+	struct type* b = arena_alloc(sizeof(struct type));
+	b->name = intern(name1);
 	b->size = register_size;
 	b->is_signed = sign;
 	b->indirect = a;
 	a->type = b;
 
-	struct type* r = calloc(1, sizeof(struct type));
-	require(NULL != r, "Exhausted memory while declaring new primitive\n");
-	r->name = name0;
+	struct type* r = arena_alloc(sizeof(struct type));
+	r->name = intern(name0);
 	r->size = size;
 	r->is_signed = sign;
 	r->indirect = b;
@@ -74,6 +116,10 @@ void initialize_types(void)
 	if(AMD64 == Architecture || AARCH64 == Architecture || RISCV64 == Architecture) register_size = 8;
 	else register_size = 4;
 
+	prim_table = new_type_table();
+	struct_table = new_type_table();
+	member_table = new_type_table();
+
 	/* Define void */
 	struct type* hold = new_primitive("void", "void*", "void**", register_size, FALSE);
 	prim_types = add_primitive(hold);
@@ -143,26 +189,40 @@ void initialize_types(void)
 	global_types = prim_types;
 }
 
-struct type* lookup_type(char* s, struct type* start)
+/* Only primitives and typedefs */
+struct type* lookup_primitive(char* s)
 {
-	struct type* i;
-	for(i = start; NULL != i; i = i->next)
-	{
-		if(match(i->name, s))
-		{
-			return i;
-		}
-	}
-	return NULL;
+	struct type_index* i = find_type_index(prim_table, s, NULL);
+	if(NULL == i) return NULL;
+	return i->type;
+}
+
+/* Structs shadow primitives and typedefs of the same name */
+struct type* lookup_type(char* s)
+{
+	struct type_index* i = find_type_index(struct_table, s, NULL);
+	if(NULL == i) return lookup_primitive(s);
+	return i->type;
 }
 
 struct type* lookup_member(struct type* parent, char* name)
 {
 	struct type* i;
+	struct type_index* hold;
+	int count = 0;
 	require(NULL != parent, "Not a valid struct type\n");
 	for(i = parent->members; NULL != i; i = i->members)
 	{
-		if(match(i->name, name)) return i;
+		if(i->name == name) return i;
+
+		/* Large structs have every member indexed */
+		count = count + 1;
+		if(MEMBER_INDEX_THRESHOLD == count)
+		{
+			hold = find_type_index(member_table, name, parent->members);
+			if(NULL != hold) return hold->type;
+			break;
+		}
 	}
 
 	fputs("ERROR in lookup_member ", stderr);
@@ -172,7 +232,7 @@ struct type* lookup_member(struct type* parent, char* name)
 	fputs(" does not exist\n", stderr);
 	line_error();
 	fputs("\n", stderr);
-	exit(EXIT_FAILURE);
+	compile_failure();
 }
 
 struct type* type_name(void);
@@ -181,8 +241,7 @@ void require_match(char* message, char* required);
 int member_size;
 struct type* build_member(struct type* last, int offset)
 {
-	struct type* i = calloc(1, sizeof(struct type));
-	require(NULL != i, "Exhausted memory while building a struct member\n");
+	struct type* i = arena_alloc(sizeof(struct type));
 	i->members = last;
 	i->offset = offset;
 
@@ -202,7 +261,7 @@ struct type* build_member(struct type* last, int offset)
 		if(0 == i->size)
 		{
 			fputs("Struct only supports [num] form\n", stderr);
-			exit(EXIT_FAILURE);
+			compile_failure();
 		}
 		global_token = global_token->next;
 		require_match("Struct only supports [num] form\n", "]");
@@ -236,20 +295,36 @@ struct type* build_union(struct type* last, int offset)
 	return last;
 }
 
+/* Members are chained newest first and lookup_member returns the first
+ * match along the chain, so only index the first occurrence of a name */
+void index_members(struct type* last)
+{
+	struct type* i;
+	int count = 0;
+	for(i = last; NULL != i; i = i->members)
+	{
+		count = count + 1;
+	}
+	if(MEMBER_INDEX_THRESHOLD > count) return;
+
+	for(i = last; NULL != i; i = i->members)
+	{
+		if(NULL == find_type_index(member_table, i->name, last)) add_type_index(member_table, i, last);
+	}
+}
+
 void create_struct(void)
 {
 	int offset = 0;
 	member_size = 0;
-	struct type* head = calloc(1, sizeof(struct type));
-	require(NULL != head, "Exhausted memory while creating a struct\n");
-	struct type* i = calloc(1, sizeof(struct type));
-	require(NULL != i, "Exhausted memory while creating a struct indirection\n");
-	struct type* ii = calloc(1, sizeof(struct type));
-	require(NULL != ii, "Exhausted memory while creating a struct double indirection\n");
+	struct type* head = arena_alloc(sizeof(struct type));
+	struct type* i = arena_alloc(sizeof(struct type));
+	struct type* ii = arena_alloc(sizeof(struct type));
 	head->name = global_token->s;
 	head->type = head;
 	head->indirect = i;
 	head->next = global_types;
+	add_type_index(struct_table, head, NULL);
 	i->name = global_token->s;
 	i->type = head;
 	i->indirect = ii;
@@ -284,6 +359,7 @@ void create_struct(void)
 	head->size = offset;
 	head->members = last;
 	i->members = last;
+	index_members(last);
 }
 
 
@@ -303,7 +379,7 @@ struct type* type_name(void)
 	{
 		global_token = global_token->next;
 		require(NULL != global_token, "structs can not have a EOF type name\n");
-		ret = lookup_type(global_token->s, global_types);
+		ret = lookup_type(global_token->s);
 		if(NULL == ret)
 		{
 			create_struct();
@@ -312,7 +388,7 @@ struct type* type_name(void)
 	}
 	else
 	{
-		ret = lookup_type(global_token->s, global_types);
+		ret = lookup_type(global_token->s);
 		if(NULL == ret)
 		{
 			fputs("Unknown type ", stderr);
@@ -320,7 +396,7 @@ struct type* type_name(void)
 			fputs("\n", stderr);
 			line_error();
 			fputs("\n", stderr);
-			exit(EXIT_FAILURE);
+			compile_failure();
 		}
 	}
 
@@ -345,10 +421,8 @@ struct type* type_name(void)
 
 struct type* mirror_type(struct type* source, char* name)
 {
-	struct type* head = calloc(1, sizeof(struct type));
-	require(NULL != head, "Exhausted memory while creating a struct\n");
-	struct type* i = calloc(1, sizeof(struct type));
-	require(NULL != i, "Exhausted memory while creating a struct indirection\n");
+	struct type* head = arena_alloc(sizeof(struct type));
+	struct type* i = arena_alloc(sizeof(struct type));
 
 	head->name = name;
 	i->name = name;
@@ -0,0 +1,81 @@
+/* Copyright (C) 2026 agent
+ * This file is part of M2-Planet.
+ *
+ * M2-Planet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * M2-Planet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with M2-Planet.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+struct box
+{
+	int a;
+	int b;
+	int c;
+	int d;
+	int e;
+};
+
+/*
+ * Locals may not be declared inside a loop, so the struct lives in a
+ * block of its own; leaving that block has to release every word of it
+ * before the loop below breaks out and the function returns.
+ */
+int find(int limit)
+{
+	int found = 0;
+	if(0 <= limit)
+	{
+		struct box x;
+		x.a = limit;
+		x.e = limit + limit;
+		found = x.a + x.e;
+	}
+
+	int i;
+	for(i = 0; i < 10; i = i + 1)
+	{
+		if(limit == i) break;
+		found = found + 1;
+	}
+	return found;
+}
+
+int walk(int limit)
+{
+	int i = 0;
+	if(0 < limit)
+	{
+		struct box y;
+		struct box z;
+		y.c = limit;
+		z.d = y.c;
+		i = z.d;
+	}
+	while(1)
+	{
+		if(limit < i) break;
+		i = i + 1;
+	}
+	return i;
+}
+
+int main()
+{
+	int i;
+	for(i = 0; i < 8; i = i + 1)
+	{
+		if((i * 4) != find(i)) return 1;
+		if((i + 1) != walk(i)) return 2;
+	}
+	return 0;
+}
@@ -0,0 +1,97 @@
+/* Copyright (C) 2026 agent
+ * This file is part of M2-Planet.
+ *
+ * M2-Planet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * M2-Planet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with M2-Planet.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+struct node
+{
+	int x;
+	struct node* next;
+};
+
+int calls;
+
+int touch(int value)
+{
+	calls = calls + 1;
+	return value;
+}
+
+int both(int a, int b)
+{
+	return a && b;
+}
+
+int either(int a, int b)
+{
+	return a || b;
+}
+
+/* Dereferencing p when it is NULL would crash, so the guard must hold */
+int guarded(struct node* p)
+{
+	if((NULL != p) && p->x) return 1;
+	return 0;
+}
+
+int length(struct node* p)
+{
+	int n = 0;
+	while((NULL != p) && (0 != p->x))
+	{
+		n = n + 1;
+		p = p->next;
+	}
+	return n;
+}
+
+int main()
+{
+	struct node* a = calloc(1, sizeof(struct node));
+	struct node* b = calloc(1, sizeof(struct node));
+	a->x = 3;
+	a->next = b;
+	b->x = 4;
+
+	if(0 != guarded(NULL)) return 1;
+	if(1 != guarded(a)) return 2;
+	if(2 != length(a)) return 3;
+	b->x = 0;
+	if(0 != guarded(b)) return 4;
+	if(1 != length(a)) return 5;
+	if(0 != length(NULL)) return 6;
+
+	/* The right hand side only runs when the left does not decide */
+	calls = 0;
+	if(0 && touch(1)) return 7;
+	if(0 != calls) return 8;
+	if(!(1 || touch(0))) return 9;
+	if(0 != calls) return 10;
+	if(!(1 && touch(1))) return 11;
+	if(0 || touch(0)) return 12;
+	if(2 != calls) return 13;
+
+	/* Used as values they are 0 or 1 */
+	if(1 != both(5, 7)) return 14;
+	if(0 != both(5, 0)) return 15;
+	if(0 != both(0, 7)) return 16;
+	if(1 != either(0, 9)) return 17;
+	if(0 != either(0, 0)) return 18;
+	if(1 != either(-1, 0)) return 19;
+	if(1 != ((NULL != a) && a->next && (4 != a->x || touch(0)))) return 20;
+	if(2 != calls) return 21;
+	return 0;
+}
@@ -0,0 +1,115 @@
+#! /bin/sh
+## Copyright (C) 2017 Jeremiah Orians
+## Copyright (C) 2021 deesix <deesix@tuta.io>
+## This file is part of M2-Planet.
+##
+## M2-Planet is free software: you can redistribute it and/or modify
+## it under the terms of the GNU General Public License as published by
+## the Free Software Foundation, either version 3 of the License, or
+## (at your option) any later version.
+##
+## M2-Planet is distributed in the hope that it will be useful,
+## but WITHOUT ANY WARRANTY; without even the implied warranty of
+## MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+## GNU General Public License for more details.
+##
+## You should have received a copy of the GNU General Public License
+## along with M2-Planet.  If not, see <http://www.gnu.org/licenses/>.
+
+set -x
+
+TMPDIR="test/test0034/tmp-knight-posix"
+mkdir -p ${TMPDIR}
+
+# Build the test
+bin/M2-Planet \
+	--architecture knight-posix \
+	-O1 \
+	-f M2libc/sys/types.h \
+	-f M2libc/stddef.h \
+	-f M2libc/sys/utsname.h \
+	-f M2libc/knight/linux/unistd.c \
+	-f M2libc/knight/linux/fcntl.c \
+	-f M2libc/fcntl.c \
+	-f M2libc/stdlib.c \
+	-f M2libc/stdio.h \
+	-f M2libc/stdio.c \
+	-f test/test0034/optimize.c \
+	-o ${TMPDIR}/optimize.M1 \
+	|| exit 1
+
+# Macro assemble with libc written in M1-Macro
+M1 \
+	-f M2libc/knight/knight_defs.M1 \
+	-f M2libc/knight/libc-full.M1 \
+	-f ${TMPDIR}/optimize.M1 \
+	--big-endian \
+	--architecture knight-posix \
+	-o ${TMPDIR}/optimize.hex2 \
+	|| exit 2
+
+# Resolve all linkages
+hex2 \
+	-f M2libc/knight/ELF-knight.hex2 \
+	-f ${TMPDIR}/optimize.hex2 \
+	--big-endian \
+	--architecture knight-posix \
+	--base-address 0x0 \
+	-o test/results/test0034-knight-posix-binary \
+	|| exit 3
+
+# Build the same test at -O0 to compare against
+bin/M2-Planet \
+	--architecture knight-posix \
+	-O0 \
+	-f M2libc/sys/types.h \
+	-f M2libc/stddef.h \
+	-f M2libc/sys/utsname.h \
+	-f M2libc/knight/linux/unistd.c \
+	-f M2libc/knight/linux/fcntl.c \
+	-f M2libc/fcntl.c \
+	-f M2libc/stdlib.c \
+	-f M2libc/stdio.h \
+	-f M2libc/stdio.c \
+	-f test/test0034/optimize.c \
+	-o ${TMPDIR}/reference.M1 \
+	|| exit 1
+
+M1 \
+	-f M2libc/knight/knight_defs.M1 \
+	-f M2libc/knight/libc-full.M1 \
+	-f ${TMPDIR}/reference.M1 \
+	--big-endian \
+	--architecture knight-posix \
+	-o ${TMPDIR}/reference.hex2 \
+	|| exit 2
+
+hex2 \
+	-f M2libc/knight/ELF-knight.hex2 \
+	-f ${TMPDIR}/reference.hex2 \
+	--big-endian \
+	--architecture knight-posix \
+	--base-address 0x0 \
+	-o ${TMPDIR}/reference \
+	|| exit 3
+
+# Ensure binary works if host machine supports test
+if [ "$(get_machine ${GET_MACHINE_FLAGS})" = "knight" ] && [ ! -z "${KNIGHT_EMULATION}" ]
+then
+	# Verify that the resulting file works and prints what -O0 prints
+	vm --POSIX-MODE --rom ./test/results/test0034-knight-posix-binary --memory 2M >| ${TMPDIR}/optimized.out
+	[ 0 = $? ] || exit 3
+	vm --POSIX-MODE --rom ${TMPDIR}/reference --memory 2M >| ${TMPDIR}/reference.out
+	[ 0 = $? ] || exit 3
+	cmp ${TMPDIR}/reference.out ${TMPDIR}/optimized.out || exit 4
+
+elif [ "$(get_machine ${GET_MACHINE_FLAGS})" = "knight" ]
+then
+	# Verify that the compiled program prints what -O0 prints
+	./test/results/test0034-knight-posix-binary >| ${TMPDIR}/optimized.out
+	[ 0 = $? ] || exit 3
+	${TMPDIR}/reference >| ${TMPDIR}/reference.out
+	[ 0 = $? ] || exit 3
+	cmp ${TMPDIR}/reference.out ${TMPDIR}/optimized.out || exit 4
+fi
+exit 0
@@ -0,0 +1,187 @@
+/* Copyright (C) 2026 agent
+ * This file is part of M2-Planet.
+ *
+ * M2-Planet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * M2-Planet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with M2-Planet.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+
+/* Built with -O1: every check here goes through a rewritten code path.
+ * report prints the same operations on values only known at run time, and
+ * run_test.sh compares what it prints with a build at -O0 */
+
+int table[8];
+
+int fold()
+{
+	if(14 != (2 + 3 * 4)) return 1;
+	if(-3 != (7 - 10)) return 2;
+	if(1 != !0) return 3;
+	if(-1 != ~0) return 4;
+	if(12 != (3 << 2)) return 5;
+	if(6 != (0x1E & 0x7)) return 6;
+	return 0;
+}
+
+int immediates(int a)
+{
+	if((a + 1000) != 1007) return 11;
+	if((a - 9) != -2) return 12;
+	if((a & 3) != 3) return 13;
+	if((a | 8) != 15) return 14;
+	if((a ^ 5) != 2) return 15;
+	if((a * 6) != 42) return 16;
+	if((a << 4) != 112) return 17;
+	if((-a >> 1) != -4) return 18;
+	if(!(a < 8)) return 19;
+	if(a <= 6) return 20;
+	if(a > 7) return 21;
+	if(!(a >= 7)) return 22;
+	return 0;
+}
+
+int powers(unsigned u, int s)
+{
+	if((u * 8) != 200) return 31;
+	if((u / 4) != 6) return 32;
+	if((u % 8) != 1) return 33;
+	if((s / 4) != -6) return 34;
+	if((s % 4) != -1) return 35;
+	if((s * 2) != -50) return 36;
+	return 0;
+}
+
+int pick(int i)
+{
+	switch(i)
+	{
+		case 0: return 5;
+		case 1: return 7;
+		case 2:
+		case 3: return 11;
+		case 5: return 13;
+		default: return -1;
+	}
+}
+
+int loops()
+{
+	int i;
+	int sum = 0;
+	for(i = 0; i < 8; i = i + 1) table[i] = i * i;
+	i = 8;
+	while(0 < i)
+	{
+		i = i - 1;
+		sum = sum + table[i];
+	}
+	if(140 != sum) return 41;
+
+	i = 0;
+	do
+	{
+		i = i + 3;
+	} while(i < 10);
+	if(12 != i) return 42;
+
+	if(5 != pick(0)) return 43;
+	if(11 != pick(3)) return 44;
+	if(13 != pick(5)) return 45;
+	if(-1 != pick(4)) return 46;
+	if(-1 != pick(-2)) return 47;
+	return 0;
+}
+
+/* Stores followed by loading the same slot back */
+int forward(int a)
+{
+	int x;
+	int y;
+	char c;
+	x = a * 3 + a;
+	if(x > 4) y = x - 4;
+	else y = x;
+	if(16 != y) return 51;
+	x = y;
+	c = x * 20;
+	/* Only a byte was stored, so this has to load it back */
+	if(64 != c) return 52;
+	return 0;
+}
+
+/* The only local is read back just before the return drops it */
+int last_local(int a)
+{
+	int s = a * 10 + 2;
+	return s;
+}
+
+void put_number(int n)
+{
+	char* digits = "0123456789";
+	if(0 > n)
+	{
+		fputc('-', stdout);
+		n = -n;
+	}
+	if(9 < n) put_number(n / 10);
+	fputc(digits[n % 10], stdout);
+}
+
+void show(int n)
+{
+	put_number(n);
+	fputc(' ', stdout);
+}
+
+void report()
+{
+	int i;
+	int j;
+	unsigned u;
+	for(i = -9; i < 40; i = i + 1)
+	{
+		u = i + 9;
+		show(i);
+		show((i + 1000) - (i * 6) + (i << 4) + (i >> 1));
+		show((i & 3) | (i ^ 5));
+		show(u * 8 + u / 4 + u % 8);
+		show(i * 2 + i / 4 + i % 4);
+		show(pick(i));
+		show((i < 8) + (i <= 6) * 2 + (i > 7) * 4 + (i >= 7) * 8);
+		if((0 < i) && (table[i & 7] > i)) show(table[i & 7]);
+		else show(-i);
+		j = i;
+		while(j > 3) j = j - 4;
+		put_number(j);
+		fputc('\n', stdout);
+	}
+}
+
+int main()
+{
+	int r = fold();
+	if(0 != r) return r;
+	r = immediates(7);
+	if(0 != r) return r;
+	r = powers(25, -25);
+	if(0 != r) return r;
+	r = forward(5);
+	if(0 != r) return r;
+	if(72 != last_local(7)) return 53;
+	r = loops();
+	if(0 != r) return r;
+	report();
+	return 0;
+}
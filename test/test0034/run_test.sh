@@ -0,0 +1,130 @@
+#! /bin/sh
+## Copyright (C) 2017 Jeremiah Orians
+## Copyright (C) 2020-2021 deesix <deesix@tuta.io>
+## This file is part of M2-Planet.
+##
+## M2-Planet is free software: you can redistribute it and/or modify
+## it under the terms of the GNU General Public License as published by
+## the Free Software Foundation, either version 3 of the License, or
+## (at your option) any later version.
+##
+## M2-Planet is distributed in the hope that it will be useful,
+## but WITHOUT ANY WARRANTY; without even the implied warranty of
+## MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+## GNU General Public License for more details.
+##
+## You should have received a copy of the GNU General Public License
+## along with M2-Planet.  If not, see <http://www.gnu.org/licenses/>.
+
+set -ex
+
+ARCH="$1"
+. test/env.inc.sh
+TMPDIR="test/test0034/tmp-${ARCH}"
+
+mkdir -p ${TMPDIR}
+
+# Build the test
+bin/M2-Planet \
+	--architecture ${ARCH} \
+	-O1 \
+	-f M2libc/sys/types.h \
+	-f M2libc/stddef.h \
+	-f M2libc/signal.h \
+	-f M2libc/sys/utsname.h \
+	-f M2libc/${ARCH}/linux/unistd.c \
+	-f M2libc/${ARCH}/linux/fcntl.c \
+	-f M2libc/fcntl.c \
+	-f M2libc/stdlib.c \
+	-f M2libc/stdio.h \
+	-f M2libc/stdio.c \
+	-f test/test0034/optimize.c \
+	--debug \
+	-o ${TMPDIR}/optimize.M1 \
+	|| exit 1
+
+# Build debug footer
+blood-elf \
+	${BLOOD_ELF_WORD_SIZE_FLAG} \
+	-f ${TMPDIR}/optimize.M1 \
+	${ENDIANNESS_FLAG} \
+	--entry _start \
+	-o ${TMPDIR}/optimize-footer.M1 \
+	|| exit 2
+
+# Macro assemble with libc written in M1-Macro
+M1 \
+	-f M2libc/${ARCH}/${ARCH}_defs.M1 \
+	-f M2libc/${ARCH}/libc-full.M1 \
+	-f ${TMPDIR}/optimize.M1 \
+	-f ${TMPDIR}/optimize-footer.M1 \
+	${ENDIANNESS_FLAG} \
+	--architecture ${ARCH} \
+	-o ${TMPDIR}/optimize.hex2 \
+	|| exit 2
+
+# Resolve all linkages
+hex2 \
+	-f M2libc/${ARCH}/ELF-${ARCH}-debug.hex2 \
+	-f ${TMPDIR}/optimize.hex2 \
+	${ENDIANNESS_FLAG} \
+	--architecture ${ARCH} \
+	--base-address ${BASE_ADDRESS} \
+	-o test/results/test0034-${ARCH}-binary \
+	|| exit 3
+
+# Build the same test at -O0 to compare against
+bin/M2-Planet \
+	--architecture ${ARCH} \
+	-O0 \
+	-f M2libc/sys/types.h \
+	-f M2libc/stddef.h \
+	-f M2libc/signal.h \
+	-f M2libc/sys/utsname.h \
+	-f M2libc/${ARCH}/linux/unistd.c \
+	-f M2libc/${ARCH}/linux/fcntl.c \
+	-f M2libc/fcntl.c \
+	-f M2libc/stdlib.c \
+	-f M2libc/stdio.h \
+	-f M2libc/stdio.c \
+	-f test/test0034/optimize.c \
+	--debug \
+	-o ${TMPDIR}/reference.M1 \
+	|| exit 1
+
+blood-elf \
+	${BLOOD_ELF_WORD_SIZE_FLAG} \
+	-f ${TMPDIR}/reference.M1 \
+	${ENDIANNESS_FLAG} \
+	--entry _start \
+	-o ${TMPDIR}/reference-footer.M1 \
+	|| exit 2
+
+M1 \
+	-f M2libc/${ARCH}/${ARCH}_defs.M1 \
+	-f M2libc/${ARCH}/libc-full.M1 \
+	-f ${TMPDIR}/reference.M1 \
+	-f ${TMPDIR}/reference-footer.M1 \
+	${ENDIANNESS_FLAG} \
+	--architecture ${ARCH} \
+	-o ${TMPDIR}/reference.hex2 \
+	|| exit 2
+
+hex2 \
+	-f M2libc/${ARCH}/ELF-${ARCH}-debug.hex2 \
+	-f ${TMPDIR}/reference.hex2 \
+	${ENDIANNESS_FLAG} \
+	--architecture ${ARCH} \
+	--base-address ${BASE_ADDRESS} \
+	-o ${TMPDIR}/reference \
+	|| exit 3
+
+# Ensure binary works if host machine supports test
+if [ "$(get_machine ${GET_MACHINE_FLAGS})" = "${ARCH}" ]
+then
+	# Verify that the resulting file works and prints what -O0 prints
+	./test/results/test0034-${ARCH}-binary >| ${TMPDIR}/optimized.out || exit 4
+	${TMPDIR}/reference >| ${TMPDIR}/reference.out || exit 4
+	cmp ${TMPDIR}/reference.out ${TMPDIR}/optimized.out || exit 5
+fi
+exit 0
@@ -0,0 +1,77 @@
+/* Copyright (C) 2026 agent
+ * This file is part of M2-Planet.
+ *
+ * M2-Planet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * M2-Planet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with M2-Planet.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+/* Built with -O1 --inline-limit 4: the short bodies are expanded in place */
+
+int counter;
+
+/* 3 tokens, within the limit */
+int twice(int x)
+{
+	return x + x;
+}
+
+/* No arguments, so no frame either */
+int seven()
+{
+	return 7;
+}
+
+/* 9 tokens, over the limit, so it stays a call */
+int blend(int x, int y)
+{
+	return x * y + x - y;
+}
+
+/* Over the limit, but asked for */
+inline int mix(int a, int b)
+{
+	return (a << 2) + b * 3 - a;
+}
+
+/* Expansions do not nest, the inner calls stay calls */
+inline int quad(int x)
+{
+	return twice(twice(x));
+}
+
+int bump()
+{
+	counter = counter + 1;
+	return counter;
+}
+
+int main()
+{
+	if(14 != twice(seven())) return 1;
+	if(29 != 1 + twice(2) * seven()) return 2;
+	if(18 != blend(5, 4) - 3) return 3;
+	if(21 != mix(3, 4)) return 4;
+	if(20 != quad(5)) return 5;
+
+	/* An argument with a side effect is still evaluated once */
+	counter = 0;
+	if(2 != twice(bump())) return 6;
+	if(1 != counter) return 7;
+	if(9 != mix(bump(), 1)) return 8;
+	if(2 != counter) return 9;
+
+	/* An expansion in the middle of pushed temporaries */
+	if(36 != (seven() + 2) * (twice(1) + mix(0, 1) - 1)) return 10;
+	return 0;
+}
@@ -0,0 +1,112 @@
+/* Copyright (C) 2026 agent
+ * This file is part of M2-Planet.
+ *
+ * M2-Planet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * M2-Planet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with M2-Planet.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+
+/* Built with -O1 --prune: everything main needs has to survive */
+
+int calls;
+int never_read;
+
+/* Nothing reaches these, so they are dropped along with never_read */
+int unused(int x)
+{
+	never_read = x;
+	return 99;
+}
+
+int unused_table(int i)
+{
+	switch(i)
+	{
+		case 0: return unused(1);
+		case 1: return unused(2);
+		case 2: return unused(3);
+		case 3: return unused(4);
+		default: return 0;
+	}
+}
+
+/* Only named in a comment, which is not a reference */
+int commented()
+{
+	return 98;
+}
+
+void remark()
+{
+	asm("# FUNCTION_commented is not called from here");
+}
+
+/* Only ever reached through their addresses */
+int square(int x)
+{
+	calls = calls + 1;
+	return x * x;
+}
+
+int cube(int x)
+{
+	calls = calls + 1;
+	return x * x * x;
+}
+
+int apply(FUNCTION f, int x)
+{
+	return f(x);
+}
+
+FUNCTION pick(int which)
+{
+	if(which) return cube;
+	return square;
+}
+
+/* Dense enough for a jump table, which lives with the globals */
+char* name(int i)
+{
+	switch(i)
+	{
+		case 1: return "one";
+		case 2: return "two";
+		case 3: return "three";
+		case 4: return "four";
+		case 5: return "five";
+		default: return "other";
+	}
+}
+
+int main()
+{
+	calls = 0;
+	remark();
+	if(49 != apply(square, 7)) return 1;
+	if(27 != apply(pick(1), 3)) return 2;
+	if(16 != apply(pick(0), 4)) return 3;
+	if(3 != calls) return 4;
+
+	char* s = name(1);
+	if('o' != s[0]) return 5;
+	s = name(3);
+	if('h' != s[1]) return 6;
+	s = name(5);
+	if('v' != s[2]) return 7;
+	s = name(6);
+	if('t' != s[1]) return 8;
+	s = name(-1);
+	if('t' != s[1]) return 9;
+	return 0;
+}
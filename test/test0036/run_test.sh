@@ -0,0 +1,100 @@
+#! /bin/sh
+## Copyright (C) 2017 Jeremiah Orians
+## Copyright (C) 2020-2021 deesix <deesix@tuta.io>
+## This file is part of M2-Planet.
+##
+## M2-Planet is free software: you can redistribute it and/or modify
+## it under the terms of the GNU General Public License as published by
+## the Free Software Foundation, either version 3 of the License, or
+## (at your option) any later version.
+##
+## M2-Planet is distributed in the hope that it will be useful,
+## but WITHOUT ANY WARRANTY; without even the implied warranty of
+## MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+## GNU General Public License for more details.
+##
+## You should have received a copy of the GNU General Public License
+## along with M2-Planet.  If not, see <http://www.gnu.org/licenses/>.
+
+set -ex
+
+ARCH="$1"
+. test/env.inc.sh
+TMPDIR="test/test0036/tmp-${ARCH}"
+
+mkdir -p ${TMPDIR}
+
+# Build the test
+bin/M2-Planet \
+	--architecture ${ARCH} \
+	-O1 \
+	--prune \
+	--keep __init_malloc \
+	--keep __init_io \
+	--keep __kill_io \
+	--keep __envp \
+	-f M2libc/sys/types.h \
+	-f M2libc/stddef.h \
+	-f M2libc/signal.h \
+	-f M2libc/sys/utsname.h \
+	-f M2libc/${ARCH}/linux/unistd.c \
+	-f M2libc/${ARCH}/linux/fcntl.c \
+	-f M2libc/fcntl.c \
+	-f M2libc/stdlib.c \
+	-f M2libc/stdio.h \
+	-f M2libc/stdio.c \
+	-f test/test0036/prune.c \
+	--debug \
+	-o ${TMPDIR}/prune.M1 \
+	|| exit 1
+
+# Build debug footer
+blood-elf \
+	${BLOOD_ELF_WORD_SIZE_FLAG} \
+	-f ${TMPDIR}/prune.M1 \
+	${ENDIANNESS_FLAG} \
+	--entry _start \
+	-o ${TMPDIR}/prune-footer.M1 \
+	|| exit 2
+
+# Only what main reaches was written out
+grep -q '^:FUNCTION_square$' ${TMPDIR}/prune.M1 || exit 5
+grep -q '^:FUNCTION_cube$' ${TMPDIR}/prune.M1 || exit 5
+grep -q '^:_SWITCH_TABLE_name_0$' ${TMPDIR}/prune.M1 || exit 5
+grep -q '^:_SWITCH_JUMPS_name_0$' ${TMPDIR}/prune.M1 || exit 5
+for dropped in FUNCTION_unused FUNCTION_unused_table FUNCTION_commented GLOBAL_never_read
+do
+	if grep -q "^:${dropped}\$" ${TMPDIR}/prune.M1
+	then
+		exit 5
+	fi
+done
+
+# Macro assemble with libc written in M1-Macro
+M1 \
+	-f M2libc/${ARCH}/${ARCH}_defs.M1 \
+	-f M2libc/${ARCH}/libc-full.M1 \
+	-f ${TMPDIR}/prune.M1 \
+	-f ${TMPDIR}/prune-footer.M1 \
+	${ENDIANNESS_FLAG} \
+	--architecture ${ARCH} \
+	-o ${TMPDIR}/prune.hex2 \
+	|| exit 2
+
+# Resolve all linkages
+hex2 \
+	-f M2libc/${ARCH}/ELF-${ARCH}-debug.hex2 \
+	-f ${TMPDIR}/prune.hex2 \
+	${ENDIANNESS_FLAG} \
+	--architecture ${ARCH} \
+	--base-address ${BASE_ADDRESS} \
+	-o test/results/test0036-${ARCH}-binary \
+	|| exit 3
+
+# Ensure binary works if host machine supports test
+if [ "$(get_machine ${GET_MACHINE_FLAGS})" = "${ARCH}" ]
+then
+	# Verify that the resulting file works
+	./test/results/test0036-${ARCH}-binary || exit 4
+fi
+exit 0
@@ -0,0 +1,115 @@
+/* Copyright (C) 2026 agent
+ * This file is part of M2-Planet.
+ *
+ * M2-Planet is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * M2-Planet is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with M2-Planet.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+
+/* Built with -O1 --register-arguments --inline-limit 0: calls to functions
+ * compiled further up pass their arguments in registers, everything else
+ * still goes through the stack */
+
+int later(int a, int b);
+
+void put_number(int n)
+{
+	char* digits = "0123456789";
+	if(0 > n)
+	{
+		fputc('-', stdout);
+		n = -n;
+	}
+	if(9 < n) put_number(n / 10);
+	fputc(digits[n % 10], stdout);
+}
+
+void show(char* name, int value)
+{
+	fputs(name, stdout);
+	fputs(" = ", stdout);
+	put_number(value);
+	fputc('\n', stdout);
+}
+
+int add3(int a, int b, int c)
+{
+	return a + b - c;
+}
+
+int six(int a, int b, int c, int d, int e, int f)
+{
+	int s = a * 100000 + b * 10000 + c * 1000 + d * 100 + e * 10 + f;
+	return s;
+}
+
+/* More arguments than amd64 has registers for */
+int seven(int a, int b, int c, int d, int e, int f, int g)
+{
+	return six(a, b, c, d, e, f) * 10 + g;
+}
+
+/* More arguments than any target has registers for */
+int nine(int a, int b, int c, int d, int e, int f, int g, int h, int i)
+{
+	return seven(a, b, c, d, e, f, g) * 100 + h * 10 + i;
+}
+
+int fact(int n)
+{
+	if(n < 2) return 1;
+	return n * fact(n - 1);
+}
+
+/* Arguments are still in memory, so their address can be taken */
+int swap_sum(int a, int b)
+{
+	int* p = &a;
+	int t = p[0];
+	a = b;
+	b = t;
+	return a * 10 + b;
+}
+
+int noargs()
+{
+	return add3(1, 2, 3) + 5;
+}
+
+int apply(FUNCTION f, int x)
+{
+	return f(x);
+}
+
+int main()
+{
+	int x = 4;
+	show("add3", add3(x, 2, add3(1, x, 3)));
+	show("six", six(1, 2, 3, 4, 5, 6));
+	show("seven", seven(1, 2, 3, 4, 5, 6, 7));
+	show("nine", nine(1, 0, 2, 0, 3, 0, 4, 5, 6));
+	show("fact", fact(7));
+	show("nested", six(0, 0, 0, add3(1, 0, 0), fact(2), fact(0)));
+	show("noargs", add3(noargs(), fact(3), 6));
+	show("swap", swap_sum(3, 8));
+	show("pointer", apply(fact, 5));
+	/* Forward calls use the stack, their arguments can hold register calls */
+	show("later", later(add3(x, x, 1), fact(4)));
+	return 0;
+}
+
+int later(int a, int b)
+{
+	return add3(a, b, 2) * 2;
+}